@@ -0,0 +1,129 @@
+#!/usr/bin/python3
+# Writes the binary event gallery read by MysteryGift::init.
+#
+# Layout (all values little endian):
+#   header   "PKMG", u32 version, u32 entryCount, u32 matchCount,
+#            u32 entryOffset, u32 matchOffset, u32 stringOffset, u32 dataOffset,
+#            u32 tokenCount, u32 tokenOffset, u32 postingOffset
+#   entries  entryCount fixed-width records:
+#            u32 offset, u16 size, s16 species, s8 form, u8 type, u8 language,
+#            u8 padding, u32 name, u32 game (name and game are string table offsets)
+#   matches  matchCount records: u16 languageMask, u16 index[10]
+#            (index is by Language - 1, 0xFFFF when missing)
+#   tokens   tokenCount search tokens sorted by their bytes: u32 string, u32 first, u32 count
+#            (first and count select the token's run of postings)
+#   postings u16 match indices, ascending within each token
+#   strings  NUL-terminated UTF-8 strings
+#   data     the raw wondercards, addressed by entry offset
+import json
+import struct
+import sys
+
+MAGIC = b'PKMG'
+VERSION = 2
+
+HEADER = struct.Struct('<4s10I')
+ENTRY = struct.Struct('<IHhbBBxII')
+MATCH = struct.Struct('<H10H')
+TOKEN = struct.Struct('<3I')
+
+# Must match MysteryGift::CardType
+types = ["wc4", "pgt", "pgf", "wc6", "wc6full", "wc7", "wc7full", "wb7", "wb7full"]
+# Must match the Language enum, starting at JP = 1
+languages = ["JPN", "ENG", "FRE", "ITA", "GER", "UNUSED", "SPA", "KOR", "CHS", "CHT"]
+
+# StringUtils::toLower only folds ASCII and these accented capitals, so nothing else may be folded here either
+accented = {c: c.lower() for c in 'ÍÓÚÉÁÌÒÙÈÀÑÆ'}
+
+def lower(value):
+	return ''.join(c.lower() if ord(c) < 0x80 else accented.get(c, c) for c in value)
+
+# Same rules as MysteryGift::tokenize: ASCII punctuation and spaces split, everything else is kept
+def tokenize(value):
+	tokens = []
+	token = ''
+	for c in lower(value):
+		if ord(c) < 0x80 and not c.isalnum():
+			if token:
+				tokens.append(token)
+			token = ''
+		else:
+			token += c
+	if token:
+		tokens.append(token)
+	# card IDs are zero padded in names, so also allow searching them without the padding
+	for token in list(tokens):
+		if token.isdigit() and token.lstrip('0') and token.lstrip('0') != token:
+			tokens.append(token.lstrip('0'))
+	return tokens
+
+def align(data, alignment):
+	return data + b'\0' * (-len(data) % alignment)
+
+def pack(sheet, data):
+	strings = b''
+	stringIds = {}
+	def string(value):
+		nonlocal strings
+		if value not in stringIds:
+			stringIds[value] = len(strings)
+			strings += value.encode('utf-8') + b'\0'
+		return stringIds[value]
+
+	entryLanguages = [None] * len(sheet['wondercards'])
+	for match in sheet['matches']:
+		for lang, index in match.items():
+			entryLanguages[index] = lang
+
+	entries = b''
+	for i, entry in enumerate(sheet['wondercards']):
+		lang = entryLanguages[i] if entryLanguages[i] is not None else "ENG"
+		entries += ENTRY.pack(entry['offset'], entry['size'], entry['species'], entry['form'],
+			types.index(entry['type']), languages.index(lang) + 1, string(entry['name']), string(entry['game']))
+
+	matches = b''
+	for match in sheet['matches']:
+		mask = 0
+		indices = [0xFFFF] * len(languages)
+		for lang, index in match.items():
+			mask |= 1 << (languages.index(lang) + 1)
+			indices[languages.index(lang)] = index
+		matches += MATCH.pack(mask, *indices)
+
+	index = {}
+	for i, match in enumerate(sheet['matches']):
+		for entryIndex in match.values():
+			entry = sheet['wondercards'][entryIndex]
+			for token in tokenize(entry['name']) + tokenize(entry['game']):
+				index.setdefault(token, set()).add(i)
+
+	tokens = b''
+	postings = b''
+	postingCount = 0
+	for token in sorted(index.keys(), key=lambda t: t.encode('utf-8')):
+		found = sorted(index[token])
+		tokens += TOKEN.pack(string(token), postingCount, len(found))
+		postings += struct.pack('<{}H'.format(len(found)), *found)
+		postingCount += len(found)
+
+	entryOffset = HEADER.size
+	matchOffset = entryOffset + len(entries)
+	tokenOffset = matchOffset + len(align(matches, 4))
+	postingOffset = tokenOffset + len(tokens)
+	stringOffset = postingOffset + len(align(postings, 4))
+	dataOffset = stringOffset + len(align(strings, 4))
+	header = HEADER.pack(MAGIC, VERSION, len(sheet['wondercards']), len(sheet['matches']),
+		entryOffset, matchOffset, stringOffset, dataOffset, len(index), tokenOffset, postingOffset)
+
+	return header + entries + align(matches, 4) + tokens + align(postings, 4) + align(strings, 4) + data
+
+if __name__ == '__main__':
+	if len(sys.argv) != 4:
+		print("Usage: gallery.py sheet.json data.bin gallery.bin")
+		sys.exit(1)
+	with open(sys.argv[1], 'r') as f:
+		sheet = json.load(f)
+	with open(sys.argv[2], 'rb') as f:
+		data = f.read()
+	with open(sys.argv[3], 'wb') as f:
+		f.write(pack(sheet, data))
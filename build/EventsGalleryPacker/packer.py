@@ -1,9 +1,9 @@
 #!/usr/bin/python3
 import git
 import os
-import json
 import struct
 import gen4string
+import gallery
 
 validLangs = ["CHS", "CHT", "ENG", "FRE", "GER", "ITA", "JPN", "KOR", "SPA"]
 validTypes = ["wc7", "wc6", "wc7full", "wc6full", "pgf", "wc4", "pgt"]
@@ -239,11 +239,6 @@ for gen in range (4, 7+1):
 		sheet['matches'][i] = temp
 		sheet['matches'][i]
 		
-	# export sheet
-	sheet_data = json.dumps(sheet)
-	with open("./out/sheet{}.json".format(gen), 'w') as f:
-		f.write(sheet_data)
-
-	# export data
-	with open("./out/data{}.bin".format(gen), 'wb') as f:
-		f.write(data)	
+	# export the binary gallery (index, strings and data in one file)
+	with open("./out/gallery{}.bin".format(gen), 'wb') as f:
+		f.write(gallery.pack(sheet, data))
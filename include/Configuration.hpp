@@ -28,6 +28,7 @@
 #define CONFIGURATION_HPP
 
 #include <3ds.h>
+#include <map>
 #include "json.hpp"
 #include "i18n.hpp"
 #include "utils.hpp"
@@ -35,7 +36,7 @@
 class Configuration
 {
 public:
-    static constexpr int CURRENT_VERSION = 4;
+    static constexpr int CURRENT_VERSION = 5;
 
     static Configuration& getInstance(void)
     {
@@ -45,62 +46,62 @@ public:
 
     Language language(void) const
     {
-        return mJson["language"];
+        return (Language) mSettings.language;
     }
 
     bool autoBackup(void) const
     {
-        return mJson["autoBackup"];
+        return mSettings.autoBackup;
     }
 
     int storageSize(void) const
     {
-        return mJson["storageSize"];
+        return mSettings.storageSize;
     }
 
     bool transferEdit(void) const
     {
-        return mJson["transferEdit"];
+        return mSettings.transferEdit;
     }
 
     bool useExtData(void) const
     {
-        return mJson["useExtData"];
+        return mSettings.useExtData;
     }
 
     u32 defaultTID(void) const
     {
-        return mJson["defaults"]["pid"];
+        return mSettings.defaultTID;
     }
 
     u32 defaultSID(void) const
     {
-        return mJson["defaults"]["sid"];
+        return mSettings.defaultSID;
     }
 
     std::string defaultOT(void) const
     {
-        return mJson["defaults"]["ot"];
+        return mDefaultOT;
     }
 
     int nationality(void) const
     {
-        return mJson["defaults"]["nationality"];
+        return mSettings.nationality;
     }
 
     int day(void)
     {
-        return mJson["defaults"]["date"]["day"];
+        return mSettings.day;
     }
     
     int month(void)
     {
-        return mJson["defaults"]["date"]["month"];
+        return mSettings.month;
     }
 
     int year(void)
     {
-        return mJson["defaults"]["date"]["year"];
+        return mSettings.year;
     }
 
     // Folders, then files
@@ -108,87 +109,100 @@ public:
 
     bool writeFileSave(void)
     {
-        return mJson["writeFileSave"];
+        return mSettings.writeFileSave;
     }
 
     bool useSaveInfo(void)
     {
-        return mJson["useSaveInfo"];
+        return mSettings.useSaveInfo;
     }
 
     bool randomMusic(void)
     {
-        return mJson["randomMusic"];
+        return mSettings.randomMusic;
+    }
+
+    // how many backups of each save, the bank and bridge sessions are kept, 0 keeping all of them
+    int backupsToKeep(void) const
+    {
+        return mSettings.backupsToKeep;
+    }
+
+    // Whether config.json was written by a newer PKSM. It's loaded at startup before the GUI exists, so the
+    // warning is left to the caller
+    bool newerVersion(void) const
+    {
+        return mNewerVersion;
     }
 
     int defaultRegion(void)
     {
-        return mJson["defaults"]["region"];
+        return mSettings.defaultRegion;
     }
 
     int defaultCountry(void)
     {
-        return mJson["defaults"]["country"];
+        return mSettings.defaultCountry;
     }
 
     void language(Language lang)
     {
-        mJson["language"] = lang;
+        mSettings.language = lang;
     }
 
     void autoBackup(bool backup)
     {
-        mJson["autoBackup"] = backup;
+        mSettings.autoBackup = backup;
     }
 
     void storageSize(int size)
     {
-        mJson["storageSize"] = size;
+        mSettings.storageSize = size;
     }
 
     void transferEdit(bool edit)
     {
-        mJson["transferEdit"] = edit;
+        mSettings.transferEdit = edit;
     }
 
     void useExtData(bool use)
     {
-        mJson["useExtData"] = use;
+        mSettings.useExtData = use;
     }
 
     void defaultTID(u32 pid)
     {
-        mJson["defaults"]["pid"] = pid;
+        mSettings.defaultTID = pid;
     }
 
     void defaultSID(u32 sid)
     {
-        mJson["defaults"]["sid"] = sid;
+        mSettings.defaultSID = sid;
     }
 
     void defaultOT(std::string ot)
     {
-        mJson["defaults"]["ot"] = ot;
+        mDefaultOT = ot;
     }
 
     void nationality(int nation)
     {
-        mJson["defaults"]["nationality"] = nation;
+        mSettings.nationality = nation;
     }
 
     void day(int day)
     {
-        mJson["defaults"]["date"]["day"] = day;
+        mSettings.day = day;
     }
     
     void month(int month)
     {
-        mJson["defaults"]["date"]["month"] = month;
+        mSettings.month = month;
     }
 
     void year(int year)
     {
-        mJson["defaults"]["date"]["year"] = year;
+        mSettings.year = year;
     }
 
     // This assumes that we'll have a way to set them in the config screen, something that I'm not sure about
@@ -198,30 +212,39 @@ public:
 
     void writeFileSave(bool write)
     {
-        mJson["writeFileSave"] = write;
+        mSettings.writeFileSave = write;
     }
 
     void useSaveInfo(bool saveInfo)
     {
-        mJson["useSaveInfo"] = saveInfo;
+        mSettings.useSaveInfo = saveInfo;
     }
 
     void randomMusic(bool random)
     {
-        mJson["randomMusic"] = random;
+        mSettings.randomMusic = random;
+    }
+
+    void backupsToKeep(int keep)
+    {
+        mSettings.backupsToKeep = keep;
     }
 
     void defaultRegion(u8 value)
     {
-        mJson["defaults"]["region"] = value;
+        mSettings.defaultRegion = value;
     }
 
     void defaultCountry(u8 value)
     {
-        mJson["defaults"]["country"] = value;
+        mSettings.defaultCountry = value;
     }
 
+    // Asks for the configuration to be written. Requests are batched up and written by flush
     void save(void);
+    // Writes the configuration if it's been asked for and nothing has changed for a moment, or straight away if
+    // force is set. Called every frame
+    void flush(bool force = false);
 
 private:
     Configuration(void);
@@ -231,10 +254,48 @@ private:
     void operator=(Configuration const&) = delete;
 
     void loadFromRomfs(void);
-
+    void loadFromJson(void);
+    bool loadSnapshot(u32 jsonCrc);
+    void writeSnapshot(u32 jsonCrc);
+    void write(void);
+
+    // Every setting with a getter, so reading one doesn't need a JSON lookup. Also the layout of the binary
+    // snapshot, which is read at startup instead of parsing config.json when that hasn't changed
+    struct Settings
+    {
+        int version;
+        int language;
+        int storageSize;
+        u32 defaultTID;
+        u32 defaultSID;
+        int nationality;
+        int day;
+        int month;
+        int year;
+        int defaultRegion;
+        int defaultCountry;
+        int backupsToKeep;
+        bool autoBackup;
+        bool transferEdit;
+        bool useExtData;
+        bool writeFileSave;
+        bool useSaveInfo;
+        bool randomMusic;
+    };
+
+    Settings mSettings;
+    std::string mDefaultOT;
+    std::map<std::string, std::pair<std::vector<std::string>, std::vector<std::string>>> mExtraSaves;
+
+    // The file as it was read, brought up to date when it's written so anything unknown to this version survives.
+    // Only parsed when that's needed
+    std::string mJsonText;
     nlohmann::json mJson;
+    bool mJsonParsed = false;
 
-    size_t oldSize = 0;
+    bool mDirty = false;
+    u64 mSaveRequested = 0;
+    bool mNewerVersion = false;
 };
 
-#endif
\ No newline at end of file
+#endif
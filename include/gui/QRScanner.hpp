@@ -28,22 +28,43 @@
 #define QRSCANNER_HPP
 
 #include "gui.hpp"
+#include "tripleBuffer.hpp"
 
 extern "C" {
 #include "quirc/quirc.h"
 #include "base64.h"
+#include "grayscale.h"
 }
 
-typedef struct {
-    u16*          camera_buffer;
-    Handle        mutex;
-    volatile bool finished;
+// Frames go through three stages, each on its own thread: camThread captures them, procThread converts
+// them to grayscale for quirc and tiles them for the preview, and the thread which called QRScanner::init
+// identifies and decodes. uiThread draws the newest preview. A stage which falls behind skips frames.
+// Capture and drawing run on the system core, conversion and decoding on the app core.
+struct qr_data
+{
+    qr_data(void);
+    ~qr_data(void);
+
+    u16*          frameBuffers[3];
+    u8*           grayBuffers[3];
+    u16*          previewBuffers[3];
+    TripleBuffer  frames;   // camThread to procThread
+    TripleBuffer  grays;    // procThread to the decoder
+    TripleBuffer  previews; // procThread to uiThread
     Handle        cancel;
-    bool          capturing;
+    Handle        frameReady;
+    Handle        grayReady;
+    volatile bool finished;
+    Thread        threads[3];
+    int           roiX, roiY, roiW, roiH; // around the codes last found, roiW is 0 when there were none
+    int           framesSinceFullScan;
+    int           batchFramesLeft;
+    std::vector<std::vector<u8>> batch;   // Pokemon collected from a sheet of codes
+    std::vector<std::vector<u8>> copies;  // whole codes which ask for several copies of a Pokemon
     struct quirc* context;
     C3D_Tex*      tex;
     C2D_Image     image;
-} qr_data;
+};
 
 enum QRMode {
     PKM4,
@@ -40,6 +40,7 @@
 #include "PKX.hpp"
 #include "Sav.hpp"
 #include "thread.hpp"
+#include "textLayout.hpp"
 
 #include "ui_sheet.h"
 #include "pkm_spritesheet.h"
@@ -104,12 +105,6 @@
 #define FONT_SIZE_11 0.46f
 #define FONT_SIZE_9 0.37f
 
-enum class TextPosX
-{
-    LEFT,
-    CENTER,
-    RIGHT
-};
 enum class TextPosY
 {
     TOP,
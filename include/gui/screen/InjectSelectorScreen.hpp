@@ -45,9 +45,14 @@ public:
     ScreenType type() const override { return ScreenType::EVENTS; }
 private:
     bool doQR(void);
+    void searchBar(void);
+    void injectAll(void);
     HidHorizontal hid;
-    std::vector<nlohmann::json> wondercards;
+    // Event indices currently shown, in search rank order
+    std::vector<size_t> wondercards;
     std::vector<Button*> buttons;
+    std::string searchString = "";
+    std::string oldSearchString = "";
 
     bool dump = false;
     bool updateGifts = false;
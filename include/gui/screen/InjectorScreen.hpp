@@ -39,7 +39,7 @@
 class InjectorScreen : public Screen
 {
 public:
-    InjectorScreen(nlohmann::json ids);
+    InjectorScreen(size_t match);
     InjectorScreen(std::unique_ptr<WCX> card);
     ~InjectorScreen()
     {
@@ -51,6 +51,8 @@ public:
     void update(touchPosition* touch) override;
     void draw(void) const override;
     ScreenType type() const override { return ScreenType::INJECTOR; }
+    // Sets the card's received date to today
+    static void changeDate(WCX& wc);
 private:
     std::vector<Button*> buttons;
     std::unique_ptr<WCX> wondercard;
@@ -63,7 +65,8 @@ private:
     int item = 0;
     HidHorizontal hid;
     Language lang = Language::JP;
-    nlohmann::json ids;
+    // Gallery event the card was chosen from, or MysteryGift::wondercards() for QR cards
+    size_t match;
     const int emptySlot;
     const std::vector<MysteryGift::giftData> gifts;
 
@@ -68,6 +68,7 @@ private:
     int saveGroup = 0;
     // Has to be mutable because no const operator[]
     mutable std::unordered_map<int, std::vector<std::pair<std::string, std::string>>> saves;
+    u32 savesVersion = 0;
     int firstSave = 0;
     std::vector<Button*> buttons;
     int selectedSave = -1;
@@ -92,6 +93,7 @@ private:
     static constexpr std::string_view titleName(int index);
 
     bool loadSave(void);
+    void loadSaves(void);
 };
 
 #endif
\ No newline at end of file
@@ -60,6 +60,8 @@ public:
 private:
     int selectedTitle = -2;
     std::vector<std::string> availableCheckpointSaves;
+    std::string savesPrefix;
+    u32 savesVersion = 0;
     int firstSave = -1;
     std::vector<Button*> buttons;
     int selectedSave = -1;
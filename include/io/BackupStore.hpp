@@ -0,0 +1,58 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef BACKUPSTORE_HPP
+#define BACKUPSTORE_HPP
+
+#include <3ds.h>
+#include <string>
+
+// Deduplicated backups. Every snapshot is split into fixed size chunks which are stored once each, compressed
+// and named by their SHA-256, under /3ds/PKSM/backups/store/chunks. A snapshot itself is only a manifest,
+// /3ds/PKSM/backups/store/snapshots/<name>/<timestamp>.bkp, listing its chunks, so a backup costs little more
+// than the parts of the file which changed since the last one. Names are escaped before they become folders.
+namespace BackupStore
+{
+    // PKSM's own snapshots. Any other name is escaped, so a save can never share one of these
+    extern const std::string BANK;
+    extern const std::string BANK_NAMES;
+    extern const std::string BRIDGE;
+
+    // stores data as a new snapshot of name, unless it's identical to the newest one, then drops all but the
+    // configured number of snapshots of name (0 keeps them all). Their chunks are only deleted every so often,
+    // or by prune
+    bool backup(const std::string& name, const std::string& fileName, const u8* data, size_t size);
+    // how many snapshots of name there are
+    size_t count(const std::string& name);
+    // writes snapshot index of name, 0 being the newest, to path. If path ends in '/' the file name the
+    // snapshot was taken with is appended
+    bool restore(const std::string& name, size_t index, const std::string& path);
+    // deletes all but the newest keep snapshots of name, then any chunk no snapshot refers to. Returns how many
+    // chunks were deleted
+    size_t prune(const std::string& name, size_t keep);
+}
+
+#endif
@@ -107,6 +107,9 @@ u32 SPIGetPageSize(CardType type);
 u32 SPIGetCapacity(CardType type);
 
 Result SPIWriteSaveData(CardType type, u32 offset, void* data, u32 size);
+// Writes only the pages of data which differ from shadow, what the chip is known to hold, and updates shadow to
+// match. progress, if given, is told how many of the changed bytes have been written
+Result SPIWriteChangedSaveData(CardType type, void* data, u8* shadow, u32 size, void (*progress)(u32 done, u32 total));
 Result SPIReadSaveData(CardType type, u32 offset, void* data, u32 size);
 
 Result SPIEraseSector(CardType type, u32 offset);
@@ -27,14 +27,13 @@
 #ifndef MYSTERYGIFT_HPP
 #define MYSTERYGIFT_HPP
 
-#include <fstream>
 #include "WB7.hpp"
 #include "WC7.hpp"
 #include "WC6.hpp"
 #include "PGF.hpp"
 #include "PGT.hpp"
 #include "WC4.hpp"
-#include "json.hpp"
+#include "i18n.hpp"
 #include "utils.hpp"
 
 namespace MysteryGift
@@ -45,11 +44,39 @@ namespace MysteryGift
         int species;
         int form;
     };
+
+    // Card formats stored in the binary gallery. Must match build/EventsGalleryPacker/gallery.py
+    enum class CardType : u8
+    {
+        WC4,
+        PGT,
+        PGF,
+        WC6,
+        WC6FULL,
+        WC7,
+        WC7FULL,
+        WB7,
+        WB7FULL
+    };
+
+    // wondercardIndex's answer for an event without any card
+    static constexpr size_t NO_CARD = 0xFFFF;
+
     void init(Generation gen);
-    std::vector<nlohmann::json> wondercards();
+    // Number of distinct events, each one holding a card per available language
+    size_t wondercards();
+    // Index of the event's card in the given language, falling back to the first available one. NO_CARD when
+    // there isn't one or match is out of range; wondercard, wondercardInfo and wondercardLanguage accept it
+    size_t wondercardIndex(size_t match, Language lang);
+    bool wondercardAvailable(size_t match, Language lang);
+    Language wondercardLanguage(size_t index);
     MysteryGift::giftData wondercardInfo(size_t index);
     std::unique_ptr<WCX> wondercard(size_t index);
+    // Events matching every word of the query, best matches first. Words are prefix matched against
+    // event names, games and species names; "game:", "lang:", "form:" and "type:item"/"type:pkm" words
+    // filter on card attributes instead. Queries extending the previous one only re-rank its results.
+    std::vector<size_t> search(const std::string& query);
     void exit();
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -243,7 +243,11 @@ struct TableEntry
             struct Value *Val;      /* the value we're storing */
         } v;                        /* used for tables of values */
         
-        char Key[1];                /* dummy size - used for the shared string table */
+        struct StringEntry          /* used for the shared string table */
+        {
+            int Len;                /* length of Key, which can have '\0's of its own */
+            char Key[1];            /* dummy size */
+        } s;
         
         struct BreakpointEntry      /* defines a breakpoint */
         {
@@ -259,6 +263,8 @@ struct Table
 {
     short Size;
     short OnHeap;
+    short Grown;                    /* true if HashTable was allocated by TableGrow() */
+    int Count;                      /* number of entries */
     struct TableEntry **HashTable;
 };
 
@@ -357,6 +363,9 @@ struct IncludeLibrary
 #define FREELIST_BUCKETS 8                          /* freelists for 4, 8, 12 ... 32 byte allocs */
 #define SPLIT_MEM_THRESHOLD 16                      /* don't split memory which is close in size */
 #define BREAKPOINT_TABLE_SIZE 21
+#define PROFILE_TABLE_SIZE 251
+
+struct ProfileEntry;
 
 
 /* the entire state of the picoc system */
@@ -387,6 +396,9 @@ struct Picoc_Struct
     /* the value passed to exit() */
     int PicocExitValue;
 
+    /* functions called so far, which tells a scan that only declares from one that runs code */
+    int FunctionCalls;
+
     /* a list of libraries we can include */
     struct IncludeLibrary *IncludeLibList;
 
@@ -444,6 +456,16 @@ struct Picoc_Struct
     int BreakpointCount;
     int DebugManualBreak;
     
+#ifdef PICOC_PROFILE
+    /* profiler */
+    struct ProfileEntry *ProfileHashTable[PROFILE_TABLE_SIZE];
+    struct ProfileEntry *ProfileCurrent;    /* the stack the running statement is charged to */
+    unsigned long long ProfileLastTime;
+    long ProfileHeapInUse;
+    long ProfileHeapHighWater;
+    long ProfileStackHighWater;
+#endif
+
     /* C library */
     int BigEndian;
     int LittleEndian;
@@ -472,17 +494,21 @@ struct Picoc_Struct
 void TableInit(Picoc *pc);
 char *TableStrRegister(Picoc *pc, const char *Str);
 char *TableStrRegister2(Picoc *pc, const char *Str, int Len);
+int TableStrLen(const char *Str);
 void TableInitTable(struct Table *Tbl, struct TableEntry **HashTable, int Size, int OnHeap);
 int TableSet(Picoc *pc, struct Table *Tbl, char *Key, struct Value *Val, const char *DeclFileName, int DeclLine, int DeclColumn);
 int TableGet(struct Table *Tbl, const char *Key, struct Value **Val, const char **DeclFileName, int *DeclLine, int *DeclColumn);
 struct Value *TableDelete(Picoc *pc, struct Table *Tbl, const char *Key);
 char *TableSetIdentifier(Picoc *pc, struct Table *Tbl, const char *Ident, int IdentLen);
 void TableStrFree(Picoc *pc);
+void TableFreeHashTable(Picoc *pc, struct Table *Tbl);
 
 /* lex.c */
 void LexInit(Picoc *pc);
 void LexCleanup(Picoc *pc);
 void *LexAnalyse(Picoc *pc, const char *FileName, const char *Source, int SourceLen, int *TokenLen);
+void *LexTokensSave(Picoc *pc, const void *Tokens, int TokenLen);
+void *LexTokensRestore(Picoc *pc, const void *Saved);
 void LexInitParser(struct ParseState *Parser, Picoc *pc, const char *SourceText, void *TokenSource, char *FileName, int RunIt, int SetDebugMode);
 enum LexToken LexGetToken(struct ParseState *Parser, struct Value **Value, int IncPos);
 enum LexToken LexRawPeekToken(struct ParseState *Parser);
@@ -614,6 +640,17 @@ void DebugInit();
 void DebugCleanup();
 void DebugCheckStatement(struct ParseState *Parser);
 
+/* profile.c */
+#ifdef PICOC_PROFILE
+void ProfileInit(Picoc *pc);
+void ProfileCleanup(Picoc *pc);
+void ProfileStatement(struct ParseState *Parser);
+void ProfileNativeBegin(Picoc *pc);
+void ProfileNativeEnd(struct ParseState *Parser, const char *FuncName);
+void ProfileHeapAlloc(Picoc *pc, int Size);
+void ProfileHeapFree(Picoc *pc, int Size);
+void ProfileStackUsed(Picoc *pc, long Size);
+#endif
 
 /* stdio.c */
 extern const char StdioDefs[];
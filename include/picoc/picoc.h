@@ -35,6 +35,7 @@ extern int PicocExitBuf[];
 
 /* parse.c */
 void PicocParse(Picoc *pc, const char *FileName, const char *Source, int SourceLen, int RunIt, int CleanupNow, int CleanupSource, int EnableDebugger);
+void PicocParseTokens(Picoc *pc, const char *FileName, const char *Source, void *Tokens, int RunIt, int CleanupNow, int CleanupSource, int EnableDebugger);
 void PicocParseInteractive(Picoc *pc);
 
 /* platform.c */
@@ -43,6 +44,16 @@ void PicocInitialise(Picoc *pc, int StackSize);
 void PicocCleanup(Picoc *pc);
 void PicocPlatformScanFile(Picoc *pc, const char *FileName);
 
+/* platform_unix.c */
+int PicocPlatformPrepareFile(Picoc *pc, const char *FileName, int StackSize);
+void PicocPlatformRunFile(Picoc *pc, const char *FileName, int argc, char **argv);
+void PicocPlatformReleaseFile(Picoc *pc);
+
+#ifdef PICOC_PROFILE
+/* profile.c */
+void PicocProfileWrite(Picoc *pc, const char *StacksFileName, const char *SummaryFileName);
+#endif
+
 /* include.c */
 void PicocIncludeAllSystemHeaders(Picoc *pc);
 
@@ -56,10 +56,17 @@ void sav_gbo(struct ParseState*, struct Value*, struct Value**, int);
 void sav_boxEncrypt(struct ParseState*, struct Value*, struct Value**, int);
 void sav_boxDecrypt(struct ParseState*, struct Value*, struct Value**, int);
 void sav_get_pkx(struct ParseState*, struct Value*, struct Value**, int);
+void sav_get_pkx_range(struct ParseState*, struct Value*, struct Value**, int);
+void sav_find_slots(struct ParseState*, struct Value*, struct Value**, int);
+void sav_box_data(struct ParseState*, struct Value*, struct Value**, int);
 void sav_inject_pkx(struct ParseState*, struct Value*, struct Value**, int);
+void sav_inject_pkx_range(struct ParseState*, struct Value*, struct Value**, int);
 void sav_inject_ekx(struct ParseState*, struct Value*, struct Value**, int);
 void current_directory(struct ParseState*, struct Value*, struct Value**, int);
 void read_directory(struct ParseState*, struct Value*, struct Value**, int);
+void backup_count(struct ParseState*, struct Value*, struct Value**, int);
+void backup_restore(struct ParseState*, struct Value*, struct Value**, int);
+void backup_prune(struct ParseState*, struct Value*, struct Value**, int);
 void i18n_species(struct ParseState*, struct Value*, struct Value**, int);
 
 #endif
@@ -27,6 +27,8 @@
 #define LINEBUFFER_MAX 256                  /* maximum number of characters on a line */
 #define LOCAL_TABLE_SIZE 11                 /* size of local variable table (can expand) */
 #define STRUCT_TABLE_SIZE 11                /* size of struct/union member table (can expand) */
+#define TABLE_MAX_LOAD 2                    /* grow heap tables with more entries per bucket than this */
+#define LOCAL_ON_HEAP_MIN 1024              /* local variables at least this big are kept on the heap, not the stack */
 
 #define INTERACTIVE_PROMPT_START "starting picoc " PICOC_VERSION "\n"
 #define INTERACTIVE_PROMPT_STATEMENT "picoc> "
@@ -40,6 +42,8 @@
 # include <stdlib.h>
 # include <ctype.h>
 # include <string.h>
+# include <stddef.h>
+# include <stdint.h>
 # include <assert.h>
 # include <sys/types.h>
 # include <sys/stat.h>
@@ -52,6 +52,12 @@ int quirc_resize(struct quirc *q, int w, int h);
 uint8_t *quirc_begin(struct quirc *q, int *w, int *h);
 void quirc_end(struct quirc *q);
 
+/* Like quirc_end(), but only looks for codes inside the given rectangle
+ * of the image, which is much quicker when it's small. The rectangle is
+ * clipped to the image, and an empty one searches the whole image.
+ */
+void quirc_end_roi(struct quirc *q, int x, int y, int w, int h);
+
 /* This structure describes a location in the input image buffer. */
 struct quirc_point {
 	int	x;
@@ -27,6 +27,7 @@
 #ifndef SAV_HPP
 #define SAV_HPP
 
+#include <array>
 #include <memory>
 #include <stdint.h>
 #include "PKX.hpp"
@@ -57,6 +58,17 @@ enum Pouch
     ZCrystals
 };
 
+// which game a DS save belongs to
+enum class DSSaveType
+{
+    NONE,
+    BW,
+    B2W2,
+    DP,
+    PT,
+    HGSS
+};
+
 typedef uint8_t u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
@@ -117,7 +129,12 @@ public:
     virtual ~Sav();
     virtual void resign(void) = 0;
 
+    // the offset and length of every part of a DS save dsSaveType looks at, so a card can be identified
+    // without reading all of it
+    static const std::array<std::pair<u32, u32>, 8> dsProbeRegions;
+    static DSSaveType dsSaveType(u8* dt);
     static bool isValidDSSave(u8* dt);
+    static std::unique_ptr<Sav> getDSSave(u8* dt, DSSaveType type);
     static std::unique_ptr<Sav> getSave(u8* dt, size_t length);
 
     virtual u16 TID(void) const = 0;
@@ -165,7 +182,12 @@ public:
     virtual std::vector<MysteryGift::giftData> currentGifts(void) const = 0;
     virtual std::unique_ptr<WCX> mysteryGift(int pos) const = 0;
     virtual void mysteryGift(WCX& wc, int& pos) = 0;
+    // Injects the cards into consecutive free gift slots, planning the slots once for the whole batch.
+    // Stops when the gift area is full and returns how many cards were injected
+    virtual size_t mysteryGifts(const std::vector<std::unique_ptr<WCX>>& cards);
     virtual void cryptBoxData(bool crypted) = 0;
+    // Raw save buffer; box data in it is only readable by scripts after cryptBoxData(true)
+    u8* rawData(void) const { return data; }
     virtual std::string boxName(u8 box) const = 0;
     virtual void boxName(u8 box, std::string name) = 0;
     virtual u8 partyCount(void) const = 0;
@@ -28,6 +28,7 @@
 #define SAVLGPE_HPP
 
 #include "Sav.hpp"
+#include "WB7.hpp"
 
 class SavLGPE : public Sav
 {
@@ -57,6 +58,7 @@ protected:
     int dexFormCount(int species) const;
     void setDexFlags(int index, int gender, int shiny, int baseSpecies);
     bool sanitizeFormsToIterate(int species, int& fs, int& fe, int formIn) const;
+    void giftPkm(WB7* wb7, u16 slot);
 
 public:
     SavLGPE(u8* dt);
@@ -124,6 +126,7 @@ public:
     int emptyGiftLocation(void) const override { return 0; } // Data not stored
     std::vector<MysteryGift::giftData> currentGifts(void) const override { return {}; } // Data not stored
     void mysteryGift(WCX& wc, int& pos) override;
+    size_t mysteryGifts(const std::vector<std::unique_ptr<WCX>>& cards) override;
     std::unique_ptr<WCX> mysteryGift(int pos) const override;
     void cryptBoxData(bool crypted) override;
     std::string boxName(u8 box) const override;
@@ -36,6 +36,10 @@
 #include "spi.hpp"
 #include "utils.hpp"
 
+extern "C" {
+#include "iconTiling.h"
+}
+
 class Title 
 {
 public:
@@ -43,6 +47,8 @@ public:
     ~Title(void);
 
     bool load(u64 id, FS_MediaType mediaType, FS_CardType cardType);
+    // fills in a 3DS title from the title cache rather than from its SMDH
+    void load(u64 id, FS_MediaType mediaType, const std::string& name, const std::string& prefix, const u16* icon);
     CardType SPICardType(void);
     u32 highId(void);
     u32 lowId(void);
@@ -52,13 +58,15 @@ public:
     FS_CardType cardType(void);
 
     std::string checkpointPrefix(void);
+    // the icon as it's laid out in its texture, ICON_TEXTURE_TEXELS long
+    const u16* iconTexels(void);
 
 private:
     u64 mId;
     FS_MediaType mMedia;
     FS_CardType mCard;
     CardType mCardType;
-    C2D_Image mIcon;
+    C2D_Image mIcon = {nullptr, nullptr};
     std::string mName;
     std::string mPrefix;
 };
@@ -55,10 +55,18 @@ void backupBridgeChanges(void);
 
 namespace TitleLoader
 {
+    // starts scanning for installed titles in the background, see updateTitles
     void scanTitles(void);
+    // moves the latest scanned list into nandTitles, returning whether it changed. Main thread only
+    bool updateTitles(void);
     void scanCard(void);
     bool cardUpdate(void);
+    // starts scanning for save backups in the background, see savesFor, allSaves and savesVersion
     void scanSaves(void);
+    std::vector<std::string> savesFor(const std::string& id);
+    std::unordered_map<std::string, std::vector<std::string>> allSaves(void);
+    // changes whenever the scan finds more saves
+    u32 savesVersion(void);
     bool load(std::shared_ptr<Title> title);
     bool load(std::shared_ptr<Title> title, std::string path);
     bool load(u8* data, size_t size);
@@ -69,7 +77,6 @@ namespace TitleLoader
     
     extern std::vector<std::shared_ptr<Title>> nandTitles;
     extern std::shared_ptr<Title> cardTitle;
-    extern std::unordered_map<std::string, std::vector<std::string>> sdSaves;
     extern std::shared_ptr<Sav> save;
 }
 
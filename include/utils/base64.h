@@ -30,6 +30,12 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+// the number of bytes data decodes to, or 0 if its length or padding isn't valid
+size_t base64_decoded_length(const char *data, size_t input_length);
+// decodes data into out, returning the number of bytes written, or 0 if data isn't valid base64 or
+// doesn't fit. out may have been written to even when decoding fails
+size_t base64_decode_to(const char *data, size_t input_length, unsigned char *out, size_t out_length);
+// decodes data into a buffer which must be free()d, or returns NULL if data isn't valid base64
 unsigned char *base64_decode(const char *data, size_t input_length, size_t *output_length);
 
 #endif
\ No newline at end of file
@@ -28,5 +28,15 @@
 #include <curl/curl.h>
 #include <malloc.h>
 #include <string.h>
+#include "sha256.h"
 
+struct download_item {
+    const char* url;
+    const char* path;
+    const unsigned char* sha256; // the file is only kept if it has this hash, unless it's NULL
+    Result result;               // set by download_all
+};
+
+// fetches every item at once, returning the first failure or 0
+Result download_all(struct download_item* items, size_t count);
 Result download(const char* url, const char* path);
\ No newline at end of file
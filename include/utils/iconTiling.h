@@ -0,0 +1,41 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef ICONTILING_H
+#define ICONTILING_H
+
+#include <stdint.h>
+
+#define SMDH_ICON_SIZE 48
+#define ICON_TEXTURE_SIZE 64
+// how much of a 64x64 icon texture, from the first texel of the icon on, holds the icon
+#define ICON_TEXTURE_TEXELS (SMDH_ICON_SIZE * ICON_TEXTURE_SIZE)
+
+// Places a 48x48 RGB565 SMDH icon, which is stored as 8x8 tiles already, into a 64x64 tiled texture. Each row
+// of six tiles becomes the first six of a row of eight; texture is offset to the first texel the icon covers
+void smdh_icon_to_texture(const uint16_t* icon, uint16_t* texture);
+
+#endif
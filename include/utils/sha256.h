@@ -31,5 +31,7 @@ void sha256_init(SHA256_CTX *ctx);
 void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len);
 void sha256_final(SHA256_CTX *ctx, BYTE hash[]);
 void sha256(unsigned char hash[], unsigned char data[], size_t len);
+// Hashes count independent messages, data[i] of lens[i] bytes, into hashes[i]
+void sha256_multi(unsigned char hashes[][SHA256_BLOCK_SIZE], const unsigned char *const data[], const size_t lens[], size_t count);
 
 #endif   // SHA256_H
\ No newline at end of file
@@ -0,0 +1,173 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef TEXTLAYOUT_HPP
+#define TEXTLAYOUT_HPP
+
+#include <iterator>
+#include <list>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class TextPosX
+{
+    LEFT,
+    CENTER,
+    RIGHT
+};
+
+// Line breaking and measurement for Gui::dynamicText and Gui::staticText. Nothing here touches
+// citro2d: glyph widths come from a callback, so layouts can be checked against a width table.
+namespace TextLayout
+{
+    // unscaled advance of a glyph
+    typedef float (*GlyphWidth)(uint16_t codepoint);
+
+    struct Line
+    {
+        size_t start;  // byte offset into the text
+        size_t length; // in bytes, without the '\n'
+        float width;   // scaled
+        float offset;  // from the anchor x, for the alignment the layout was made with
+    };
+
+    // Decodes the codepoint starting at text[i] and leaves i on its last byte. Up to three byte UTF-8,
+    // anything else is 0xFFFF. StringUtils measures and splits text with it too, so widths always agree
+    uint16_t nextCodepoint(const std::string& text, size_t& i);
+
+    // replaces lines with one entry per '\n' separated line of text
+    void layout(std::vector<Line>& lines, const std::string& text, float scaleX, TextPosX positionX, GlyphWidth glyphWidth);
+
+    // Layouts by (text, scale, alignment), most recently used first. Entries are dropped once the cache
+    // is full or when they haven't been used for maxAge frames. Extra is per layout data owned by the
+    // caller, such as the parsed text; it is value initialized whenever a layout is computed
+    template <typename Extra>
+    class Cache
+    {
+    public:
+        struct Layout
+        {
+            std::vector<Line> lines;
+            Extra extra;
+        };
+
+        Cache(GlyphWidth glyphWidth, size_t capacity, uint32_t maxAge) : glyphWidth(glyphWidth), capacity(capacity), maxAge(maxAge) {}
+
+        // The returned layout stays valid until it is evicted by a later get, nextFrame or clear
+        Layout& get(const std::string& text, float scaleX, TextPosX positionX)
+        {
+            size_t hash = keyHash(text, scaleX, positionX);
+            auto range = index.equal_range(hash);
+            for (auto i = range.first; i != range.second; i++)
+            {
+                Entry& entry = *i->second;
+                if (entry.scaleX == scaleX && entry.positionX == positionX && entry.text == text)
+                {
+                    entry.lastUsed = generation;
+                    entries.splice(entries.begin(), entries, i->second);
+                    return entry.layout;
+                }
+            }
+
+            if (entries.size() >= capacity)
+            {
+                erase(std::prev(entries.end()));
+            }
+            entries.emplace_front();
+            Entry& entry = entries.front();
+            entry.text = text;
+            entry.scaleX = scaleX;
+            entry.positionX = positionX;
+            entry.hash = hash;
+            entry.lastUsed = generation;
+            TextLayout::layout(entry.layout.lines, text, scaleX, positionX, glyphWidth);
+            index.emplace(hash, entries.begin());
+            return entry.layout;
+        }
+
+        // drops whatever hasn't been used for maxAge frames
+        void nextFrame(void)
+        {
+            generation++;
+            while (!entries.empty() && generation - entries.back().lastUsed > maxAge)
+            {
+                erase(std::prev(entries.end()));
+            }
+        }
+
+        void clear(void)
+        {
+            entries.clear();
+            index.clear();
+        }
+
+        size_t size(void) const { return entries.size(); }
+
+    private:
+        struct Entry
+        {
+            std::string text;
+            float scaleX;
+            TextPosX positionX;
+            size_t hash;
+            uint32_t lastUsed;
+            Layout layout;
+        };
+
+        static size_t keyHash(const std::string& text, float scaleX, TextPosX positionX)
+        {
+            uint32_t scaleBits;
+            memcpy(&scaleBits, &scaleX, sizeof(scaleBits));
+            return std::hash<std::string>{}(text) ^ (scaleBits * 0x9E3779B1u) ^ ((size_t)positionX << 1);
+        }
+
+        void erase(typename std::list<Entry>::iterator entry)
+        {
+            auto range = index.equal_range(entry->hash);
+            for (auto i = range.first; i != range.second; i++)
+            {
+                if (i->second == entry)
+                {
+                    index.erase(i);
+                    break;
+                }
+            }
+            entries.erase(entry);
+        }
+
+        GlyphWidth glyphWidth;
+        size_t capacity;
+        uint32_t maxAge;
+        uint32_t generation = 0;
+        std::list<Entry> entries;
+        std::unordered_multimap<size_t, typename std::list<Entry>::iterator> index;
+    };
+}
+
+#endif
@@ -32,7 +32,7 @@
 
 namespace Threads
 {
-    void create(ThreadFunc entrypoint);
+    void create(ThreadFunc entrypoint, size_t stackSize = 4*1024);
     void destroy(void);
 }
 
@@ -0,0 +1,75 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <3ds.h>
+#include <atomic>
+
+// Hands the newest of a stream of buffers from one producer thread to one consumer thread without locking.
+// The producer fills back() and publishes it; the consumer reads front() after acquire() returns true.
+// A published buffer that was never acquired is given back to the producer, so a slow consumer skips
+// frames instead of falling behind.
+class TripleBuffer
+{
+public:
+    TripleBuffer(void* first, void* second, void* third) : buffers{first, second, third}, shared(1), backIndex(0), frontIndex(2) {}
+
+    void* back(void) const { return buffers[backIndex]; }
+    void* front(void) const { return buffers[frontIndex]; }
+
+    // returns whether this replaced a buffer the consumer never acquired
+    bool publish(void)
+    {
+        u8 old    = shared.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = old & INDEX;
+        return old & FRESH;
+    }
+
+    // returns whether front() now holds a buffer that wasn't read before
+    bool acquire(void)
+    {
+        if (!(shared.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+        u8 old     = shared.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = old & INDEX;
+        return true;
+    }
+
+private:
+    static constexpr u8 INDEX = 3;
+    static constexpr u8 FRESH = 4;
+
+    void* buffers[3];
+    std::atomic<u8> shared;
+    u8 backIndex;
+    u8 frontIndex;
+};
+
+#endif
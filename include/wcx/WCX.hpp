@@ -39,6 +39,7 @@ typedef uint32_t u32;
 class WCX
 {
 friend class InjectSelectorScreen;
+friend class Sav;
 protected:
     virtual const u8* rawData(void) const = 0;
 
@@ -28,25 +28,114 @@
 #include "archive.hpp"
 #include "FSStream.hpp"
 #include "gui.hpp"
+#include <zlib.h>
 
-Configuration::Configuration()
+static const std::u16string jsonPath = u"/config.json";
+static const std::u16string tempPath = u"/config.json.tmp";
+static const std::u16string snapshotPath = u"/config.bin";
+
+static constexpr char snapshotMagic[4] = {'P', 'K', 'C', 'F'};
+static constexpr u32 snapshotVersion = 2;
+// how long after the last change to wait before writing, so a run of changes is written once
+static constexpr u64 saveDelay = 1000;
+
+static bool readFile(const std::u16string& path, std::string& out)
 {
-    static const std::u16string path = StringUtils::UTF8toUTF16("/config.json");
     FSStream stream(Archive::data(), path, FS_OPEN_READ);
-    
-    if (R_FAILED(stream.result()))
+    if (!stream.good())
+    {
+        return false;
+    }
+    out.resize(stream.size());
+    bool good = out.empty() || stream.read(&out[0], out.size()) == out.size();
+    stream.close();
+    return good;
+}
+
+// files are recreated rather than rewritten, as extdata files can't change size
+static bool writeFile(const std::u16string& path, const void* data, u32 size)
+{
+    FSUSER_DeleteFile(Archive::data(), fsMakePath(PATH_UTF16, path.data()));
+    FSStream stream(Archive::data(), path, FS_OPEN_WRITE, size);
+    if (!stream.good())
+    {
+        return false;
+    }
+    bool good = stream.write(data, size) == size;
+    stream.close();
+    return good;
+}
+
+static void putString(std::string& out, const std::string& str)
+{
+    u32 size = str.size();
+    out.append((const char*)&size, sizeof(size));
+    out.append(str);
+}
+
+static bool getData(const std::string& in, size_t& pos, void* out, size_t size)
+{
+    if (in.size() - pos < size)
+    {
+        return false;
+    }
+    std::copy(in.begin() + pos, in.begin() + pos + size, (char*)out);
+    pos += size;
+    return true;
+}
+
+static bool getString(const std::string& in, size_t& pos, std::string& out)
+{
+    u32 size;
+    if (!getData(in, pos, &size, sizeof(size)) || in.size() - pos < size)
+    {
+        return false;
+    }
+    out = in.substr(pos, size);
+    pos += size;
+    return true;
+}
+
+static bool getStrings(const std::string& in, size_t& pos, std::vector<std::string>& out)
+{
+    u32 count;
+    if (!getData(in, pos, &count, sizeof(count)))
     {
-        loadFromRomfs();
+        return false;
     }
-    else
+    out.resize(count);
+    for (auto& str : out)
+    {
+        if (!getString(in, pos, str))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Configuration::Configuration()
+{
+    // A write that was cut off leaves either the old file or, once that's gone, the complete new one in its place
+    for (auto& path : { jsonPath, tempPath })
     {
-        oldSize = stream.size();
-        char* jsonData = new char[oldSize + 1];
-        jsonData[oldSize] = '\0';
-        stream.read(jsonData, oldSize);
-        stream.close();
-        mJson = nlohmann::json::parse(jsonData);
-        delete[] jsonData;
+        if (!readFile(path, mJsonText) || mJsonText.empty())
+        {
+            continue;
+        }
+
+        u32 crc = crc32(0, (const Bytef*)mJsonText.data(), mJsonText.size());
+        if (loadSnapshot(crc))
+        {
+            return;
+        }
+
+        mJson = nlohmann::json::parse(mJsonText, nullptr, false);
+        if (mJson.is_discarded() || !mJson.is_object())
+        {
+            continue;
+        }
+        mJsonParsed = true;
 
         if (mJson.find("version") == mJson.end())
         {
@@ -56,7 +145,8 @@ Configuration::Configuration()
         {
             if (mJson["version"].get<int>() > CURRENT_VERSION)
             {
-                Gui::warn(i18n::localize("THE_FUCK"), i18n::localize("DO_NOT_DOWNGRADE"));
+                loadFromJson();
+                mNewerVersion = true;
                 return;
             }
             if (mJson["version"].get<int>() < 2)
@@ -76,65 +166,234 @@ Configuration::Configuration()
                 CFGU_SecureInfoGetRegion(countryData);
                 mJson["defaults"]["nationality"] = countryData[0];
             }
+            if (mJson["version"].get<int>() < 5)
+            {
+                mJson["backupsToKeep"] = 0;
+            }
 
             mJson["version"] = CURRENT_VERSION;
+            loadFromJson();
             save();
         }
+        else
+        {
+            loadFromJson();
+            writeSnapshot(crc);
+        }
+        return;
     }
+
+    loadFromRomfs();
 }
 
-void Configuration::save()
+void Configuration::loadFromJson()
+{
+    mSettings.version        = mJson["version"];
+    mSettings.language       = mJson["language"];
+    mSettings.autoBackup     = mJson["autoBackup"];
+    mSettings.storageSize    = mJson["storageSize"];
+    mSettings.transferEdit   = mJson["transferEdit"];
+    mSettings.useExtData     = mJson["useExtData"];
+    mSettings.defaultTID     = mJson["defaults"]["pid"];
+    mSettings.defaultSID     = mJson["defaults"]["sid"];
+    mSettings.nationality    = mJson["defaults"]["nationality"];
+    mSettings.day            = mJson["defaults"]["date"]["day"];
+    mSettings.month          = mJson["defaults"]["date"]["month"];
+    mSettings.year           = mJson["defaults"]["date"]["year"];
+    mSettings.defaultRegion  = mJson["defaults"]["region"];
+    mSettings.defaultCountry = mJson["defaults"]["country"];
+    mSettings.writeFileSave  = mJson["writeFileSave"];
+    mSettings.useSaveInfo    = mJson["useSaveInfo"];
+    mSettings.randomMusic    = mJson["randomMusic"];
+    mSettings.backupsToKeep  = mJson["backupsToKeep"];
+    mDefaultOT               = mJson["defaults"]["ot"];
+
+    mExtraSaves.clear();
+    for (auto& saves : mJson["extraSaves"].items())
+    {
+        auto& value = mExtraSaves[saves.key()];
+        if (saves.value().find("folders") != saves.value().end())
+        {
+            value.first = saves.value()["folders"].get<std::vector<std::string>>();
+        }
+        if (saves.value().find("files") != saves.value().end())
+        {
+            value.second = saves.value()["files"].get<std::vector<std::string>>();
+        }
+    }
+}
+
+// layout: magic, u32 snapshot version, u32 CRC-32 of the config.json it was made from, the Settings struct,
+// then the default OT and every extraSaves entry's id, folders and files
+bool Configuration::loadSnapshot(u32 jsonCrc)
 {
-    static const std::u16string path = StringUtils::UTF8toUTF16("/config.json");
+    std::string data;
+    if (!readFile(snapshotPath, data))
+    {
+        return false;
+    }
 
-    std::string writeData = mJson.dump(2);
-    writeData.shrink_to_fit();
-    size_t size = writeData.size();
+    size_t pos = 0;
+    char magic[4];
+    u32 header[2];
+    Settings settings;
+    std::string ot;
+    u32 count;
+    if (!getData(data, pos, magic, sizeof(magic)) || !std::equal(magic, magic + 4, snapshotMagic) ||
+        !getData(data, pos, header, sizeof(header)) || header[0] != snapshotVersion || header[1] != jsonCrc ||
+        !getData(data, pos, &settings, sizeof(settings)) || settings.version != CURRENT_VERSION || !getString(data, pos, ot) ||
+        !getData(data, pos, &count, sizeof(count)))
+    {
+        return false;
+    }
 
-    if (oldSize != size)
+    std::map<std::string, std::pair<std::vector<std::string>, std::vector<std::string>>> extraSaves;
+    for (u32 i = 0; i < count; i++)
     {
-        FSUSER_DeleteFile(Archive::data(), fsMakePath(PATH_UTF16, path.data()));
+        std::string id;
+        if (!getString(data, pos, id))
+        {
+            return false;
+        }
+        auto& value = extraSaves[id];
+        if (!getStrings(data, pos, value.first) || !getStrings(data, pos, value.second))
+        {
+            return false;
+        }
     }
 
-    FSStream stream(Archive::data(), path, FS_OPEN_WRITE, oldSize = size);
-    stream.write(writeData.data(), size);
-    stream.close();
+    mSettings   = settings;
+    mDefaultOT  = ot;
+    mExtraSaves = std::move(extraSaves);
+    return true;
 }
 
-std::pair<std::vector<std::string>, std::vector<std::string>> Configuration::extraSaves(std::string id)
+void Configuration::writeSnapshot(u32 jsonCrc)
 {
-    std::vector<std::string> folders = {}, files = {};
-    if (mJson["extraSaves"].find(id) != mJson["extraSaves"].end())
+    if (mSettings.version != CURRENT_VERSION)
+    {
+        return;
+    }
+
+    std::string data(snapshotMagic, sizeof(snapshotMagic));
+    u32 header[2] = {snapshotVersion, jsonCrc};
+    data.append((const char*)header, sizeof(header));
+    data.append((const char*)&mSettings, sizeof(mSettings));
+    putString(data, mDefaultOT);
+    u32 count = mExtraSaves.size();
+    data.append((const char*)&count, sizeof(count));
+    for (auto& saves : mExtraSaves)
     {
-        if (mJson["extraSaves"][id].find("folders") != mJson["extraSaves"][id].end())
+        putString(data, saves.first);
+        for (auto list : { &saves.second.first, &saves.second.second })
         {
-            nlohmann::json add = mJson["extraSaves"][id]["folders"];
-            for (size_t i = 0; i < add.size(); i++)
+            count = list->size();
+            data.append((const char*)&count, sizeof(count));
+            for (auto& str : *list)
             {
-                folders.push_back(add[i]);
+                putString(data, str);
             }
         }
-        if (mJson["extraSaves"][id].find("files") != mJson["extraSaves"][id].end())
+    }
+    writeFile(snapshotPath, data.data(), data.size());
+}
+
+void Configuration::save()
+{
+    mDirty = true;
+    mSaveRequested = osGetTime();
+}
+
+void Configuration::flush(bool force)
+{
+    if (mDirty && (force || osGetTime() - mSaveRequested >= saveDelay))
+    {
+        write();
+        mDirty = false;
+    }
+}
+
+void Configuration::write()
+{
+    if (!mJsonParsed)
+    {
+        mJson = nlohmann::json::parse(mJsonText, nullptr, false);
+        if (mJson.is_discarded() || !mJson.is_object())
+        {
+            mJson = nlohmann::json::object();
+        }
+        mJsonParsed = true;
+    }
+
+    mJson["version"]                       = mSettings.version;
+    mJson["language"]                      = mSettings.language;
+    mJson["autoBackup"]                    = mSettings.autoBackup;
+    mJson["storageSize"]                   = mSettings.storageSize;
+    mJson["transferEdit"]                  = mSettings.transferEdit;
+    mJson["useExtData"]                    = mSettings.useExtData;
+    mJson["defaults"]["pid"]               = mSettings.defaultTID;
+    mJson["defaults"]["sid"]               = mSettings.defaultSID;
+    mJson["defaults"]["ot"]                = mDefaultOT;
+    mJson["defaults"]["nationality"]       = mSettings.nationality;
+    mJson["defaults"]["date"]["day"]       = mSettings.day;
+    mJson["defaults"]["date"]["month"]     = mSettings.month;
+    mJson["defaults"]["date"]["year"]      = mSettings.year;
+    mJson["defaults"]["region"]            = mSettings.defaultRegion;
+    mJson["defaults"]["country"]           = mSettings.defaultCountry;
+    mJson["writeFileSave"]                 = mSettings.writeFileSave;
+    mJson["useSaveInfo"]                   = mSettings.useSaveInfo;
+    mJson["randomMusic"]                   = mSettings.randomMusic;
+    mJson["backupsToKeep"]                 = mSettings.backupsToKeep;
+    for (auto& saves : mExtraSaves)
+    {
+        if (!saves.second.first.empty())
+        {
+            mJson["extraSaves"][saves.first]["folders"] = saves.second.first;
+        }
+        if (!saves.second.second.empty())
         {
-            nlohmann::json add = mJson["extraSaves"][id]["files"];
-            for (size_t i = 0; i < add.size(); i++)
-            {
-                files.push_back(add[i]);
-            }
+            mJson["extraSaves"][saves.first]["files"] = saves.second.second;
+        }
+    }
+
+    mJsonText = mJson.dump(2);
+
+    // the new file is complete before the old one is removed, then it's moved into place
+    if (!writeFile(tempPath, mJsonText.data(), mJsonText.size()))
+    {
+        return;
+    }
+    FSUSER_DeleteFile(Archive::data(), fsMakePath(PATH_UTF16, jsonPath.data()));
+    if (R_FAILED(FSUSER_RenameFile(Archive::data(), fsMakePath(PATH_UTF16, tempPath.data()), Archive::data(), fsMakePath(PATH_UTF16, jsonPath.data()))))
+    {
+        if (writeFile(jsonPath, mJsonText.data(), mJsonText.size()))
+        {
+            FSUSER_DeleteFile(Archive::data(), fsMakePath(PATH_UTF16, tempPath.data()));
         }
     }
-    return {folders, files};
+
+    writeSnapshot(crc32(0, (const Bytef*)mJsonText.data(), mJsonText.size()));
+}
+
+std::pair<std::vector<std::string>, std::vector<std::string>> Configuration::extraSaves(std::string id)
+{
+    auto found = mExtraSaves.find(id);
+    if (found == mExtraSaves.end())
+    {
+        return {{}, {}};
+    }
+    return found->second;
 }
 
 void Configuration::extraSaves(std::string id, std::pair<std::vector<std::string>, std::vector<std::string>>& value)
 {
     if (!value.first.empty())
     {
-        mJson["extraSaves"][id]["folders"] = value.first;
+        mExtraSaves[id].first = value.first;
     }
     if (!value.second.empty())
     {
-        mJson["extraSaves"][id]["files"] = value.second;
+        mExtraSaves[id].second = value.second;
     }
 }
 
@@ -197,6 +456,8 @@ void Configuration::loadFromRomfs()
             break;
     }
     mJson["language"] = systemLanguage;
+    mJsonParsed = true;
 
+    loadFromJson();
     save();
 }
\ No newline at end of file
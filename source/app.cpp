@@ -26,6 +26,7 @@
 
 #include "app.hpp"
 #include <random>
+#include <sys/stat.h>
 
 std::mt19937 randomNumbers;
 
@@ -40,28 +41,109 @@ struct asset {
     unsigned char hash[SHA256_BLOCK_SIZE];
 };
 
+// what an asset file looked like when it was last hashed, so unchanged files aren't hashed again on every launch
+struct assetRecord {
+    u64 size;
+    u64 mtime;
+    unsigned char hash[SHA256_BLOCK_SIZE];
+};
+
+static constexpr const char* assetCachePath = "/3ds/PKSM/assets/hashes.bin";
+
+// startup stages, timed and written to /3ds/PKSM/startup.txt
+enum StartupStage {
+    STAGE_SERVICES,
+    STAGE_ASSETS,
+    STAGE_GUI,
+    STAGE_DATA,
+    STAGE_COUNT
+};
+
+static const char* stageNames[STAGE_COUNT] = {"services", "assets", "gui", "config, i18n"};
+static u64 stageTicks[STAGE_COUNT][2];
+
+static void stageBegin(StartupStage stage) { stageTicks[stage][0] = svcGetSystemTick(); }
+static void stageEnd(StartupStage stage) { stageTicks[stage][1] = svcGetSystemTick(); }
+
+static void writeStartupTrace(u64 start)
+{
+    FILE* out = fopen("/3ds/PKSM/startup.txt", "w");
+    if (out)
+    {
+        fprintf(out, "%-14s %10s %10s %10s\n", "stage", "start ms", "end ms", "took ms");
+        for (int i = 0; i < STAGE_COUNT; i++)
+        {
+            fprintf(out, "%-14s %10.1f %10.1f %10.1f\n", stageNames[i], (stageTicks[i][0] - start) / TICKS_PER_MSEC,
+                (stageTicks[i][1] - start) / TICKS_PER_MSEC, (stageTicks[i][1] - stageTicks[i][0]) / TICKS_PER_MSEC);
+        }
+        fprintf(out, "%-14s %10s %10.1f\n", "total", "", (svcGetSystemTick() - start) / TICKS_PER_MSEC);
+        fclose(out);
+    }
+}
+
 static bool matchSha256HashFromFile(const std::string& path, unsigned char* sha)
 {
     bool match = false;
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    std::ifstream file(path, std::ios::binary);
     if (file.good())
     {
-        size_t size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        char* data = new char[size];
-        file.read(data, size);
-        char hash[SHA256_BLOCK_SIZE];
-        sha256((unsigned char*)hash, (unsigned char*)data, size);
+        // hashed a chunk at a time rather than reading the whole sheet into memory
+        static constexpr size_t chunkSize = 0x10000;
+        char* data = new char[chunkSize];
+        SHA256_CTX ctx;
+        sha256_init(&ctx);
+        while (file.read(data, chunkSize) || file.gcount() > 0)
+        {
+            sha256_update(&ctx, (unsigned char*)data, file.gcount());
+        }
         delete[] data;
-        //std::ofstream out(path + ".bin", std::ios::binary);
-        //out.write(hash, SHA256_BLOCK_SIZE);
-        //out.close();
+        unsigned char hash[SHA256_BLOCK_SIZE];
+        sha256_final(&ctx, hash);
         match = memcmp(sha, hash, SHA256_BLOCK_SIZE) == 0;
     }
     file.close();
     return match;
 }
 
+// checks the file against its hash, unless it's the same size and age as when it last matched
+static bool assetMatches(const std::string& path, unsigned char* sha, assetRecord& record, bool& recordChanged)
+{
+    struct stat st;
+    u64 mtime = 0;
+    if (stat(path.c_str(), &st) != 0 || R_FAILED(sdmc_getmtime(path.c_str(), &mtime)))
+    {
+        return matchSha256HashFromFile(path, sha);
+    }
+    if (record.size == (u64) st.st_size && record.mtime == mtime && memcmp(record.hash, sha, SHA256_BLOCK_SIZE) == 0)
+    {
+        return true;
+    }
+    if (!matchSha256HashFromFile(path, sha))
+    {
+        return false;
+    }
+
+    record.size  = st.st_size;
+    record.mtime = mtime;
+    std::copy(sha, sha + SHA256_BLOCK_SIZE, record.hash);
+    recordChanged = true;
+    return true;
+}
+
+// notes a file which is already known to match its hash, so the next boot doesn't hash it again
+static void recordAsset(const std::string& path, unsigned char* sha, assetRecord& record, bool& recordChanged)
+{
+    struct stat st;
+    u64 mtime = 0;
+    if (stat(path.c_str(), &st) == 0 && R_SUCCEEDED(sdmc_getmtime(path.c_str(), &mtime)))
+    {
+        record.size  = st.st_size;
+        record.mtime = mtime;
+        std::copy(sha, sha + SHA256_BLOCK_SIZE, record.hash);
+        recordChanged = true;
+    }
+}
+
 static Result downloadAdditionalAssets(void) {
     Result res = 0;
     asset assets[2] = {
@@ -83,12 +165,25 @@ static Result downloadAdditionalAssets(void) {
         }
     };
 
-    for (auto item : assets)
+    assetRecord records[2] = {};
+    bool recordsChanged = false;
+    FILE* cache = fopen(assetCachePath, "rb");
+    if (cache)
+    {
+        fread(records, sizeof(records), 1, cache);
+        fclose(cache);
+    }
+
+    download_item downloads[2];
+    size_t downloadIndex[2];
+    size_t downloadCount = 0;
+    for (size_t i = 0; i < 2; i++)
     {
+        auto& item = assets[i];
         bool downloadAsset = true;
         if (io::exists(item.path))
         {
-            if (matchSha256HashFromFile(item.path, item.hash))
+            if (assetMatches(item.path, item.hash, records[i], recordsChanged))
             {
                 downloadAsset = false;
             }
@@ -99,13 +194,31 @@ static Result downloadAdditionalAssets(void) {
         }
         if (downloadAsset)
         {
-            u32 status;
-            ACU_GetWifiStatus(&status);
-            if (status == 0) return -1;
-            Result res1 = download(item.url.c_str(), item.path.c_str());
-            if (R_FAILED(res1)) return res1;
+            downloadIndex[downloadCount] = i;
+            downloads[downloadCount++] = {item.url.c_str(), item.path.c_str(), item.hash, 0};
         }
     }
+
+    // missing sheets are fetched together, and only kept if they match their hash
+    if (downloadCount > 0)
+    {
+        u32 status;
+        ACU_GetWifiStatus(&status);
+        if (status == 0) return -1;
+        res = download_all(downloads, downloadCount);
+        if (R_FAILED(res)) return res;
+        for (size_t i = 0; i < downloadCount; i++)
+        {
+            size_t asset = downloadIndex[i];
+            recordAsset(assets[asset].path, assets[asset].hash, records[asset], recordsChanged);
+        }
+    }
+
+    if (recordsChanged && (cache = fopen(assetCachePath, "wb")) != NULL)
+    {
+        fwrite(records, sizeof(records), 1, cache);
+        fclose(cache);
+    }
     return res;
 }
 
@@ -123,9 +236,20 @@ static Result consoleDisplayError(const std::string& message, Result res)
     return res;
 }
 
+// everything which doesn't need the GPU, run while the main thread checks the assets and starts the GUI
+static void loadData(void*)
+{
+    stageBegin(STAGE_DATA);
+    Configuration::getInstance();
+    i18n::init();
+    stageEnd(STAGE_DATA);
+}
+
 Result App::init(std::string execPath)
 {
     Result res;
+    u64 start = svcGetSystemTick();
+    stageBegin(STAGE_SERVICES);
 
     hidInit();
     gfxInitDefault();
@@ -161,18 +285,51 @@ Result App::init(std::string execPath)
         return consoleDisplayError("socInit failed.", -1);
     }
 
-    if (R_FAILED(res = downloadAdditionalAssets()))
+    stageEnd(STAGE_SERVICES);
+
+    s32 prio = 0;
+    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+    Thread dataThread = threadCreate(loadData, NULL, 0x10000, prio - 1, -2, false);
+    if (dataThread == NULL)
+    {
+        loadData(NULL);
+    }
+
+    stageBegin(STAGE_ASSETS);
+    res = downloadAdditionalAssets();
+    stageEnd(STAGE_ASSETS);
+    if (R_FAILED(res))
+    {
+        if (dataThread != NULL)
+        {
+            threadJoin(dataThread, U64_MAX);
+            threadFree(dataThread);
+        }
         return consoleDisplayError("Additional assets download failed.\n\nAlways make sure you're connected to the internet.", res);
-    if (R_FAILED(res = Gui::init()))
+    }
+
+    stageBegin(STAGE_GUI);
+    res = Gui::init();
+    stageEnd(STAGE_GUI);
+
+    if (dataThread != NULL)
+    {
+        threadJoin(dataThread, U64_MAX);
+        threadFree(dataThread);
+    }
+    if (R_FAILED(res))
         return consoleDisplayError("Gui::init failed.", res);
-    
-    Configuration::getInstance();
-    i18n::init();
 
-    Threads::create((ThreadFunc)TitleLoader::scanTitles);
+    if (Configuration::getInstance().newerVersion())
+    {
+        Gui::warn(i18n::localize("THE_FUCK"), i18n::localize("DO_NOT_DOWNGRADE"));
+    }
+
+    TitleLoader::scanTitles();
     TitleLoader::scanSaves();
 
     randomNumbers.seed(osGetTime());
+    writeStartupTrace(start);
 
     Gui::setScreen(std::make_unique<TitleLoadScreen>());
 
@@ -35,195 +35,323 @@
 #include "PK7.hpp"
 #include "loader.hpp"
 
-static void qrHandler(qr_data*, QRMode, u8*&);
+static constexpr u32 FRAME_WIDTH   = 400;
+static constexpr u32 FRAME_HEIGHT  = 240;
+static constexpr u32 FRAME_SIZE    = FRAME_WIDTH * FRAME_HEIGHT * sizeof(u16);
+static constexpr u32 PREVIEW_SIZE  = 512 * 256 * sizeof(u16);
+static constexpr s64 DECODE_WAIT   = 100000000; // keep checking for B while no frames arrive
+static constexpr int FULL_SCAN_INTERVAL = 15;      // frames searched around the last codes between full searches
+static constexpr int BATCH_FRAMES  = 10;           // frames without a new code before a sheet is imported
+
+static bool handleCode(QRMode, struct quirc_data*, u8*&);
+static void importCopies(QRMode, u8*);
+static bool addToBatch(qr_data*, const struct quirc_data*);
+static void importBatch(std::vector<std::vector<u8>>&);
+static bool qrHandler(qr_data*, QRMode, u8*&);
 static void camThread(void*);
+static void procThread(void*);
 static void uiThread(void*);
 
-static void qrHandler(qr_data* data, QRMode mode, u8*& buff)
+qr_data::qr_data(void)
+    : frameBuffers{(u16*)malloc(FRAME_SIZE), (u16*)malloc(FRAME_SIZE), (u16*)malloc(FRAME_SIZE)},
+      grayBuffers{(u8*)malloc(FRAME_WIDTH * FRAME_HEIGHT), (u8*)malloc(FRAME_WIDTH * FRAME_HEIGHT), (u8*)malloc(FRAME_WIDTH * FRAME_HEIGHT)},
+      previewBuffers{(u16*)calloc(1, PREVIEW_SIZE), (u16*)calloc(1, PREVIEW_SIZE), (u16*)calloc(1, PREVIEW_SIZE)},
+      frames(frameBuffers[0], frameBuffers[1], frameBuffers[2]),
+      grays(grayBuffers[0], grayBuffers[1], grayBuffers[2]),
+      previews(previewBuffers[0], previewBuffers[1], previewBuffers[2]),
+      cancel(0),
+      frameReady(0),
+      grayReady(0),
+      finished(false),
+      threads{NULL, NULL, NULL},
+      roiX(0),
+      roiY(0),
+      roiW(0),
+      roiH(0),
+      framesSinceFullScan(0),
+      batchFramesLeft(0)
 {
-    hidScanInput();
-    if (hidKeysDown() & KEY_B)
+    svcCreateEvent(&cancel, RESET_STICKY);
+    svcCreateEvent(&frameReady, RESET_ONESHOT);
+    svcCreateEvent(&grayReady, RESET_ONESHOT);
+    context = quirc_new();
+    quirc_resize(context, FRAME_WIDTH, FRAME_HEIGHT);
+    tex = (C3D_Tex*)malloc(sizeof(C3D_Tex));
+    static const Tex3DS_SubTexture subt3x = { 512, 256, 0.0f, 1.0f, 1.0f, 0.0f };
+    image = (C2D_Image){ tex, &subt3x };
+    C3D_TexInit(image.tex, 512, 256, GPU_RGB565);
+    C3D_TexSetFilter(image.tex, GPU_LINEAR, GPU_LINEAR);
+}
+
+qr_data::~qr_data(void)
+{
+    C3D_TexDelete(tex);
+    free(tex);
+    quirc_destroy(context);
+    svcCloseHandle(grayReady);
+    svcCloseHandle(frameReady);
+    svcCloseHandle(cancel);
+    for (int i = 0; i < 3; i++)
     {
-        QRScanner::exit(data);
-        return;
+        free(frameBuffers[i]);
+        free(grayBuffers[i]);
+        free(previewBuffers[i]);
     }
+}
+
+// how each mode's codes carry their data as base64 after a URL. A mode can accept several sizes
+struct Base64Format
+{
+    QRMode mode;
+    size_t header; // length of the URL in front of the data
+    size_t size;   // decoded length
+    size_t offset; // where the data handed back starts
+    size_t keep;   // how much data is handed back
+    bool (*check)(u8* data, size_t size);
+};
+
+static bool isPK6(u8* data, size_t size)
+{
+    return PKX::genFromBytes(data, size, true) == 6;
+}
+
+static constexpr size_t wcHeader = 38; // strlen("http://lunarcookies.github.io/wc.html#")
+static constexpr size_t pkHeader = 6;  // strlen("null/#")
+static constexpr size_t pk6Header = 40; // strlen("http://lunarcookies.github.io/b1s1.html#")
+
+static const Base64Format base64Formats[] = {
+    { WCX4, wcHeader, PGT::length, 0, PGT::length, NULL },
+    { WCX4, wcHeader, WC4::length, 0, WC4::length, NULL },
+    { WCX5, wcHeader, PGF::length, 0, PGF::length, NULL },
+    { WCX6, wcHeader, WC6::length, 0, WC6::length, NULL },
+    { WCX6, wcHeader, WC6::lengthFull, 0x206, WC6::length, NULL },
+    { WCX7, wcHeader, WC6::length, 0, WC6::length, NULL },
+    { WCX7, wcHeader, WC6::lengthFull, 0x206, WC6::length, NULL },
+    { PKM4, pkHeader, 136, 0, 136, NULL }, // PK4/5 length
+    { PKM5, pkHeader, 136, 0, 136, NULL },
+    { PKM6, pk6Header, 232, 0, 232, isPK6 }
+};
+
+// handles a single code, returns whether scanning is over
+static bool handleCode(QRMode mode, struct quirc_data* scan_data, u8*& buff)
+{
+    if (mode != PKM7)
+    {
+        // the length is checked before anything is decoded, and the data is decoded straight into what's handed back
+        for (auto& format : base64Formats)
+        {
+            if (format.mode != mode || (size_t) scan_data->payload_len < format.header)
+            {
+                continue;
+            }
+            const char* text = (const char*)scan_data->payload + format.header;
+            size_t length    = scan_data->payload_len - format.header;
+            if (base64_decoded_length(text, length) != format.size)
+            {
+                continue;
+            }
 
-    if (!data->capturing)
+            u8* out = new u8[format.size];
+            if (base64_decode_to(text, length, out, format.size) != format.size || (format.check && !format.check(out, format.size)))
+            {
+                delete[] out;
+                continue;
+            }
+            if (format.keep != format.size)
+            {
+                buff = new u8[format.keep];
+                std::copy(out + format.offset, out + format.offset + format.keep, buff);
+                delete[] out;
+            }
+            else
+            {
+                buff = out;
+            }
+            break;
+        }
+    }
+    else
     {
-        // create cam thread
-        data->mutex = 0;
-        data->cancel = 0;
-        svcCreateEvent(&data->cancel, RESET_STICKY);
-        svcCreateMutex(&data->mutex, false);
-        if (threadCreate(camThread, data, 0x10000, 0x1A, 1, true) != NULL)
+        if (scan_data->payload_len != 0x1A2)
         {
-            data->capturing = true;
+            return true;
+        }
+
+        u32 copies = *(u32*)(scan_data->payload + 16);
+
+        if (copies > 1)
+        {
+            importCopies(mode, (u8*)scan_data->payload);
         }
         else
         {
-            QRScanner::exit(data);
-            return;
+            buff = new u8[232]; // PK7 size
+            std::copy(scan_data->payload + 0x30, scan_data->payload + 0x30 + 232, buff);
         }
     }
 
-    if (data->finished)
-    {
-        QRScanner::exit(data);
-        return;
-    }
+    return true;
+}
 
-    int w, h;
-    u8* image = (u8*)quirc_begin(data->context, &w, &h);
-    svcWaitSynchronization(data->mutex, U64_MAX);
-    for (ssize_t x = 0; x < w; x++)
+// places the Pokemon from a code which asks for several copies in its box and slot and the slots after it
+static void importCopies(QRMode mode, u8* payload)
+{
+    u32 box = *(u32*)(payload + 8);
+    u32 slot = *(u32*)(payload + 12);
+    u32 copies = *(u32*)(payload + 16);
+
+    if ((int) box < TitleLoader::save->maxBoxes() && slot < 30)
     {
-        for (ssize_t y = 0; y < h; y++)
+        std::shared_ptr<PKX> pkx;
+        if (mode == PKM6)
         {
-            u16 px = data->camera_buffer[y * 400 + x];
-            image[y * w + x] = (u8)(((((px >> 11) & 0x1F) << 3) + (((px >> 5) & 0x3F) << 2) + ((px & 0x1F) << 3)) / 3);
+            pkx = std::make_shared<PK6>(payload + 0x30, true);
         }
-    }
-    svcReleaseMutex(data->mutex);
-    quirc_end(data->context);
-    if (quirc_count(data->context) > 0)
-    {
-        struct quirc_code code;
-        struct quirc_data scan_data;
-        quirc_extract(data->context, 0, &code);  
-        if (!quirc_decode(&code, &scan_data))
+        else
         {
-            QRScanner::exit(data);
-            if (mode == WCX4)
+            pkx = std::make_shared<PK7>(payload + 0x30, true);
+        }
+        for (u32 i = 0; i < copies; i++)
+        {
+            u32 tmpSlot = (slot + i) % 30;
+            u32 tmpBox = box + (slot + i) / 30;
+            if ((int) tmpBox < TitleLoader::save->maxBoxes() && tmpSlot < 30)
             {
-                size_t outSize;
-                static constexpr int wcHeader = 38; // strlen("http://lunarcookies.github.io/wc.html#)
-                u8* out = base64_decode((const char*)scan_data.payload + wcHeader, scan_data.payload_len - wcHeader, &outSize);
-
-                if (outSize == PGT::length || outSize == WC4::length)
-                {
-                    buff = new u8[outSize];
-                    std::copy(out, out + outSize, buff);
-                }
-
-                free(out);
+                TitleLoader::save->pkm(*pkx, tmpBox, tmpSlot);
             }
-            else if (mode == WCX5)
-            {
-                size_t outSize;
-                static constexpr int wcHeader = 38; // strlen("http://lunarcookies.github.io/wc.html#)
-                u8* out = base64_decode((const char*)scan_data.payload + wcHeader, scan_data.payload_len - wcHeader, &outSize);
-
-                if (outSize == PGF::length)
-                {
-                    buff = new u8[outSize];
-                    std::copy(out, out + outSize, buff);
-                }
+        }
+    }
+}
 
-                free(out);
-            }
-            else if (mode == WCX6 || mode == WCX7)
-            {
-                size_t outSize;
-                static constexpr int wcHeader = 38; // strlen("http://lunarcookies.github.io/wc.html#)
-                u8* out = base64_decode((const char*)scan_data.payload + wcHeader, scan_data.payload_len - wcHeader, &outSize);
+// remembers the Pokemon from one code of a sheet, returns whether it wasn't seen before
+static bool addToBatch(qr_data* data, const struct quirc_data* scan_data)
+{
+    if (scan_data->payload_len != 0x1A2)
+    {
+        return false;
+    }
 
-                if (outSize == WC6::length || outSize == WC6::lengthFull)
-                {
-                    buff = new u8[WC6::length];
-                    int ofs = outSize == WC6::lengthFull ? 0x206 : 0;
+    // codes which place several copies in the boxes are kept whole, to go through importCopies at the end
+    if (*(u32*)(scan_data->payload + 16) > 1)
+    {
+        std::vector<u8> code(scan_data->payload, scan_data->payload + 0x1A2);
+        if (std::find(data->copies.begin(), data->copies.end(), code) != data->copies.end())
+        {
+            return false;
+        }
+        data->copies.push_back(std::move(code));
+        return true;
+    }
 
-                    std::copy(out + ofs, out + ofs + WC6::length, buff);
-                }
+    std::vector<u8> pkm(scan_data->payload + 0x30, scan_data->payload + 0x30 + 232);
+    if (std::find(data->batch.begin(), data->batch.end(), pkm) != data->batch.end())
+    {
+        return false;
+    }
+    data->batch.push_back(std::move(pkm));
+    return true;
+}
 
-                free(out);
-            }
-            else if (mode == PKM4)
-            {
-                size_t outSize;
-                static constexpr int pkHeader = 6; // strlen("null/#")
-                u8* out = base64_decode((const char*)scan_data.payload + pkHeader, scan_data.payload_len - pkHeader, &outSize);
+// puts every Pokemon scanned from a sheet into the first empty box slots
+static void importBatch(std::vector<std::vector<u8>>& batch)
+{
+    size_t imported = 0;
+    for (int index = 0; imported < batch.size() && index < TitleLoader::save->maxSlot(); index++)
+    {
+        if (TitleLoader::save->pkm(index / 30, index % 30)->species() == 0)
+        {
+            PK7 pk7(batch[imported].data(), true);
+            TitleLoader::save->pkm(pk7, index / 30, index % 30);
+            imported++;
+        }
+    }
 
-                if (outSize == 136) // PK4/5 length
-                {
-                    buff = new u8[outSize];
-                    std::copy(out, out + outSize, buff);
-                }
+    Gui::warn(StringUtils::format(i18n::localize("QR_BATCH_IMPORTED"), (int) imported, (int) batch.size()));
+}
 
-                free(out);
-            }
-            else if (mode == PKM5)
-            {
-                size_t outSize;
-                static constexpr int pkHeader = 6; // strlen("null/#")
-                u8* out = base64_decode((const char*)scan_data.payload + pkHeader, scan_data.payload_len - pkHeader, &outSize);
+// returns whether scanning is over
+static bool qrHandler(qr_data* data, QRMode mode, u8*& buff)
+{
+    hidScanInput();
+    if (hidKeysDown() & KEY_B)
+    {
+        return true;
+    }
 
-                Gui::warn(std::to_string(outSize));
+    svcWaitSynchronization(data->grayReady, DECODE_WAIT);
+    if (!data->grays.acquire())
+    {
+        return false;
+    }
 
-                if (outSize == 136) // PK4/5 length
-                {
-                    buff = new u8[outSize];
-                    std::copy(out, out + outSize, buff);
-                }
+    int w, h;
+    u8* image = (u8*)quirc_begin(data->context, &w, &h);
+    memcpy(image, data->grays.front(), w * h);
 
-                free(out);
-            }
-            else if (mode == PKM6)
-            {
-                size_t outSize;
-                static constexpr int pkHeader = 40; // strlen("http://lunarcookies.github.io/b1s1.html#")
-                u8* out = base64_decode((const char*)scan_data.payload + pkHeader, scan_data.payload_len - pkHeader, &outSize);
+    // look around the codes found last time, and over the whole frame every so often in case more came into view
+    bool fullScan = data->roiW <= 0 || ++data->framesSinceFullScan >= FULL_SCAN_INTERVAL;
+    if (fullScan)
+    {
+        quirc_end(data->context);
+        data->framesSinceFullScan = 0;
+    }
+    else
+    {
+        quirc_end_roi(data->context, data->roiX, data->roiY, data->roiW, data->roiH);
+    }
 
-                if (PKX::genFromBytes(out, outSize, true) == 6) // PK6 length
-                {
-                    buff = new u8[outSize];
-                    std::copy(out, out + outSize, buff);
-                }
+    // Pokemon codes may come from a sheet, so they're collected until a few frames go by without a new one
+    int count  = quirc_count(data->context);
+    bool batch = mode == PKM7;
+    int left = w, top = h, right = 0, bottom = 0;
+    for (int i = 0; i < count; i++)
+    {
+        struct quirc_code code;
+        struct quirc_data scan_data;
+        quirc_extract(data->context, i, &code);
+        for (int corner = 0; corner < 4; corner++)
+        {
+            left   = std::min(left, code.corners[corner].x);
+            top    = std::min(top, code.corners[corner].y);
+            right  = std::max(right, code.corners[corner].x);
+            bottom = std::max(bottom, code.corners[corner].y);
+        }
 
-                free(out);
+        if (!quirc_decode(&code, &scan_data))
+        {
+            if (!batch)
+            {
+                return handleCode(mode, &scan_data, buff);
             }
-            else if (mode == PKM7)
+            if (addToBatch(data, &scan_data))
             {
-                if (scan_data.payload_len != 0x1A2)
-                {
-                    return;
-                }
-
-                u32 box = *(u32*)(scan_data.payload + 8);
-                u32 slot = *(u32*)(scan_data.payload + 12);
-                u32 copies = *(u32*)(scan_data.payload + 16);
-
-                if (copies > 1)
-                {
-                    if ((int) box < TitleLoader::save->maxBoxes() && slot < 30)
-                    {
-                        std::shared_ptr<PKX> pkx;
-                        if (mode == PKM6)
-                        {
-                            pkx = std::make_shared<PK6>(scan_data.payload + 0x30, true);
-                        }
-                        else
-                        {
-                            pkx = std::make_shared<PK7>(scan_data.payload + 0x30, true);
-                        }
-                        for (u32 i = 0; i < copies; i++)
-                        {
-                            u32 tmpSlot = (slot + i) % 30;
-                            u32 tmpBox = box + (slot + i) / 30;
-                            if ((int) tmpBox < TitleLoader::save->maxBoxes() && tmpSlot < 30)
-                            {
-                                TitleLoader::save->pkm(*pkx, tmpBox, tmpSlot);
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    buff = new u8[232]; // PK7 size
-                    std::copy(scan_data.payload + 0x30, scan_data.payload + 0x30 + 232, buff);
-                }
+                data->batchFramesLeft = BATCH_FRAMES;
             }
         }
     }
+
+    if (count > 0)
+    {
+        // codes move between frames, so leave room around them
+        int margin = std::max(right - left, bottom - top) / 2;
+        data->roiX = left - margin;
+        data->roiY = top - margin;
+        data->roiW = right - left + 2 * margin;
+        data->roiH = bottom - top + 2 * margin;
+    }
+    else
+    {
+        data->roiW = 0;
+    }
+
+    // a code which is alone in the whole frame is done straight away, a sheet once a few frames in a row found
+    // nothing new
+    size_t codes = data->batch.size() + data->copies.size();
+    if (codes == 1 && count == 1 && fullScan)
+    {
+        return true;
+    }
+    return codes > 0 && --data->batchFramesLeft <= 0;
 }
 
 static void camThread(void *arg) 
@@ -233,7 +361,6 @@ static void camThread(void *arg)
     events[0] = data->cancel;
     u32 transferUnit;
 
-    u16* buffer = (u16*)malloc(400 * 240 * sizeof(u16));
     camInit();
     CAMU_SetSize(SELECT_OUT1, SIZE_CTR_TOP_LCD, CONTEXT_A);
     CAMU_SetOutputFormat(SELECT_OUT1, OUTPUT_RGB_565, CONTEXT_A);
@@ -244,10 +371,10 @@ static void camThread(void *arg)
     CAMU_Activate(SELECT_OUT1);
     CAMU_GetBufferErrorInterruptEvent(&events[2], PORT_CAM1);
     CAMU_SetTrimming(PORT_CAM1, false);
-    CAMU_GetMaxBytes(&transferUnit, 400, 240);
-    CAMU_SetTransferBytes(PORT_CAM1, transferUnit, 400, 240);
+    CAMU_GetMaxBytes(&transferUnit, FRAME_WIDTH, FRAME_HEIGHT);
+    CAMU_SetTransferBytes(PORT_CAM1, transferUnit, FRAME_WIDTH, FRAME_HEIGHT);
     CAMU_ClearBuffer(PORT_CAM1);
-    CAMU_SetReceiving(&events[1], buffer, PORT_CAM1, 400 * 240 * sizeof(u16), (s16) transferUnit);
+    CAMU_SetReceiving(&events[1], data->frames.back(), PORT_CAM1, FRAME_SIZE, (s16) transferUnit);
     CAMU_StartCapture(PORT_CAM1);
     bool cancel = false;
     while (!cancel) 
@@ -260,19 +387,18 @@ static void camThread(void *arg)
                 cancel = true;
                 break;
             case 1:
+                // frames are received straight into the buffers procThread reads from
                 svcCloseHandle(events[1]);
                 events[1] = 0;
-                svcWaitSynchronization(data->mutex, U64_MAX);
-                memcpy(data->camera_buffer, buffer, 400 * 240 * sizeof(u16));
-                GSPGPU_FlushDataCache(data->camera_buffer, 400 * 240 * sizeof(u16));
-                svcReleaseMutex(data->mutex);
-                CAMU_SetReceiving(&events[1], buffer, PORT_CAM1, 400 * 240 * sizeof(u16), transferUnit);
+                data->frames.publish();
+                svcSignalEvent(data->frameReady);
+                CAMU_SetReceiving(&events[1], data->frames.back(), PORT_CAM1, FRAME_SIZE, transferUnit);
                 break;
             case 2:
                 svcCloseHandle(events[1]);
                 events[1] = 0;
                 CAMU_ClearBuffer(PORT_CAM1);
-                CAMU_SetReceiving(&events[1], buffer, PORT_CAM1, 400 * 240 * sizeof(u16), transferUnit);
+                CAMU_SetReceiving(&events[1], data->frames.back(), PORT_CAM1, FRAME_SIZE, transferUnit);
                 CAMU_StartCapture(PORT_CAM1);
                 break;
             default:
@@ -291,8 +417,7 @@ static void camThread(void *arg)
     CAMU_ClearBuffer(PORT_CAM1);
     CAMU_Activate(SELECT_NONE);
     camExit();
-    free(buffer);
-    for (int i = 0; i < 3; i++)
+    for (int i = 1; i < 3; i++)
     {
         if (events[i] != 0)
         {
@@ -300,33 +425,60 @@ static void camThread(void *arg)
             events[i] = 0;
         }
     }
-    data->finished = true;
 }
 
-static void uiThread(void* arg)
+// lays out a camera frame as a 512x256 RGB565 texture, in 8x8 tiles of Morton ordered pixels
+static void swizzle(const u16* src, u16* dst)
+{
+    for (u32 y = 0; y < FRAME_HEIGHT; y++)
+    {
+        u32 rowPos = (((y >> 3) * (512 >> 3)) << 6) + (((y & 1) << 1) | ((y & 2) << 2) | ((y & 4) << 3));
+        for (u32 x = 0; x < FRAME_WIDTH; x++)
+        {
+            dst[rowPos + ((x >> 3) << 6) + ((x & 1) | ((x & 2) << 1) | ((x & 4) << 2))] = src[y * FRAME_WIDTH + x];
+        }
+    }
+}
+
+static void procThread(void* arg)
 {
-    static bool first = true;
     qr_data* data = (qr_data*) arg;
+    Handle events[2] = {data->cancel, data->frameReady};
     while (true)
     {
-        svcWaitSynchronization(data->mutex, U64_MAX);
+        s32 index = 0;
+        svcWaitSynchronizationN(&index, events, 2, false, U64_MAX);
+        if (index == 0)
+        {
+            break;
+        }
+        if (!data->frames.acquire())
+        {
+            continue;
+        }
+
+        const u16* frame = (const u16*)data->frames.front();
+        rgb565_to_gray(frame, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH, (u8*)data->grays.back(), false);
+        data->grays.publish();
+        svcSignalEvent(data->grayReady);
+
+        swizzle(frame, (u16*)data->previews.back());
+        data->previews.publish();
+    }
+}
+
+static void uiThread(void* arg)
+{
+    bool first = true;
+    qr_data* data = (qr_data*) arg;
+    while (!data->finished)
+    {
         C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
-        for (u32 x = 0; x < 400; x++)
+        if (data->previews.acquire())
         {
-            for (u32 y = 0; y < 240; y++)
-            {
-                if (data->finished || data->tex == NULL || data->image.tex->data == NULL)
-                {
-                    svcReleaseMutex(data->mutex);
-                    first = true;
-                    return;
-                }
-                u32 dstPos = ((((y >> 3) * (512 >> 3) + (x >> 3)) << 6) + ((x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3))) * 2;
-                u32 srcPos = (y * 400 + x) * 2;
-                memcpy((u8*)data->image.tex->data + dstPos, (u8*)data->camera_buffer + srcPos, 2);
-            }
+            memcpy(data->image.tex->data, data->previews.front(), PREVIEW_SIZE);
+            GSPGPU_FlushDataCache(data->image.tex->data, PREVIEW_SIZE);
         }
-        svcReleaseMutex(data->mutex);
 
         C2D_SceneBegin(g_renderTargetTop);
         C2D_DrawImageAt(data->image, 0.0f, 0.0f, 0.5f, NULL, 1.0f, 1.0f);
@@ -343,41 +495,52 @@ static void uiThread(void* arg)
 
 void QRScanner::init(QRMode mode, u8*& buff)
 {
-    // init qr_data struct variables
-    qr_data* data = (qr_data*)malloc(sizeof(qr_data));
-    data->capturing = false;
-    data->finished = false;
-    data->context = quirc_new();
-    quirc_resize(data->context, 400, 240);
-    data->camera_buffer = (u16*)calloc(1, 400 * 240 * sizeof(u16));
-    data->tex = (C3D_Tex*)malloc(sizeof(C3D_Tex));
-    static const Tex3DS_SubTexture subt3x = { 512, 256, 0.0f, 1.0f, 1.0f, 0.0f };
-    data->image = (C2D_Image){ data->tex, &subt3x };
-    C3D_TexInit(data->image.tex, 512, 256, GPU_RGB565);
-    C3D_TexSetFilter(data->image.tex, GPU_LINEAR, GPU_LINEAR);
+    qr_data* data = new qr_data;
+
+    data->threads[0] = threadCreate(camThread, data, 0x10000, 0x1A, 1, false);
+    // the conversions are the heaviest stage, so they run on the app core next to the decoder instead of
+    // sharing the system core's time slice with camera I/O and drawing
+    s32 prio = 0x30;
+    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+    data->threads[1] = threadCreate(procThread, data, 0x10000, prio - 1, -2, false);
+    data->threads[2] = threadCreate(uiThread, data, 0x10000, 0x1A, 1, false);
+    if (data->threads[0] != NULL && data->threads[1] != NULL && data->threads[2] != NULL)
+    {
+        while (!qrHandler(data, mode, buff));
+    }
 
-    threadCreate(uiThread, data, 0x10000, 0x1A, 1, true);
-    while (!data->finished)
+    std::vector<std::vector<u8>> batch = std::move(data->batch);
+    std::vector<std::vector<u8>> copies = std::move(data->copies);
+    QRScanner::exit(data);
+
+    // these have fixed slots, so they go in before the rest of a sheet fills the empty ones
+    for (auto& code : copies)
+    {
+        importCopies(mode, code.data());
+    }
+
+    if (batch.size() == 1)
     {
-        qrHandler(data, mode, buff);
+        buff = new u8[232]; // PK7 size
+        std::copy(batch[0].begin(), batch[0].end(), buff);
+    }
+    else if (batch.size() > 1)
+    {
+        importBatch(batch);
     }
 }
 
 void QRScanner::exit(qr_data *data)
 {
+    data->finished = true;
     svcSignalEvent(data->cancel);
-    while (!data->finished)
+    for (int i = 0; i < 3; i++)
     {
-        svcSleepThread(1000000);
+        if (data->threads[i] != NULL)
+        {
+            threadJoin(data->threads[i], U64_MAX);
+            threadFree(data->threads[i]);
+        }
     }
-    data->capturing = false;
-    svcWaitSynchronization(data->mutex, U64_MAX); // Wait for the end of the 
-    svcReleaseMutex(data->mutex);
-    svcCloseHandle(data->mutex);
-    C3D_TexDelete(data->tex);
-    free(data->camera_buffer);
-    free(data->tex);
-    data->tex = NULL;
-    quirc_destroy(data->context);
-    free(data);
-}
\ No newline at end of file
+    delete data;
+}
@@ -25,6 +25,7 @@
 */
 
 #include "gui.hpp"
+#include "Configuration.hpp"
 
 C3D_RenderTarget* g_renderTargetTop;
 C3D_RenderTarget* g_renderTargetBottom;
@@ -36,6 +37,29 @@ static C2D_Image bgBoxes;
 static C2D_TextBuf dynamicBuf;
 static C2D_TextBuf staticBuf;
 static std::unordered_map<std::string, C2D_Text> staticMap;
+static u32 dynamicEpoch = 1;
+static u32 staticEpoch = 1;
+
+#define DYNAMIC_BUF_SIZE 4096
+#define STATIC_BUF_SIZE 4096
+#define LAYOUT_CACHE_SIZE 256
+#define LAYOUT_MAX_AGE 300 // frames
+
+static float glyphWidth(uint16_t codepoint)
+{
+    return fontGetCharWidthInfo(fontGlyphIndexFromCodePoint(codepoint))->charWidth;
+}
+
+// Text parsed for a cached layout stays in its buffer across frames. The buffers are only cleared when
+// they fill up, which bumps their epoch so every layout parsed before then is parsed again
+struct ParsedText
+{
+    std::vector<C2D_Text> lines;
+    u32 epoch = 0;
+};
+
+static TextLayout::Cache<ParsedText> dynamicLayouts(glyphWidth, LAYOUT_CACHE_SIZE, LAYOUT_MAX_AGE);
+static TextLayout::Cache<ParsedText> staticLayouts(glyphWidth, LAYOUT_CACHE_SIZE, LAYOUT_MAX_AGE);
 
 std::stack<std::unique_ptr<Screen>> screens;
 static std::function<void()> keyboardFunc;
@@ -145,73 +169,76 @@ void Gui::backgroundAnimatedBottom()
     C2D_DrawImageAt({bgBoxes.tex, &boxes2}, x2--, 0, 0.5f);
 }
 
-void Gui::clearTextBufs(void)
+static void clearDynamicText(void)
 {
     C2D_TextBufClear(dynamicBuf);
+    dynamicEpoch++;
 }
 
-void Gui::dynamicText(const std::string& str, int x, int y, float scaleX, float scaleY, u32 color, TextPosX positionX, TextPosY positionY)
+static void parseLayout(const std::string& str, TextLayout::Cache<ParsedText>::Layout& layout, C2D_TextBuf buf, size_t bufSize, const u32& epoch,
+    void (*clear)(void))
 {
-    const float lineMod = ceilf(scaleY * fontGetInfo()->lineFeed);
+    if (layout.extra.epoch == epoch)
+    {
+        return;
+    }
 
-    static std::vector<std::string> print;
-    static std::vector<int> printX;
-    
-    size_t index = 0;
-    while (index != std::string::npos)
+    // there are never more glyphs than bytes
+    if (C2D_TextBufGetNumGlyphs(buf) + str.size() > bufSize)
     {
-        print.push_back(str.substr(index, str.find('\n', index)));
-        index = str.find('\n', index);
-        if (index != std::string::npos)
-        {
-            index++;
-        }
+        clear();
     }
-    
-    switch (positionX)
+
+    layout.extra.lines.resize(layout.lines.size());
+    for (size_t i = 0; i < layout.lines.size(); i++)
     {
-        case TextPosX::LEFT:
-            for (size_t i = 0; i < print.size(); i++)
-            {
-                printX.push_back(x);
-            }
-            break;
-        case TextPosX::CENTER:
-            for (size_t i = 0; i < print.size(); i++)
-            {
-                printX.push_back(x - (ceilf(StringUtils::textWidth(print[i], scaleX)) / 2));
-            }
-            break;
-        case TextPosX::RIGHT:
-            for (size_t i = 0; i < print.size(); i++)
-            {
-                printX.push_back(x - (ceilf(StringUtils::textWidth(print[i], scaleX))));
-            }
-            break;
+        if (layout.lines.size() == 1)
+        {
+            C2D_TextParse(&layout.extra.lines[i], buf, str.c_str());
+        }
+        else
+        {
+            C2D_TextParse(&layout.extra.lines[i], buf, str.substr(layout.lines[i].start, layout.lines[i].length).c_str());
+        }
+        C2D_TextOptimize(&layout.extra.lines[i]);
     }
+    layout.extra.epoch = epoch;
+}
+
+static void drawLayout(const TextLayout::Cache<ParsedText>::Layout& layout, int x, int y, float scaleX, float scaleY, u32 color, TextPosY positionY)
+{
+    const float lineMod = ceilf(scaleY * fontGetInfo()->lineFeed);
 
     switch (positionY)
     {
         case TextPosY::TOP:
             break;
         case TextPosY::CENTER:
-            y -= ceilf(0.5f * lineMod * (float)print.size());
+            y -= ceilf(0.5f * lineMod * (float)layout.lines.size());
             break;
         case TextPosY::BOTTOM:
-            y -= lineMod * (float)print.size();
+            y -= lineMod * (float)layout.lines.size();
             break;
     }
 
-    for (size_t i = 0; i < print.size(); i++)
+    for (size_t i = 0; i < layout.lines.size(); i++)
     {
-        C2D_Text text;
-        C2D_TextParse(&text, dynamicBuf, print[i].c_str());
-        C2D_TextOptimize(&text);
-        C2D_DrawText(&text, C2D_WithColor, printX[i], y + lineMod * i, 0.5f, scaleX, scaleY, color);
+        C2D_DrawText(&layout.extra.lines[i], C2D_WithColor, (int)(x + layout.lines[i].offset), y + lineMod * i, 0.5f, scaleX, scaleY, color);
     }
+}
 
-    print.clear();
-    printX.clear();
+// Called once a frame. Text buffers are no longer emptied here; this only ages the layout caches
+void Gui::clearTextBufs(void)
+{
+    dynamicLayouts.nextFrame();
+    staticLayouts.nextFrame();
+}
+
+void Gui::dynamicText(const std::string& str, int x, int y, float scaleX, float scaleY, u32 color, TextPosX positionX, TextPosY positionY)
+{
+    TextLayout::Cache<ParsedText>::Layout& layout = dynamicLayouts.get(str, scaleX, positionX);
+    parseLayout(str, layout, dynamicBuf, DYNAMIC_BUF_SIZE, dynamicEpoch, clearDynamicText);
+    drawLayout(layout, x, y, scaleX, scaleY, color, positionY);
 }
 
 C2D_Text Gui::cacheStaticText(const std::string& strKey)
@@ -236,68 +263,14 @@ void Gui::clearStaticText()
 {
     C2D_TextBufClear(staticBuf);
     staticMap.clear();
+    staticEpoch++;
 }
 
 void Gui::staticText(const std::string& strKey, int x, int y, float scaleX, float scaleY, u32 color, TextPosX positionX, TextPosY positionY)
 {
-    const float lineMod = ceilf(scaleY * fontGetInfo()->lineFeed);
-
-    static std::vector<std::string> print;
-    static std::vector<int> printX;
-    
-    size_t index = 0;
-    while (index != std::string::npos)
-    {
-        print.push_back(strKey.substr(index, strKey.find('\n', index)));
-        index = strKey.find('\n', index);
-        if (index != std::string::npos)
-        {
-            index++;
-        }
-    }
-    
-    switch (positionX)
-    {
-        case TextPosX::LEFT:
-            for (size_t i = 0; i < print.size(); i++)
-            {
-                printX.push_back(x);
-            }
-            break;
-        case TextPosX::CENTER:
-            for (size_t i = 0; i < print.size(); i++)
-            {
-                printX.push_back(x - (ceilf(StringUtils::textWidth(print[i], scaleX)) / 2));
-            }
-            break;
-        case TextPosX::RIGHT:
-            for (size_t i = 0; i < print.size(); i++)
-            {
-                printX.push_back(x - (ceilf(StringUtils::textWidth(print[i], scaleX))));
-            }
-            break;
-    }
-
-    switch (positionY)
-    {
-        case TextPosY::TOP:
-            break;
-        case TextPosY::CENTER:
-            y -= ceilf(0.5f * lineMod * (float)print.size());
-            break;
-        case TextPosY::BOTTOM:
-            y -= lineMod * (float)print.size();
-            break;
-    }
-
-    for (size_t i = 0; i < print.size(); i++)
-    {
-        C2D_Text text = cacheStaticText(print[i].c_str());
-        C2D_DrawText(&text, C2D_WithColor, printX[i], y + lineMod * i, 0.5f, scaleX, scaleY, color);
-    }
-
-    print.clear();
-    printX.clear();
+    TextLayout::Cache<ParsedText>::Layout& layout = staticLayouts.get(strKey, scaleX, positionX);
+    parseLayout(strKey, layout, staticBuf, STATIC_BUF_SIZE, staticEpoch, Gui::clearStaticText);
+    drawLayout(layout, x, y, scaleX, scaleY, color, positionY);
 }
 
 static void _draw_mirror_scale(int key, int x, int y, int off, int rep)
@@ -335,8 +308,8 @@ Result Gui::init(void)
     g_renderTargetTop = C2D_CreateScreenTarget(GFX_TOP, GFX_LEFT);
     g_renderTargetBottom = C2D_CreateScreenTarget(GFX_BOTTOM, GFX_LEFT);
 
-    dynamicBuf = C2D_TextBufNew(2048);
-    staticBuf = C2D_TextBufNew(4096);
+    dynamicBuf = C2D_TextBufNew(DYNAMIC_BUF_SIZE);
+    staticBuf = C2D_TextBufNew(STATIC_BUF_SIZE);
 
     spritesheet_ui = C2D_SpriteSheetLoad("romfs:/gfx/ui_sheet.t3x");
     spritesheet_pkm = C2D_SpriteSheetLoad("/3ds/PKSM/assets/pkm_spritesheet.t3x");
@@ -371,7 +344,9 @@ void Gui::mainLoop(void)
             keyboardFunc();
             keyboardFunc = nullptr;
         }
+        Configuration::getInstance().flush();
     }
+    Configuration::getInstance().flush(true);
 }
 
 void Gui::exit(void)
@@ -388,6 +363,8 @@ void Gui::exit(void)
     {
         C2D_SpriteSheetFree(spritesheet_types);
     }
+    dynamicLayouts.clear();
+    staticLayouts.clear();
     if (dynamicBuf)
     {
         C2D_TextBufDelete(dynamicBuf);
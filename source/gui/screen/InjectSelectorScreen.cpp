@@ -28,11 +28,12 @@
 #include "InjectorScreen.hpp"
 #include "loader.hpp"
 #include "FSStream.hpp"
+#include "ClickButton.hpp"
 
 InjectSelectorScreen::InjectSelectorScreen() : hid(10, 2), dumpHid(40, 8)
 {
     MysteryGift::init(TitleLoader::save->generation());
-    wondercards = MysteryGift::wondercards();
+    wondercards = MysteryGift::search("");
 
     if (TitleLoader::save->generation() == Generation::FIVE)
     {
@@ -49,6 +50,7 @@ InjectSelectorScreen::InjectSelectorScreen() : hid(10, 2), dumpHid(40, 8)
     gifts = TitleLoader::save->currentGifts();
 
     buttons.push_back(new Button(160 - 70/2, 207 - 23, 70, 23, [this](){ return this->doQR(); }, ui_sheet_emulated_button_qr_idx, "", FONT_SIZE_14, COLOR_WHITE));
+    buttons.push_back(new ClickButton(75, 50, 170, 23, [this](){ Gui::setNextKeyboardFunc([this](){ this->searchBar(); }); return false; }, ui_sheet_emulated_box_search_idx, "", 0, 0));
 }
 
 InjectSelectorScreen::~InjectSelectorScreen()
@@ -82,6 +84,12 @@ void InjectSelectorScreen::update(touchPosition* touch)
     }
     if (!dump)
     {
+        if (searchString != oldSearchString)
+        {
+            wondercards = MysteryGift::search(searchString);
+            oldSearchString = searchString;
+            hid.select(0);
+        }
         hid.update(wondercards.size());
         if (downKeys & KEY_B)
         {
@@ -93,7 +101,18 @@ void InjectSelectorScreen::update(touchPosition* touch)
             doQR();
             return;
         }
-        if (downKeys & KEY_A)
+        if (downKeys & KEY_Y)
+        {
+            Gui::setNextKeyboardFunc([this](){ this->searchBar(); });
+            return;
+        }
+        if (downKeys & KEY_START && !wondercards.empty())
+        {
+            injectAll();
+            return;
+        }
+        if (downKeys & KEY_A && !wondercards.empty() &&
+            MysteryGift::wondercardIndex(wondercards[hid.fullIndex()], Configuration::getInstance().language()) != MysteryGift::NO_CARD)
         {
             Gui::setScreen(std::make_unique<InjectorScreen>(wondercards[hid.fullIndex()]));
             updateGifts = true;
@@ -148,12 +167,14 @@ void InjectSelectorScreen::draw() const
 
     Gui::staticText("\uE004", 75, 17, FONT_SIZE_18, FONT_SIZE_18, C2D_Color32(197, 202, 233, 255), TextPosX::LEFT, TextPosY::TOP);
     Gui::staticText("\uE005", 228, 17, FONT_SIZE_18, FONT_SIZE_18, C2D_Color32(197, 202, 233, 255), TextPosX::LEFT, TextPosY::TOP);
-    Gui::dynamicText(StringUtils::format("%d/%d", hid.page() + 1, wondercards.size() % 10 == 0 ? wondercards.size() / 10 : wondercards.size() / 10 + 1), 160, 20, FONT_SIZE_12, FONT_SIZE_12, C2D_Color32(197, 202, 233, 255), TextPosX::CENTER, TextPosY::TOP);
+    Gui::dynamicText(StringUtils::format("%d/%d", hid.page() + 1, std::max(wondercards.size() % 10 == 0 ? wondercards.size() / 10 : wondercards.size() / 10 + 1, (size_t) 1)), 160, 20, FONT_SIZE_12, FONT_SIZE_12, C2D_Color32(197, 202, 233, 255), TextPosX::CENTER, TextPosY::TOP);
 
     for (auto button : buttons)
     {
         button->draw();
     }
+    Gui::sprite(ui_sheet_icon_search_idx, 79, 53);
+    Gui::dynamicText(searchString, 95, 52, FONT_SIZE_12, FONT_SIZE_12, COLOR_WHITE, TextPosX::LEFT, TextPosY::TOP);
 
     Gui::staticText("\uE004+\uE005 \uE01E", 160, 207 - 21, FONT_SIZE_14, FONT_SIZE_14, COLOR_WHITE, TextPosX::CENTER, TextPosY::TOP);
 
@@ -210,16 +231,12 @@ void InjectSelectorScreen::draw() const
             }
             else
             {
-                MysteryGift::giftData data;
-                const std::string& lang = i18n::langString(Configuration::getInstance().language());
-                if (wondercards[i].find(lang) != wondercards[i].end())
-                {
-                    data = MysteryGift::wondercardInfo(wondercards[i][lang]);
-                }
-                else
+                size_t index = MysteryGift::wondercardIndex(wondercards[i], Configuration::getInstance().language());
+                if (index == MysteryGift::NO_CARD)
                 {
-                    data = MysteryGift::wondercardInfo(*wondercards[i].begin());
+                    continue;
                 }
+                MysteryGift::giftData data = MysteryGift::wondercardInfo(index);
                 int x = i % 2 == 0 ? 21 : 201;
                 int y = 43 + ((i % 10) / 2) * 37;
                 if (data.species == -1)
@@ -279,6 +296,47 @@ void InjectSelectorScreen::draw() const
     }
 }
 
+void InjectSelectorScreen::searchBar()
+{
+    SwkbdState state;
+    swkbdInit(&state, SWKBD_TYPE_NORMAL, 2, 40);
+    swkbdSetHintText(&state, i18n::localize("EVENTS").c_str());
+    swkbdSetValidation(&state, SWKBD_ANYTHING, 0, 0);
+    swkbdSetInitialText(&state, searchString.c_str());
+    char input[45] = {0};
+    SwkbdButton ret = swkbdInputText(&state, input, sizeof(input));
+    input[44] = '\0';
+    if (ret == SWKBD_BUTTON_CONFIRM)
+    {
+        searchString = input;
+    }
+}
+
+void InjectSelectorScreen::injectAll()
+{
+    if (!Gui::showChoiceMessage(StringUtils::format(i18n::localize("WC_INJECT_ALL"), (int) wondercards.size())))
+    {
+        return;
+    }
+
+    std::vector<std::unique_ptr<WCX>> cards;
+    cards.reserve(wondercards.size());
+    for (size_t match : wondercards)
+    {
+        // events whose card can't be read are skipped, and counted as not injected
+        auto card = MysteryGift::wondercard(MysteryGift::wondercardIndex(match, Configuration::getInstance().language()));
+        if (card)
+        {
+            InjectorScreen::changeDate(*card);
+            cards.push_back(std::move(card));
+        }
+    }
+
+    size_t injected = TitleLoader::save->mysteryGifts(cards);
+    gifts = TitleLoader::save->currentGifts();
+    Gui::warn(StringUtils::format(i18n::localize("WC_INJECTED"), (int) injected, (int) wondercards.size()));
+}
+
 bool InjectSelectorScreen::doQR()
 {
     u8* data = nullptr;
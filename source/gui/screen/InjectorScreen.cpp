@@ -46,29 +46,20 @@ bool InjectorScreen::setLanguage(Language language)
     if (isLangAvailable(language))
     {
         lang = language;
-        wondercard = MysteryGift::wondercard(ids[i18n::langString(lang)]);
+        wondercard = MysteryGift::wondercard(MysteryGift::wondercardIndex(match, lang));
         
         changeDate();
     }
     return false;
 }
 
-InjectorScreen::InjectorScreen(nlohmann::json ids) : hid(40, 8), ids(ids), emptySlot(TitleLoader::save->emptyGiftLocation()),
-                                                     gifts(TitleLoader::save->currentGifts())
+InjectorScreen::InjectorScreen(size_t match) : hid(40, 8), match(match), emptySlot(TitleLoader::save->emptyGiftLocation()),
+                                               gifts(TitleLoader::save->currentGifts())
 {
-    const std::string& langString = i18n::langString(Configuration::getInstance().language());
-    if (ids.find(langString) != ids.end())
-    {
-        wondercard = MysteryGift::wondercard(ids[langString]);
-        game = MysteryGift::wondercardInfo(ids[langString]).game;
-        lang = Configuration::getInstance().language();
-    }
-    else
-    {
-        wondercard = MysteryGift::wondercard(*ids.begin());
-        game = MysteryGift::wondercardInfo(*ids.begin()).game;
-        lang = i18n::langFromString(ids.begin().key());
-    }
+    size_t index = MysteryGift::wondercardIndex(match, Configuration::getInstance().language());
+    wondercard = MysteryGift::wondercard(index);
+    game = MysteryGift::wondercardInfo(index).game;
+    lang = MysteryGift::wondercardLanguage(index);
     
     slot = emptySlot + 1;
     int langIndex = 1;
@@ -93,7 +84,7 @@ InjectorScreen::InjectorScreen(nlohmann::json ids) : hid(40, 8), ids(ids), empty
     changeDate();
 }
 
-InjectorScreen::InjectorScreen(std::unique_ptr<WCX> wcx) : wondercard(std::move(wcx)), hid(40, 8), ids({}), emptySlot(TitleLoader::save->emptyGiftLocation()),
+InjectorScreen::InjectorScreen(std::unique_ptr<WCX> wcx) : wondercard(std::move(wcx)), hid(40, 8), match(MysteryGift::wondercards()), emptySlot(TitleLoader::save->emptyGiftLocation()),
                                                            gifts(TitleLoader::save->currentGifts())
 {
     lang = Language::UNUSED;
@@ -469,13 +460,18 @@ void InjectorScreen::update(touchPosition* touch)
 
 bool InjectorScreen::isLangAvailable(Language l) const
 {
-    return ids.find(i18n::langString(l)) != ids.end();
+    return MysteryGift::wondercardAvailable(match, l);
 }
 
 void InjectorScreen::changeDate()
+{
+    changeDate(*wondercard);
+}
+
+void InjectorScreen::changeDate(WCX& wc)
 {
     u32 newDate = 0;
-    switch (wondercard->generation())
+    switch (wc.generation())
     {
         case Generation::FOUR:
             newDate = Configuration::getInstance().day() | (Configuration::getInstance().month() << 8) | (Configuration::getInstance().year() << 16);
@@ -483,13 +479,13 @@ void InjectorScreen::changeDate()
             {
                 newDate -= (2000 << 16);
             }
-            wondercard->rawDate(newDate);
+            wc.rawDate(newDate);
             break;
         case Generation::FIVE:
             *((u8*)(&newDate)) = (u8)Configuration::getInstance().day();
             *((u8*)(&newDate) + 1) = (u8)Configuration::getInstance().month();
             *((u16*)(&newDate) + 1) = (u16)Configuration::getInstance().year();
-            wondercard->rawDate(newDate);
+            wc.rawDate(newDate);
             break;
         case Generation::SIX:
         case Generation::SEVEN:
@@ -497,7 +493,7 @@ void InjectorScreen::changeDate()
             newDate = Configuration::getInstance().year() * 10000;
             newDate += Configuration::getInstance().month() * 100;
             newDate += Configuration::getInstance().day();
-            wondercard->rawDate(newDate);
+            wc.rawDate(newDate);
             break;
         case Generation::UNUSED:
             break;
@@ -80,7 +80,15 @@ SaveLoadScreen::SaveLoadScreen()
     buttons.push_back(new Button(200, 95, 96, 51, [this](){ return this->loadSave(); }, ui_sheet_res_null_idx, "", 0.0f, 0));
     buttons.push_back(new Button(200, 147, 96, 51, &receiveSaveFromBridge, ui_sheet_res_null_idx, "", 0.0f, 0));
 
-    for (auto i = TitleLoader::sdSaves.begin(); i != TitleLoader::sdSaves.end(); i++)
+    loadSaves();
+}
+
+void SaveLoadScreen::loadSaves()
+{
+    saves.clear();
+    savesVersion = TitleLoader::savesVersion();
+    auto sdSaves = TitleLoader::allSaves();
+    for (auto i = sdSaves.begin(); i != sdSaves.end(); i++)
     {
         std::string key = i->first;
         if (key.size() == 4)
@@ -333,6 +341,18 @@ void SaveLoadScreen::draw(void) const
 void SaveLoadScreen::update(touchPosition* touch)
 {
     Screen::update();
+    // the save scan may still be running, pick up anything it's found since
+    if (savesVersion != TitleLoader::savesVersion())
+    {
+        loadSaves();
+        // a rescan can also find that a backup has gone
+        if (selectedSave > -1 && firstSave + selectedSave >= (int) saves[saveGroup].size())
+        {
+            selectedGroup = !saves[saveGroup].empty();
+            selectedSave = selectedGroup ? 0 : -1;
+            firstSave = 0;
+        }
+    }
     u32 downKeys = hidKeysDown();
     if (selectedGroup)
     {
@@ -76,10 +76,11 @@ namespace
         }
     }
 
-    Picoc* picoC()
+    // kept between runs, so running the same script again goes straight to its main()
+    Picoc* picoC(const std::string& file)
     {
         static Picoc picoc;
-        PicocInitialise(&picoc, PICOC_STACKSIZE);
+        PicocPlatformPrepareFile(&picoc, file.c_str(), PICOC_STACKSIZE);
         return &picoc;
     }
 
@@ -357,10 +358,9 @@ void ScriptScreen::parsePicoCScript(std::string& file)
     // Set stdout to buffer to error
     setvbuf(stdout, error, _IOFBF, 1024);
 
-    Picoc* picoc = picoC();
+    Picoc* picoc = picoC(file);
     if (!PicocPlatformSetExitPoint(picoc))
     {
-        PicocPlatformScanFile(picoc, file.c_str());
         char* args[3];
         std::string data = std::to_string((int)TitleLoader::save->data);
         args[0] = data.data();
@@ -368,7 +368,7 @@ void ScriptScreen::parsePicoCScript(std::string& file)
         args[1] = length.data();
         char version = TitleLoader::save->version();
         args[2] = &version;
-        PicocCallMain(picoc, 3, args);
+        PicocPlatformRunFile(picoc, file.c_str(), 3, args);
         // Restore stdout state
         dup2(stdout_save, STDOUT_FILENO);
     }
@@ -383,5 +383,8 @@ void ScriptScreen::parsePicoCScript(std::string& file)
         // while (aptMainLoop() && !hidKeysDown()) hidScanInput();
         // Gui::warn(error);
     }
-    PicocCleanup(picoc);
+#ifdef PICOC_PROFILE
+    std::string profile = "/3ds/PKSM/" + file.substr(file.rfind('/') + 1);
+    PicocProfileWrite(picoc, (profile + ".folded").c_str(), (profile + ".profile.txt").c_str());
+#endif
 }
\ No newline at end of file
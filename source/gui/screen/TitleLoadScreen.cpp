@@ -185,6 +185,32 @@ void TitleLoadScreen::update(touchPosition* touch)
 {
     Screen::update();
     u32 buttonsDown = hidKeysDown();
+    if (selectedTitle >= 0 && (size_t)selectedTitle < TitleLoader::nandTitles.size())
+    {
+        // the scan can replace the list under the selection, so follow the selected title by its ID
+        u64 selectedId = ((u64)TitleLoader::nandTitles[selectedTitle]->highId() << 32) | TitleLoader::nandTitles[selectedTitle]->lowId();
+        if (TitleLoader::updateTitles())
+        {
+            auto found = std::find_if(TitleLoader::nandTitles.begin(), TitleLoader::nandTitles.end(), [selectedId](std::shared_ptr<Title>& title) {
+                return (((u64)title->highId() << 32) | title->lowId()) == selectedId;
+            });
+            if (found != TitleLoader::nandTitles.end())
+            {
+                selectedTitle = found - TitleLoader::nandTitles.begin();
+            }
+            else
+            {
+                selectedGame = false;
+                selectedSave = -1;
+                firstSave = -1;
+                selectedTitle = -2;
+            }
+        }
+    }
+    else
+    {
+        TitleLoader::updateTitles();
+    }
     if (TitleLoader::cardUpdate())
     {
         selectedGame = false;
@@ -436,7 +462,20 @@ void TitleLoadScreen::update(touchPosition* touch)
             selectedSave = 0;
         }
     }
-    availableCheckpointSaves = TitleLoader::sdSaves[titleFromIndex(selectedTitle)->checkpointPrefix()];
+    // only copied when the selection changes or the save scan has found more
+    std::string prefix = titleFromIndex(selectedTitle)->checkpointPrefix();
+    if (prefix != savesPrefix || savesVersion != TitleLoader::savesVersion())
+    {
+        savesVersion = TitleLoader::savesVersion();
+        savesPrefix = prefix;
+        availableCheckpointSaves = TitleLoader::savesFor(prefix);
+        // a rescan can also find that a backup has gone
+        if (firstSave + selectedSave >= (int) availableCheckpointSaves.size())
+        {
+            selectedSave = selectedSave > -1 ? 0 : -1;
+            firstSave = -1;
+        }
+    }
 
     if (buttonsDown & KEY_SELECT)
     {
@@ -0,0 +1,461 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "BackupStore.hpp"
+#include "Configuration.hpp"
+#include "STDirectory.hpp"
+#include "io.hpp"
+#include <algorithm>
+#include <array>
+#include <ctime>
+#include <set>
+#include <vector>
+#include <sys/stat.h>
+#include <zlib.h>
+
+extern "C" {
+#include "sha256.h"
+}
+
+const std::string BackupStore::BANK = "%bank";
+const std::string BackupStore::BANK_NAMES = "%bank_names";
+const std::string BackupStore::BRIDGE = "%bridge";
+
+static const std::string storeRoot = "/3ds/PKSM/backups/store";
+static const std::string snapshotRoot = storeRoot + "/snapshots";
+static constexpr char manifestMagic[4] = {'P', 'K', 'S', 'B'};
+static constexpr u32 manifestVersion = 1;
+// small enough that an edit usually only touches a chunk or two, large enough to still compress well
+static constexpr u32 chunkSize = 0x4000;
+// how many snapshots backup() may drop before it sweeps their chunks
+static constexpr size_t SWEEP_AFTER = 32;
+
+// a manifest is this header, then the snapshot's file name, then the hash of each chunk in order
+struct ManifestHeader
+{
+    char magic[4];
+    u32 version;
+    u32 size;
+    u32 chunkSize;
+    u32 nameLength;
+};
+
+// a chunk file is this header, then the chunk's zlib stream, or the chunk itself if it didn't compress
+struct ChunkHeader
+{
+    u32 size;
+    u32 stored;
+};
+
+typedef std::array<u8, SHA256_BLOCK_SIZE> ChunkHash;
+
+struct Manifest
+{
+    std::string fileName;
+    u32 size;
+    u32 chunkSize;
+    std::vector<ChunkHash> chunks;
+};
+
+static std::string hex(const ChunkHash& hash)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string ret(hash.size() * 2, '0');
+    for (size_t i = 0; i < hash.size(); i++)
+    {
+        ret[i * 2]     = digits[hash[i] >> 4];
+        ret[i * 2 + 1] = digits[hash[i] & 0xF];
+    }
+    return ret;
+}
+
+static std::string chunkDir(const std::string& name)
+{
+    return storeRoot + "/chunks/" + name.substr(0, 2);
+}
+
+static std::string chunkPath(const ChunkHash& hash)
+{
+    std::string name = hex(hash);
+    return chunkDir(name) + '/' + name;
+}
+
+static bool endsWith(const std::string& str, const std::string& end)
+{
+    return str.size() >= end.size() && str.compare(str.size() - end.size(), end.size(), end) == 0;
+}
+
+// Names come from save file names, so anything which would make them a path, a hidden or relative folder or
+// one of PKSM's own names is written as %XX. '%' is escaped too, which keeps PKSM's names out of reach
+static std::string snapshotDir(const std::string& name)
+{
+    if (name == BackupStore::BANK || name == BackupStore::BANK_NAMES || name == BackupStore::BRIDGE)
+    {
+        return snapshotRoot + '/' + name;
+    }
+
+    static constexpr char digits[] = "0123456789ABCDEF";
+    std::string escaped;
+    for (char c : name)
+    {
+        if (c == '%' || c == '.' || c == '/' || c == '\\' || c == ':' || (u8)c < 0x20)
+        {
+            escaped += '%';
+            escaped += digits[(u8)c >> 4];
+            escaped += digits[(u8)c & 0xF];
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return snapshotRoot + '/' + (escaped.empty() ? "%" : escaped);
+}
+
+// the manifests in a snapshot folder, oldest first
+static std::vector<std::string> manifestsIn(const std::string& dir)
+{
+    std::vector<std::string> ret;
+    STDirectory directory(dir);
+    for (size_t i = 0; i < directory.count(); i++)
+    {
+        if (!directory.folder(i) && endsWith(directory.item(i), ".bkp"))
+        {
+            ret.push_back(dir + '/' + directory.item(i));
+        }
+    }
+    // timestamps sort the same as they compare
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+static std::vector<std::string> snapshots(const std::string& name)
+{
+    return manifestsIn(snapshotDir(name));
+}
+
+static bool readManifest(const std::string& path, Manifest& manifest)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in)
+    {
+        return false;
+    }
+
+    ManifestHeader header;
+    bool good = fread(&header, sizeof(header), 1, in) == 1 && std::equal(manifestMagic, manifestMagic + 4, header.magic) &&
+                header.version == manifestVersion && header.chunkSize > 0;
+    if (good)
+    {
+        manifest.size      = header.size;
+        manifest.chunkSize = header.chunkSize;
+        manifest.fileName.resize(header.nameLength);
+        manifest.chunks.resize((header.size + header.chunkSize - 1) / header.chunkSize);
+        good = (header.nameLength == 0 || fread(&manifest.fileName[0], 1, header.nameLength, in) == header.nameLength) &&
+               (manifest.chunks.empty() || fread(manifest.chunks.data(), sizeof(ChunkHash), manifest.chunks.size(), in) == manifest.chunks.size());
+    }
+    fclose(in);
+    return good;
+}
+
+// files are written beside their destination and renamed into place, so a crash never leaves half of one behind
+static bool writeFile(const std::string& path, const void* data, size_t size, const void* extra = nullptr, size_t extraSize = 0)
+{
+    std::string temp = path + ".tmp";
+    FILE* out = fopen(temp.c_str(), "wb");
+    if (!out)
+    {
+        return false;
+    }
+    bool good = fwrite(data, 1, size, out) == size && (extraSize == 0 || fwrite(extra, 1, extraSize, out) == extraSize);
+    good = fclose(out) == 0 && good;
+    remove(path.c_str());
+    if (!good || rename(temp.c_str(), path.c_str()) != 0)
+    {
+        remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool writeManifest(const std::string& path, const Manifest& manifest)
+{
+    ManifestHeader header;
+    std::copy(manifestMagic, manifestMagic + 4, header.magic);
+    header.version    = manifestVersion;
+    header.size       = manifest.size;
+    header.chunkSize  = manifest.chunkSize;
+    header.nameLength = manifest.fileName.size();
+
+    std::vector<u8> data(sizeof(header) + manifest.fileName.size());
+    std::copy((u8*)&header, (u8*)&header + sizeof(header), data.begin());
+    std::copy(manifest.fileName.begin(), manifest.fileName.end(), data.begin() + sizeof(header));
+    return writeFile(path, data.data(), data.size(), manifest.chunks.data(), manifest.chunks.size() * sizeof(ChunkHash));
+}
+
+// chunks which are already stored are left alone, that's the deduplication
+static bool writeChunk(const ChunkHash& hash, const u8* data, u32 size)
+{
+    std::string path = chunkPath(hash);
+    if (io::exists(path))
+    {
+        return true;
+    }
+    mkdir(chunkDir(hex(hash)).c_str(), 777);
+
+    uLongf stored = compressBound(size);
+    std::vector<u8> buffer(sizeof(ChunkHeader) + std::max((uLongf)size, stored));
+    ChunkHeader header = {size, size};
+    if (compress2(buffer.data() + sizeof(header), &stored, data, size, Z_DEFAULT_COMPRESSION) == Z_OK && stored < size)
+    {
+        header.stored = stored;
+    }
+    else
+    {
+        std::copy(data, data + size, buffer.begin() + sizeof(header));
+    }
+    std::copy((u8*)&header, (u8*)&header + sizeof(header), buffer.begin());
+    return writeFile(path, buffer.data(), sizeof(header) + header.stored);
+}
+
+// reads a chunk back, checking it still matches its hash
+static bool readChunk(const ChunkHash& hash, std::vector<u8>& out)
+{
+    FILE* in = fopen(chunkPath(hash).c_str(), "rb");
+    if (!in)
+    {
+        return false;
+    }
+
+    ChunkHeader header;
+    std::vector<u8> stored;
+    bool good = fread(&header, sizeof(header), 1, in) == 1 && header.stored <= compressBound(header.size);
+    if (good)
+    {
+        stored.resize(header.stored);
+        good = header.stored == 0 || fread(stored.data(), 1, header.stored, in) == header.stored;
+    }
+    fclose(in);
+    if (!good)
+    {
+        return false;
+    }
+
+    if (header.stored == header.size)
+    {
+        out = std::move(stored);
+    }
+    else
+    {
+        uLongf size = header.size;
+        out.resize(header.size);
+        if (uncompress(out.data(), &size, stored.data(), stored.size()) != Z_OK || size != header.size)
+        {
+            return false;
+        }
+    }
+
+    ChunkHash check;
+    sha256(check.data(), out.data(), out.size());
+    return check == hash;
+}
+
+// snapshots removed since the last sweep
+static size_t unswept = 0;
+
+// deletes all but the newest keep snapshots of name, returning how many went
+static size_t removeSnapshots(const std::string& name, size_t keep)
+{
+    auto existing = snapshots(name);
+    size_t removed = 0;
+    for (size_t i = 0; i + keep < existing.size(); i++)
+    {
+        if (remove(existing[i].c_str()) == 0)
+        {
+            removed++;
+        }
+    }
+    return removed;
+}
+
+// deletes every chunk no snapshot refers to, returning how many went
+static size_t sweep(void)
+{
+    unswept = 0;
+    // count the references to every chunk from the snapshots which are left
+    std::set<std::string> referenced;
+    STDirectory store(snapshotRoot);
+    for (size_t i = 0; i < store.count(); i++)
+    {
+        if (!store.folder(i) || store.item(i) == "." || store.item(i) == "..")
+        {
+            continue;
+        }
+        for (auto& path : manifestsIn(snapshotRoot + '/' + store.item(i)))
+        {
+            Manifest manifest;
+            // better to keep some garbage than to lose a chunk something still needs
+            if (!readManifest(path, manifest))
+            {
+                return 0;
+            }
+            for (auto& hash : manifest.chunks)
+            {
+                referenced.insert(hex(hash));
+            }
+        }
+    }
+
+    size_t removed = 0;
+    STDirectory chunks(storeRoot + "/chunks");
+    for (size_t i = 0; i < chunks.count(); i++)
+    {
+        if (!chunks.folder(i) || chunks.item(i).size() != 2)
+        {
+            continue;
+        }
+        std::string dir = storeRoot + "/chunks/" + chunks.item(i);
+        STDirectory bucket(dir);
+        for (size_t j = 0; j < bucket.count(); j++)
+        {
+            if (!bucket.folder(j) && referenced.count(bucket.item(j)) == 0)
+            {
+                remove((dir + '/' + bucket.item(j)).c_str());
+                removed++;
+            }
+        }
+    }
+    return removed;
+}
+
+bool BackupStore::backup(const std::string& name, const std::string& fileName, const u8* data, size_t size)
+{
+    Manifest manifest;
+    manifest.fileName  = fileName;
+    manifest.size      = size;
+    manifest.chunkSize = chunkSize;
+    manifest.chunks.resize((size + chunkSize - 1) / chunkSize);
+
+    std::vector<const u8*> chunks(manifest.chunks.size());
+    std::vector<size_t> lengths(manifest.chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        chunks[i]  = data + i * chunkSize;
+        lengths[i] = std::min((size_t)chunkSize, size - i * chunkSize);
+    }
+    sha256_multi((unsigned char(*)[SHA256_BLOCK_SIZE])manifest.chunks.data(), chunks.data(), lengths.data(), chunks.size());
+
+    auto existing = snapshots(name);
+    Manifest newest;
+    if (!existing.empty() && readManifest(existing.back(), newest) && newest.fileName == manifest.fileName &&
+        newest.size == manifest.size && newest.chunkSize == manifest.chunkSize && newest.chunks == manifest.chunks)
+    {
+        return true;
+    }
+
+    // chunks go first, so a manifest never refers to one which isn't there
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        if (!writeChunk(manifest.chunks[i], chunks[i], lengths[i]))
+        {
+            return false;
+        }
+    }
+
+    char stringTime[15] = {0};
+    time_t unixTime = time(NULL);
+    struct tm* timeStruct = gmtime((const time_t *)&unixTime);
+    std::strftime(stringTime, sizeof(stringTime), "%Y%m%d%H%M%S", timeStruct);
+    std::string dir = snapshotDir(name);
+    mkdir(dir.c_str(), 777);
+    // a second backup within the same second gets a suffix, which still sorts after the first
+    std::string path = dir + '/' + stringTime + ".bkp";
+    for (int i = 1; io::exists(path) && i < 100; i++)
+    {
+        char suffix[8];
+        snprintf(suffix, sizeof(suffix), "_%02d", i);
+        path = dir + '/' + stringTime + suffix + ".bkp";
+    }
+    if (io::exists(path) || !writeManifest(path, manifest))
+    {
+        return false;
+    }
+
+    // a sweep reads every manifest and lists every chunk bucket, so the chunks dropped snapshots leave behind
+    // are only collected once enough of them have piled up, or by an explicit prune
+    int keep = Configuration::getInstance().backupsToKeep();
+    if (keep > 0)
+    {
+        unswept += removeSnapshots(name, keep);
+        if (unswept >= SWEEP_AFTER)
+        {
+            sweep();
+        }
+    }
+    return true;
+}
+
+size_t BackupStore::count(const std::string& name)
+{
+    return snapshots(name).size();
+}
+
+bool BackupStore::restore(const std::string& name, size_t index, const std::string& path)
+{
+    auto existing = snapshots(name);
+    Manifest manifest;
+    if (index >= existing.size() || !readManifest(existing[existing.size() - 1 - index], manifest))
+    {
+        return false;
+    }
+
+    std::string outPath = endsWith(path, "/") ? path + manifest.fileName : path;
+    FILE* out = fopen(outPath.c_str(), "wb");
+    if (!out)
+    {
+        return false;
+    }
+
+    bool good = true;
+    std::vector<u8> chunk;
+    for (size_t i = 0; good && i < manifest.chunks.size(); i++)
+    {
+        size_t length = std::min((size_t)manifest.chunkSize, (size_t)manifest.size - i * manifest.chunkSize);
+        good = readChunk(manifest.chunks[i], chunk) && chunk.size() == length && fwrite(chunk.data(), 1, length, out) == length;
+    }
+    good = fclose(out) == 0 && good;
+    if (!good)
+    {
+        remove(outPath.c_str());
+    }
+    return good;
+}
+
+size_t BackupStore::prune(const std::string& name, size_t keep)
+{
+    removeSnapshots(name, keep);
+    return sweep();
+}
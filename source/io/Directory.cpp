@@ -40,15 +40,14 @@ Directory::Directory(FS_Archive archive, std::u16string root)
 		return;
 	}
 
+	// read several entries per request, each one is a round trip to the FS service
+	static constexpr u32 entriesPerRead = 16;
+	std::vector<FS_DirectoryEntry> items(entriesPerRead);
 	u32 result = 0;
 	do {
-		FS_DirectoryEntry item;
-		err = FSDIR_Read(handle, &result, 1, &item);
-		if (result == 1)
-		{
-			list.push_back(item);
-		}
-	} while(result);
+		err = FSDIR_Read(handle, &result, entriesPerRead, items.data());
+		list.insert(list.end(), items.begin(), items.begin() + result);
+	} while(R_SUCCEEDED(err) && result);
 
 	err = FSDIR_Close(handle);
 	if (R_FAILED(err))
@@ -204,6 +204,61 @@ Result SPIWriteSaveData(CardType type, u32 offset, void* data, u32 size)
     return 0;
 }
 
+// the largest run of consecutive changed pages written with one call, so progress is still reported regularly
+#define SPI_MAX_RUN_PAGES 16
+
+static bool _SPIPageChanged(const u8* data, const u8* shadow, u32 pos, u32 pageSize, u32 size)
+{
+    u32 length = (size - pos < pageSize) ? size - pos : pageSize;
+    return memcmp(data + pos, shadow + pos, length) != 0;
+}
+
+Result SPIWriteChangedSaveData(CardType type, void* data, u8* shadow, u32 size, void (*progress)(u32 done, u32 total))
+{
+    const u8* bytes = (const u8*) data;
+    u32 pageSize = SPIGetPageSize(type);
+    if (pageSize == 0) return 0xC8E13404;
+
+    u32 total = 0;
+    for (u32 pos = 0; pos < size; pos += pageSize)
+    {
+        if (_SPIPageChanged(bytes, shadow, pos, pageSize, size))
+        {
+            total += (size - pos < pageSize) ? size - pos : pageSize;
+        }
+    }
+
+    u32 done = 0;
+    u32 pos = 0;
+    while (pos < size)
+    {
+        if (!_SPIPageChanged(bytes, shadow, pos, pageSize, size))
+        {
+            pos += pageSize;
+            continue;
+        }
+
+        u32 start = pos;
+        u32 pages = 0;
+        while (pos < size && pages < SPI_MAX_RUN_PAGES && _SPIPageChanged(bytes, shadow, pos, pageSize, size))
+        {
+            pos += pageSize;
+            pages++;
+        }
+        if (pos > size) pos = size;
+
+        // page writes erase as they go on every chip type which can be written, so no sector erase is needed
+        Result res = SPIWriteSaveData(type, start, (void*) (bytes + start), pos - start);
+        if (res) return res;
+        memcpy(shadow + start, bytes + start, pos - start);
+
+        done += pos - start;
+        if (progress) progress(done, total);
+    }
+
+    return 0;
+}
+
 Result _SPIReadSaveData_512B_impl(u32 pos, void* data, u32 size)
 { 
     u8 cmd[4];
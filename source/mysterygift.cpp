@@ -26,89 +26,393 @@
 
 #include "mysterygift.hpp"
 
-static nlohmann::json mysteryGiftSheet;
-static u8* mysteryGiftData;
+namespace
+{
+    struct GalleryHeader
+    {
+        char magic[4];
+        u32 version;
+        u32 entryCount;
+        u32 matchCount;
+        u32 entryOffset;
+        u32 matchOffset;
+        u32 stringOffset;
+        u32 dataOffset;
+        u32 tokenCount;
+        u32 tokenOffset;
+        u32 postingOffset;
+    };
+
+    struct GalleryEntry
+    {
+        u32 offset;
+        u16 size;
+        s16 species;
+        s8 form;
+        MysteryGift::CardType type;
+        u8 language;
+        u8 padding;
+        u32 name;
+        u32 game;
+    };
+
+    struct GalleryMatch
+    {
+        u16 languages;
+        u16 index[10];
+    };
+
+    struct GalleryToken
+    {
+        u32 string;
+        u32 first;
+        u32 count;
+    };
+
+    static_assert(sizeof(GalleryHeader) == 44);
+    static_assert(sizeof(GalleryEntry) == 20);
+    static_assert(sizeof(GalleryMatch) == 22);
+    static_assert(sizeof(GalleryToken) == 12);
+
+    constexpr u32 GALLERY_VERSION = 2;
+}
+
+static u8* galleryData = nullptr;
+static const GalleryEntry* galleryEntries = nullptr;
+static const GalleryMatch* galleryMatches = nullptr;
+static const GalleryToken* galleryTokens = nullptr;
+static const u16* galleryPostings = nullptr;
+static const char* galleryStrings = nullptr;
+static const u8* mysteryGiftData = nullptr;
+static size_t entryCount = 0;
+static size_t matchCount = 0;
+static size_t tokenCount = 0;
+static std::string lastQuery;
+static std::vector<size_t> lastResults;
+// Every event's species name in lowercase, empty for items, so searching doesn't convert them for each word
+static std::vector<std::string> speciesNames;
+static Language speciesNamesLang;
 
 void MysteryGift::init(Generation g)
 {
-    std::ifstream sheet(StringUtils::format("romfs:/mg/sheet%s.json", genToCstring(g)));
-    sheet >> mysteryGiftSheet;
-    sheet.close();
+    // The whole gallery is read with a single request and then only ever addressed in place
+    FILE* in = fopen(StringUtils::format("romfs:/mg/gallery%s.bin", genToCstring(g)).c_str(), "rb");
+    if (!in)
+    {
+        return;
+    }
+    fseek(in, 0, SEEK_END);
+    size_t size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    galleryData = new u8[size];
+    bool valid = fread(galleryData, 1, size, in) == size && size >= sizeof(GalleryHeader);
+    fclose(in);
 
-    std::ifstream data(StringUtils::format("romfs:/mg/data%s.bin", genToCstring(g)), std::ios::binary | std::ios::ate);
-    size_t size = data.tellg();
-    data.seekg(0, std::ios::beg);
+    const GalleryHeader* header = (const GalleryHeader*)galleryData;
+    valid = valid && !memcmp(header->magic, "PKMG", 4) && header->version == GALLERY_VERSION &&
+            header->entryOffset + header->entryCount * sizeof(GalleryEntry) <= size &&
+            header->matchOffset + header->matchCount * sizeof(GalleryMatch) <= size &&
+            header->tokenOffset + header->tokenCount * sizeof(GalleryToken) <= size && header->postingOffset <= size &&
+            header->stringOffset <= size && header->dataOffset <= size;
+    if (!valid)
+    {
+        MysteryGift::exit();
+        return;
+    }
 
-    mysteryGiftData = new u8[size];
-    data.read((char*)mysteryGiftData, size);
-    data.close();
+    galleryEntries  = (const GalleryEntry*)(galleryData + header->entryOffset);
+    galleryMatches  = (const GalleryMatch*)(galleryData + header->matchOffset);
+    galleryTokens   = (const GalleryToken*)(galleryData + header->tokenOffset);
+    galleryPostings = (const u16*)(galleryData + header->postingOffset);
+    galleryStrings  = (const char*)(galleryData + header->stringOffset);
+    mysteryGiftData = galleryData + header->dataOffset;
+    entryCount      = header->entryCount;
+    matchCount      = header->matchCount;
+    tokenCount      = header->tokenCount;
 }
 
 std::unique_ptr<WCX> MysteryGift::wondercard(size_t index)
 {
-    std::string gen = mysteryGiftSheet["gen"];
+    if (index >= entryCount)
+    {
+        return nullptr;
+    }
+
+    const GalleryEntry& entry = galleryEntries[index];
+    const u8* data = mysteryGiftData + entry.offset;
 
-    auto entry = mysteryGiftSheet["wondercards"][index];
+    switch (entry.type)
+    {
+        case CardType::WC4:
+            return std::make_unique<WC4>((u8*)data);
+        case CardType::PGT:
+            return std::make_unique<PGT>((u8*)data);
+        case CardType::PGF:
+            return std::make_unique<PGF>((u8*)data);
+        case CardType::WC6:
+        case CardType::WC6FULL:
+            return std::make_unique<WC6>((u8*)data, entry.type == CardType::WC6FULL);
+        case CardType::WC7:
+        case CardType::WC7FULL:
+            return std::make_unique<WC7>((u8*)data, entry.type == CardType::WC7FULL);
+        case CardType::WB7:
+        case CardType::WB7FULL:
+            return std::make_unique<WB7>((u8*)data, entry.type == CardType::WB7FULL);
+    }
+    return nullptr;
+}
+
+void MysteryGift::exit(void)
+{
+    delete[] galleryData;
+    galleryData     = nullptr;
+    galleryEntries  = nullptr;
+    galleryMatches  = nullptr;
+    galleryTokens   = nullptr;
+    galleryPostings = nullptr;
+    galleryStrings  = nullptr;
+    mysteryGiftData = nullptr;
+    entryCount      = 0;
+    matchCount      = 0;
+    tokenCount      = 0;
+    lastQuery.clear();
+    lastResults.clear();
+    speciesNames.clear();
+}
+
+size_t MysteryGift::wondercards()
+{
+    return matchCount;
+}
 
-    u32 offset = entry["offset"];
+bool MysteryGift::wondercardAvailable(size_t match, Language lang)
+{
+    return match < matchCount && lang >= Language::JP && lang <= Language::TW && (galleryMatches[match].languages & (1 << lang));
+}
 
-    if (gen == "4")
+size_t MysteryGift::wondercardIndex(size_t match, Language lang)
+{
+    if (match >= matchCount)
     {
-        std::unique_ptr<WCX> wc = nullptr;
-        if (entry["type"] == "wc4")
-        {
-            wc = std::make_unique<WC4>(mysteryGiftData + offset);
-        }
-        else
+        return NO_CARD;
+    }
+    if (wondercardAvailable(match, lang))
+    {
+        return galleryMatches[match].index[lang - 1];
+    }
+    for (u16 index : galleryMatches[match].index)
+    {
+        if (index != NO_CARD)
         {
-            wc = std::make_unique<PGT>(mysteryGiftData + offset);
+            return index;
         }
-        return wc;
     }
-    else if (gen == "5")
+    return NO_CARD;
+}
+
+Language MysteryGift::wondercardLanguage(size_t index)
+{
+    if (index >= entryCount)
     {
-        PGF *pgf = new PGF(mysteryGiftData + offset);
-        return std::unique_ptr<WCX>(pgf);
+        return Language::EN;
     }
-    else if (gen == "6")
+    return (Language)galleryEntries[index].language;
+}
+
+MysteryGift::giftData MysteryGift::wondercardInfo(size_t index)
+{
+    giftData ret;
+    if (index >= entryCount)
     {
-        WC6 *wc6 = new WC6(mysteryGiftData + offset, entry["type"].get<std::string>().find("full") != std::string::npos);
-        return std::unique_ptr<WCX>(wc6);
+        ret.species = -1;
+        ret.form    = 0;
+        return ret;
     }
-    else if (gen == "7")
+    const GalleryEntry& entry = galleryEntries[index];
+    ret.name    = galleryStrings + entry.name;
+    ret.game    = galleryStrings + entry.game;
+    ret.form    = entry.form;
+    ret.species = entry.species;
+    return ret;
+}
+
+// Must match tokenize in build/EventsGalleryPacker/gallery.py
+static std::vector<std::string> tokenize(std::string in)
+{
+    std::vector<std::string> ret;
+    std::string token;
+    for (char c : StringUtils::toLower(in))
     {
-        WC7 *wc7 = new WC7(mysteryGiftData + offset, entry["type"].get<std::string>().find("full") != std::string::npos);
-        return std::unique_ptr<WCX>(wc7);
+        if ((u8)c < 0x80 && !isalnum((u8)c))
+        {
+            if (!token.empty())
+            {
+                ret.push_back(token);
+            }
+            token.clear();
+        }
+        else
+        {
+            token += c;
+        }
     }
-    else if (gen == "LGPE")
+    if (!token.empty())
     {
-        WB7 *wb7 = new WB7(mysteryGiftData + offset, entry["type"].get<std::string>().find("full") != std::string::npos);
-        return std::unique_ptr<WCX>(wb7);
+        ret.push_back(token);
     }
-    else
+    return ret;
+}
+
+static bool startsWith(const std::string& str, const std::string& prefix)
+{
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+static const std::vector<std::string>& lowerSpeciesNames(void)
+{
+    Language lang = Configuration::getInstance().language();
+    if (speciesNames.size() != matchCount || speciesNamesLang != lang)
     {
-        return nullptr;
+        speciesNames.clear();
+        speciesNames.reserve(matchCount);
+        for (size_t i = 0; i < matchCount; i++)
+        {
+            size_t index     = MysteryGift::wondercardIndex(i, lang);
+            int species      = index == MysteryGift::NO_CARD ? -1 : galleryEntries[index].species;
+            std::string name = species > 0 ? i18n::species(lang, species) : "";
+            speciesNames.push_back(StringUtils::toLower(name));
+        }
+        speciesNamesLang = lang;
     }
+    return speciesNames;
 }
 
-void MysteryGift::exit(void)
+// Scores every event against one word: 3 for a whole token or species name, 1 for a prefix
+static void scoreWord(const std::string& word, const std::vector<std::string>& names, std::vector<u8>& scores)
 {
-    delete[] mysteryGiftData;
-    mysteryGiftSheet.clear();
+    const GalleryToken* token = std::lower_bound(galleryTokens, galleryTokens + tokenCount, word,
+        [](const GalleryToken& t, const std::string& value) { return strcmp(galleryStrings + t.string, value.c_str()) < 0; });
+    for (; token != galleryTokens + tokenCount && !strncmp(galleryStrings + token->string, word.c_str(), word.size()); token++)
+    {
+        u8 score = galleryStrings[token->string + word.size()] == '\0' ? 3 : 1;
+        for (u32 i = token->first; i < token->first + token->count; i++)
+        {
+            scores[galleryPostings[i]] = std::max(scores[galleryPostings[i]], score);
+        }
+    }
+
+    for (size_t i = 0; i < matchCount; i++)
+    {
+        if (!names[i].empty() && startsWith(names[i], word))
+        {
+            scores[i] = std::max(scores[i], (u8)(names[i].size() == word.size() ? 3 : 2));
+        }
+    }
 }
 
-std::vector<nlohmann::json> MysteryGift::wondercards()
+static bool matchesFilter(size_t match, const std::string& key, const std::string& value)
 {
-    return mysteryGiftSheet["matches"];
+    size_t index = MysteryGift::wondercardIndex(match, Language::UNUSED);
+    if (index == MysteryGift::NO_CARD)
+    {
+        return false;
+    }
+    const GalleryEntry& entry = galleryEntries[index];
+    if (key == "game")
+    {
+        std::string game = galleryStrings + entry.game;
+        return startsWith(StringUtils::toLower(game), value);
+    }
+    else if (key == "lang")
+    {
+        for (int lang = Language::JP; lang <= Language::TW; lang++)
+        {
+            std::string name = i18n::langString((Language)lang);
+            if (MysteryGift::wondercardAvailable(match, (Language)lang) && startsWith(StringUtils::toLower(name), value))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    else if (key == "form")
+    {
+        return std::to_string(entry.form) == value;
+    }
+    else if (key == "type")
+    {
+        return startsWith("item", value) ? entry.species == -1 : startsWith("pkm", value) || startsWith("pokemon", value) ? entry.species != -1 : true;
+    }
+    return true;
 }
 
-MysteryGift::giftData MysteryGift::wondercardInfo(size_t index)
+std::vector<size_t> MysteryGift::search(const std::string& query)
 {
-    giftData ret;
-    nlohmann::json entry = mysteryGiftSheet["wondercards"][index];
-    ret.name = entry["name"].get<std::string>();
-    ret.game = entry["game"].get<std::string>();
-    ret.form = entry["form"];
-    ret.species = entry["species"];
-    return ret;
-}
\ No newline at end of file
+    std::vector<size_t> candidates;
+    // Typing one more character can only narrow a plain query down, so reuse what the last one found
+    if (!lastQuery.empty() && startsWith(query, lastQuery) && query.find(':') == std::string::npos)
+    {
+        candidates = lastResults;
+        std::sort(candidates.begin(), candidates.end());
+    }
+    else
+    {
+        candidates.resize(matchCount);
+        for (size_t i = 0; i < matchCount; i++)
+        {
+            candidates[i] = i;
+        }
+    }
+
+    std::vector<std::pair<int, size_t>> ranked;
+    ranked.reserve(candidates.size());
+    for (size_t match : candidates)
+    {
+        ranked.emplace_back(0, match);
+    }
+
+    std::vector<u8> scores(matchCount);
+    const std::vector<std::string>& names = lowerSpeciesNames();
+    size_t start = 0;
+    while (start < query.size())
+    {
+        size_t end = query.find(' ', start);
+        if (end == std::string::npos)
+        {
+            end = query.size();
+        }
+        std::string word = query.substr(start, end - start);
+        start = end + 1;
+
+        size_t colon = word.find(':');
+        if (colon != std::string::npos)
+        {
+            std::string key = word.substr(0, colon), value = word.substr(colon + 1);
+            StringUtils::toLower(key);
+            StringUtils::toLower(value);
+            ranked.erase(std::remove_if(ranked.begin(), ranked.end(), [&](const std::pair<int, size_t>& r) { return !matchesFilter(r.second, key, value); }), ranked.end());
+            continue;
+        }
+
+        for (auto& token : tokenize(word))
+        {
+            std::fill(scores.begin(), scores.end(), 0);
+            scoreWord(token, names, scores);
+            ranked.erase(std::remove_if(ranked.begin(), ranked.end(), [&](const std::pair<int, size_t>& r) { return scores[r.second] == 0; }), ranked.end());
+            for (auto& r : ranked)
+            {
+                r.first += scores[r.second];
+            }
+        }
+    }
+
+    std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b) { return a.first > b.first; });
+    lastQuery = query;
+    lastResults.clear();
+    for (auto& r : ranked)
+    {
+        lastResults.push_back(r.second);
+    }
+    return lastResults;
+}
@@ -1463,6 +1463,7 @@ void ExpressionParseFunctionCall(struct ParseState *Parser, struct ExpressionSta
         if (FuncValue->Typ->Base != TypeFunction)
             ProgramFail(Parser, "%t is not a function - can't call", FuncValue->Typ);
     
+        Parser->pc->FunctionCalls++;
         ExpressionStackPushValueByType(Parser, StackTop, FuncValue->Val->FuncDef.ReturnType);
         ReturnValue = (*StackTop)->Val;
         HeapPushStackFrame(Parser->pc);
@@ -1557,7 +1558,15 @@ void ExpressionParseFunctionCall(struct ParseState *Parser, struct ExpressionSta
             VariableStackFramePop(Parser);
         }
         else
+        {
+#ifdef PICOC_PROFILE
+            ProfileNativeBegin(Parser->pc);
+#endif
             FuncValue->Val->FuncDef.Intrinsic(Parser, ReturnValue, ParamArray, ArgCount);
+#ifdef PICOC_PROFILE
+            ProfileNativeEnd(Parser, FuncName);
+#endif
+        }
 
         HeapPopStackFrame(Parser->pc);
     }
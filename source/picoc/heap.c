@@ -76,6 +76,9 @@ void *HeapAllocStack(Picoc *pc, int Size)
         
     pc->HeapStackTop = (void *)NewTop;
     memset((void *)NewMem, '\0', Size);
+#ifdef PICOC_PROFILE
+    ProfileStackUsed(pc, NewTop - (char *)&(pc->HeapMemory)[0]);
+#endif
     return NewMem;
 }
 
@@ -135,7 +138,19 @@ int HeapPopStackFrame(Picoc *pc)
 void *HeapAllocMem(Picoc *pc, int Size)
 {
 #ifdef USE_MALLOC_HEAP
+# ifdef PICOC_PROFILE
+    /* keep the size in front of the memory so it can be accounted for when it's freed */
+    int *NewMem = calloc(MEM_ALIGN(sizeof(int)) + Size, 1);
+    
+    if (NewMem == NULL)
+        return NULL;
+    
+    *NewMem = Size;
+    ProfileHeapAlloc(pc, Size);
+    return (char *)NewMem + MEM_ALIGN(sizeof(int));
+# else
     return calloc(Size, 1);
+# endif
 #else
     struct AllocNode *NewMem = NULL;
     struct AllocNode **FreeNode;
@@ -215,6 +230,9 @@ void *HeapAllocMem(Picoc *pc, int Size)
     
     ReturnMem = (void *)((char *)NewMem + MEM_ALIGN(sizeof(NewMem->Size)));
     memset(ReturnMem, '\0', AllocSize - MEM_ALIGN(sizeof(NewMem->Size)));
+#ifdef PICOC_PROFILE
+    ProfileHeapAlloc(pc, AllocSize);
+#endif
 #ifdef DEBUG_HEAP
     printf(" = %lx\n", (unsigned long)ReturnMem);
 #endif
@@ -226,6 +244,13 @@ void *HeapAllocMem(Picoc *pc, int Size)
 void HeapFreeMem(Picoc *pc, void *Mem)
 {
 #ifdef USE_MALLOC_HEAP
+# ifdef PICOC_PROFILE
+    if (Mem == NULL)
+        return;
+    
+    Mem = (char *)Mem - MEM_ALIGN(sizeof(int));
+    ProfileHeapFree(pc, *(int *)Mem);
+# endif
     free(Mem);
 #else
     struct AllocNode *MemNode = (struct AllocNode *)((char *)Mem - MEM_ALIGN(sizeof(MemNode->Size)));
@@ -239,6 +264,9 @@ void HeapFreeMem(Picoc *pc, void *Mem)
     if (Mem == NULL)
         return;
     
+#ifdef PICOC_PROFILE
+    ProfileHeapFree(pc, MemNode->Size);
+#endif
     if ((void *)MemNode == pc->HeapBottom)
     { 
         /* pop it off the bottom of the heap, reducing the heap size */
@@ -719,6 +719,118 @@ void *LexAnalyse(Picoc *pc, const char *FileName, const char *Source, int Source
     return LexTokenise(pc, &Lexer, TokenLen);
 }
 
+/* make a copy of a token buffer which doesn't point into this interpreter's string table, so it can
+ * outlive PicocCleanup() and be reused by a later run. Shared strings are replaced by offsets into a
+ * block following the tokens, where each is kept as its length and then its characters, since string
+ * literals can have '\0's inside them. The copy is allocated with malloc() */
+void *LexTokensSave(Picoc *pc, const void *Tokens, int TokenLen)
+{
+    unsigned char *Pos = (unsigned char *)Tokens;
+    int StringsLen = 0;
+    enum LexToken Token;
+    char *Saved;
+    char *StringPos;
+    
+    /* size up the strings first */
+    do
+    {
+        Token = (enum LexToken)*Pos;
+        Pos += TOKEN_DATA_OFFSET;
+        if (Token == TokenIdentifier || Token == TokenStringConstant)
+        {
+            char *String;
+            
+            memcpy((void *)&String, (void *)Pos, sizeof(char *));
+            StringsLen += sizeof(int) + TableStrLen(String);
+        }
+        
+        Pos += LexTokenSize(Token);
+    } while (Token != TokenEOF);
+    
+    Saved = malloc(TokenLen + StringsLen);
+    if (Saved == NULL)
+        return NULL;
+    
+    memcpy(Saved, Tokens, TokenLen);
+    StringPos = Saved + TokenLen;
+    Pos = (unsigned char *)Saved;
+    do
+    {
+        Token = (enum LexToken)*Pos;
+        Pos += TOKEN_DATA_OFFSET;
+        if (Token == TokenIdentifier || Token == TokenStringConstant)
+        {
+            char *String;
+            uintptr_t Offset = StringPos - Saved;
+            int Len;
+            
+            memcpy((void *)&String, (void *)Pos, sizeof(char *));
+            Len = TableStrLen(String);
+            memcpy(StringPos, (void *)&Len, sizeof(int));
+            memcpy(StringPos + sizeof(int), String, Len);
+            memcpy((void *)Pos, (void *)&Offset, sizeof(char *));
+            StringPos += sizeof(int) + Len;
+        }
+        
+        Pos += LexTokenSize(Token);
+    } while (Token != TokenEOF);
+    
+    return Saved;
+}
+
+/* rebuild a token buffer saved by LexTokensSave() on the heap, registering its strings and string literals again */
+void *LexTokensRestore(Picoc *pc, const void *Saved)
+{
+    const unsigned char *End = (const unsigned char *)Saved;
+    unsigned char *Tokens;
+    unsigned char *Pos;
+    enum LexToken Token;
+    
+    /* only the tokens are copied, not the string block after them */
+    do
+    {
+        Token = (enum LexToken)*End;
+        End += TOKEN_DATA_OFFSET + LexTokenSize(Token);
+    } while (Token != TokenEOF);
+    
+    Tokens = HeapAllocMem(pc, End - (const unsigned char *)Saved);
+    if (Tokens == NULL)
+        ProgramFailNoParser(pc, "out of memory");
+    
+    memcpy(Tokens, Saved, End - (const unsigned char *)Saved);
+    Pos = Tokens;
+    do
+    {
+        Token = (enum LexToken)*Pos;
+        Pos += TOKEN_DATA_OFFSET;
+        if (Token == TokenIdentifier || Token == TokenStringConstant)
+        {
+            uintptr_t Offset;
+            char *RegString;
+            int Len;
+            
+            /* tokens and the lengths in the string block aren't aligned */
+            memcpy((void *)&Offset, (void *)Pos, sizeof(char *));
+            memcpy((void *)&Len, (const char *)Saved + Offset, sizeof(int));
+            RegString = TableStrRegister2(pc, (const char *)Saved + Offset + sizeof(int), Len);
+            if (Token == TokenStringConstant && VariableStringLiteralGet(pc, RegString) == NULL)
+            {
+                /* same as LexGetStringConstant() */
+                struct Value *ArrayValue = VariableAllocValueAndData(pc, NULL, 0, FALSE, NULL, TRUE);
+                ArrayValue->Typ = pc->CharArrayType;
+                ArrayValue->Val = (union AnyValue *)RegString;
+                VariableStringLiteralDefine(pc, RegString, ArrayValue);
+            }
+            
+            memcpy((void *)Pos, (void *)&RegString, sizeof(char *));
+        }
+        
+        Pos += LexTokenSize(Token);
+    } while (Token != TokenEOF);
+    
+    return Tokens;
+}
+
 /* prepare to parse a pre-tokenised buffer */
 void LexInitParser(struct ParseState *Parser, Picoc *pc, const char *SourceText, void *TokenSource, char *FileName, int RunIt, int EnableDebugger)
 {
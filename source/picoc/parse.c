@@ -578,6 +578,11 @@ enum ParseResult ParseStatement(struct ParseState *Parser, int CheckTrailingSemi
     if (Parser->DebugMode && Parser->Mode == RunModeRun)
         DebugCheckStatement(Parser);
     
+#ifdef PICOC_PROFILE
+    if (Parser->Mode == RunModeRun)
+        ProfileStatement(Parser);
+#endif
+    
     /* take note of where we are and then grab a token to see what statement we have */   
     ParserCopy(&PreState, Parser);
     Token = LexGetToken(Parser, &LexerValue, TRUE);
@@ -934,14 +939,21 @@ enum ParseResult ParseStatement(struct ParseState *Parser, int CheckTrailingSemi
 
 /* quick scan a source file for definitions */
 void PicocParse(Picoc *pc, const char *FileName, const char *Source, int SourceLen, int RunIt, int CleanupNow, int CleanupSource, int EnableDebugger)
+{
+    char *RegFileName = TableStrRegister(pc, FileName);
+    void *Tokens = LexAnalyse(pc, RegFileName, Source, SourceLen, NULL);
+    
+    PicocParseTokens(pc, RegFileName, Source, Tokens, RunIt, CleanupNow, CleanupSource, EnableDebugger);
+}
+
+/* quick scan an already tokenised source file for definitions. Takes ownership of the heap allocated tokens */
+void PicocParseTokens(Picoc *pc, const char *FileName, const char *Source, void *Tokens, int RunIt, int CleanupNow, int CleanupSource, int EnableDebugger)
 {
     struct ParseState Parser;
     enum ParseResult Ok;
     struct CleanupTokenNode *NewCleanupNode;
     char *RegFileName = TableStrRegister(pc, FileName);
     
-    void *Tokens = LexAnalyse(pc, RegFileName, Source, SourceLen, NULL);
-    
     /* allocate a cleanup node so we can clean up the tokens later */
     if (!CleanupNow)
     {
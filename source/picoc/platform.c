@@ -26,11 +26,17 @@ void PicocInitialise(Picoc *pc, int StackSize)
 #endif
     PlatformLibraryInit(pc);
     DebugInit(pc);
+#ifdef PICOC_PROFILE
+    ProfileInit(pc);
+#endif
 }
 
 /* free memory */
 void PicocCleanup(Picoc *pc)
 {
+#ifdef PICOC_PROFILE
+    ProfileCleanup(pc);
+#endif
     DebugCleanup(pc);
 #ifndef NO_HASH_INCLUDE
     IncludeCleanup(pc);
@@ -22,11 +22,19 @@ struct LibraryFunction UnixFunctions[] =
     { sav_get_pkx,      "void sav_get_pkx(char* data, int box, int slot);" },
     { sav_inject_pkx,   "void sav_inject_pkx(char* data, enum Generation type, int box, int slot);" },
     { sav_inject_ekx,   "void sav_inject_ekx(char* data, enum Generation type, int box, int slot);" },
+    { sav_get_pkx_range,    "int sav_get_pkx_range(char* data, int box, int slot, int count);" },
+    { sav_inject_pkx_range, "int sav_inject_pkx_range(char* data, enum Generation type, int box, int slot, int count);" },
+    { sav_find_slots,   "int sav_find_slots(int* out, int max, int species);" },
+    { sav_box_data,     "char* sav_box_data(int box);" },
     { party_get_pkx,    "void party_get_pkx(char* data, int slot);" },
     { bank_inject_pkx,  "void bank_inject_pkx(char* data, enum Generation type, int box, int slot);" },
     // io
     { current_directory,"char* current_directory();" },
     { read_directory,   "struct directory* read_directory(char* dir);" },
+    // backups
+    { backup_count,     "int backup_count(char* name);" },
+    { backup_restore,   "int backup_restore(char* name, int index, char* path);" },
+    { backup_prune,     "int backup_prune(char* name, int keep);" },
     // configurations
     { cfg_default_ot,   "char* cfg_default_ot();" },
     { cfg_default_tid,  "unsigned int cfg_default_tid();" },
@@ -30,6 +30,7 @@
 #include "ThirtyChoice.hpp"
 #include "loader.hpp"
 #include "STDirectory.hpp"
+#include "BackupStore.hpp"
 #include "PB7.hpp"
 #include "PK4.hpp"
 #include "PK5.hpp"
@@ -42,7 +43,170 @@
 
 extern "C" {
 #include "pksm_api.h"
+}
+
+// Length of a stored Pokemon of the given generation, as a script lays them out in its buffers
+static size_t pkmLength(Generation gen)
+{
+    switch (gen)
+    {
+        case Generation::FOUR:
+        case Generation::FIVE:
+            return 136;
+        case Generation::SIX:
+        case Generation::SEVEN:
+            return 232;
+        case Generation::LGPE:
+            return 260;
+        default:
+            return 0;
+    }
+}
+
+// Converts and checks a script's Pokemon for the loaded save and puts it in the box slot.
+// Returns whether it was injected; failures are reported with a warning if warnUser is set
+static bool injectPkm(u8* data, Generation gen, bool ekx, int box, int slot, bool warnUser, std::string* errorOut = nullptr)
+{
+    std::unique_ptr<PKX> pkm = nullptr;
+
+    switch (gen)
+    {
+        case Generation::FOUR:
+            pkm = std::make_unique<PK4>(data, ekx);
+            break;
+        case Generation::FIVE:
+            pkm = std::make_unique<PK5>(data, ekx);
+            break;
+        case Generation::SIX:
+            pkm = std::make_unique<PK6>(data, ekx);
+            break;
+        case Generation::SEVEN:
+            pkm = std::make_unique<PK7>(data, ekx);
+            break;
+        case Generation::LGPE:
+            pkm = std::make_unique<PB7>(data, ekx);
+            break;
+        default:
+            Gui::warn("What did you do?", "Generation is incorrect!");
+    }
+
+    if (pkm)
+    {
+        if (TitleLoader::save->generation() == Generation::LGPE)
+        {
+            if (pkm->generation() == Generation::LGPE)
+            {
+                TitleLoader::save->pkm(*pkm, box, slot);
+                return true;
+            }
+        }
+        else
+        {
+            if (pkm->generation() != Generation::LGPE)
+            {
+                while (pkm->generation() != TitleLoader::save->generation())
+                {
+                    if (pkm->generation() < TitleLoader::save->generation())
+                    {
+                        pkm = pkm->next();
+                    }
+                    else
+                    {
+                        pkm = pkm->previous();
+                    }
+                }
+                u8 (*formCounter)(u16);
+                switch (TitleLoader::save->generation())
+                {
+                    case Generation::FOUR:
+                        formCounter = PersonalDPPtHGSS::formCount;
+                        break;
+                    case Generation::FIVE:
+                        formCounter = PersonalBWB2W2::formCount;
+                        break;
+                    case Generation::SIX:
+                        formCounter = PersonalXYORAS::formCount;
+                        break;
+                    case Generation::SEVEN:
+                    default:
+                        formCounter = PersonalSMUSUM::formCount;
+                        break;
+                }
+                std::string error;
+                bool moveBad = false;
+                for (int i = 0; i < 4; i++)
+                {
+                    if (pkm->move(i) > TitleLoader::save->maxMove())
+                    {
+                        moveBad = true;
+                        break;
+                    }
+                    if (pkm->generation() == Generation::SIX)
+                    {
+                        PK6* pk6 = (PK6*) pkm.get();
+                        if (pk6->relearnMove(i) > TitleLoader::save->maxMove())
+                        {
+                            moveBad = true;
+                            break;
+                        }
+                    }
+                    else if (pkm->generation() == Generation::SEVEN)
+                    {
+                        PK7* pk7 = (PK7*) pkm.get();
+                        if (pk7->relearnMove(i) > TitleLoader::save->maxMove())
+                        {
+                            moveBad = true;
+                            break;
+                        }
+                    }
+                }
+                if (pkm->species() > TitleLoader::save->maxSpecies())
+                {
+                    error = i18n::localize("STORAGE_BAD_SPECIES");
+                }
+                else if (pkm->alternativeForm() > formCounter(pkm->species()))
+                {
+                    error = i18n::localize("STORAGE_BAD_FORM");
+                }
+                else if (pkm->ability() > TitleLoader::save->maxAbility())
+                {
+                    error = i18n::localize("STORAGE_BAD_ABILITY");
+                }
+                else if (pkm->heldItem() > TitleLoader::save->maxItem())
+                {
+                    error = i18n::localize("STORAGE_BAD_ITEM");
+                }
+                else if (pkm->ball() > TitleLoader::save->maxBall())
+                {
+                    error = i18n::localize("STORAGE_BAD_BALL");
+                }
+                else if (moveBad)
+                {
+                    error = i18n::localize("STORAGE_BAD_MOVE");
+                }
+
+                if (!error.empty())
+                {
+                    if (warnUser)
+                    {
+                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), error);
+                    }
+                    if (errorOut)
+                    {
+                        *errorOut = error;
+                    }
+                    return false;
+                }
+                TitleLoader::save->pkm(*pkm, box, slot);
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
+
+extern "C" {
     void gui_warn(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
     {
         char* lineOne = (char*) Param[0]->Val->Pointer;
@@ -230,6 +394,25 @@ extern "C" {
         ReturnValue->Val->Pointer = ret;
     }
 
+    void backup_count(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        ReturnValue->Val->Integer = BackupStore::count((char*)Param[0]->Val->Pointer);
+    }
+
+    void backup_restore(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        std::string name = (char*)Param[0]->Val->Pointer;
+        int index = Param[1]->Val->Integer;
+        std::string path = (char*)Param[2]->Val->Pointer;
+        ReturnValue->Val->Integer = index >= 0 && BackupStore::restore(name, index, path) ? 1 : 0;
+    }
+
+    void backup_prune(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        int keep = Param[1]->Val->Integer;
+        ReturnValue->Val->Integer = BackupStore::prune((char*)Param[0]->Val->Pointer, keep < 0 ? 0 : keep);
+    }
+
     void sav_inject_pkx(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
     {
         u8* data = (u8*) Param[0]->Val->Pointer;
@@ -237,132 +420,7 @@ extern "C" {
         int box = Param[2]->Val->Integer;
         int slot = Param[3]->Val->Integer;
 
-        std::unique_ptr<PKX> pkm = nullptr;
-
-        switch (gen)
-        {
-            case Generation::FOUR:
-                pkm = std::make_unique<PK4>(data, false);
-                break;
-            case Generation::FIVE:
-                pkm = std::make_unique<PK5>(data, false);
-                break;
-            case Generation::SIX:
-                pkm = std::make_unique<PK6>(data, false);
-                break;
-            case Generation::SEVEN:
-                pkm = std::make_unique<PK7>(data, false);
-                break;
-            case Generation::LGPE:
-                pkm = std::make_unique<PB7>(data, false);
-                break;
-            default:
-                Gui::warn("What did you do?", "Generation is incorrect!");
-        }
-
-        if (pkm)
-        {
-            if (TitleLoader::save->generation() == Generation::LGPE)
-            {
-                if (pkm->generation() == Generation::LGPE)
-                {
-                    TitleLoader::save->pkm(*pkm, box, slot);
-                }
-            }
-            else
-            {
-                if (pkm->generation() != Generation::LGPE)
-                {
-                    while (pkm->generation() != TitleLoader::save->generation())
-                    {
-                        if (pkm->generation() < TitleLoader::save->generation())
-                        {
-                            pkm = pkm->next();
-                        }
-                        else
-                        {
-                            pkm = pkm->previous();
-                        }
-                    }
-                    u8 (*formCounter)(u16);
-                    switch (TitleLoader::save->generation())
-                    {
-                        case Generation::FOUR:
-                            formCounter = PersonalDPPtHGSS::formCount;
-                            break;
-                        case Generation::FIVE:
-                            formCounter = PersonalBWB2W2::formCount;
-                            break;
-                        case Generation::SIX:
-                            formCounter = PersonalXYORAS::formCount;
-                            break;
-                        case Generation::SEVEN:
-                        default:
-                            formCounter = PersonalSMUSUM::formCount;
-                            break;
-                    }
-                    bool moveBad = false;
-                    for (int i = 0; i < 4; i++)
-                    {
-                        if (pkm->move(i) > TitleLoader::save->maxMove())
-                        {
-                            moveBad = true;
-                            break;
-                        }
-                        if (pkm->generation() == Generation::SIX)
-                        {
-                            PK6* pk6 = (PK6*) pkm.get();
-                            if (pk6->relearnMove(i) > TitleLoader::save->maxMove())
-                            {
-                                moveBad = true;
-                                break;
-                            }
-                        }
-                        else if (pkm->generation() == Generation::SEVEN)
-                        {
-                            PK7* pk7 = (PK7*) pkm.get();
-                            if (pk7->relearnMove(i) > TitleLoader::save->maxMove())
-                            {
-                                moveBad = true;
-                                break;
-                            }
-                        }
-                    }
-                    if (pkm->species() > TitleLoader::save->maxSpecies())
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_SPECIES"));
-                        return;
-                    }
-                    else if (pkm->alternativeForm() > formCounter(pkm->species()))
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_FORM"));
-                        return;
-                    }
-                    else if (pkm->ability() > TitleLoader::save->maxAbility())
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_ABILITY"));
-                        return;
-                    }
-                    else if (pkm->heldItem() > TitleLoader::save->maxItem())
-                    {
-                        
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_ITEM"));
-                        return;
-                    }
-                    else if (pkm->ball() > TitleLoader::save->maxBall())
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_BALL"));
-                        return;
-                    }
-                    else if (moveBad)
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_MOVE"));
-                        return;
-                    }
-                    TitleLoader::save->pkm(*pkm, box, slot);
-                }
-            }
-        }
+        injectPkm(data, gen, false, box, slot, true);
     }
 
     void sav_inject_ekx(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
@@ -372,132 +430,34 @@ extern "C" {
         int box = Param[2]->Val->Integer;
         int slot = Param[3]->Val->Integer;
 
-        std::unique_ptr<PKX> pkm = nullptr;
+        injectPkm(data, gen, true, box, slot, true);
+    }
 
-        switch (gen)
-        {
-            case Generation::FOUR:
-                pkm = std::make_unique<PK4>(data, true);
-                break;
-            case Generation::FIVE:
-                pkm = std::make_unique<PK5>(data, true);
-                break;
-            case Generation::SIX:
-                pkm = std::make_unique<PK6>(data, true);
-                break;
-            case Generation::SEVEN:
-                pkm = std::make_unique<PK7>(data, true);
-                break;
-            case Generation::LGPE:
-                pkm = std::make_unique<PB7>(data, true);
-                break;
-            default:
-                Gui::warn("What did you do?", "Generation is incorrect!");
-        }
+    void sav_inject_pkx_range(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        u8* data = (u8*) Param[0]->Val->Pointer;
+        Generation gen = Generation(Param[1]->Val->Integer);
+        int box = Param[2]->Val->Integer;
+        int slot = Param[3]->Val->Integer;
+        int count = Param[4]->Val->Integer;
 
-        if (pkm)
+        size_t length = pkmLength(gen);
+        int injected = 0;
+        std::string error;
+        for (int i = 0; length != 0 && i < count && box * 30 + slot < TitleLoader::save->maxSlot(); i++)
         {
-            if (TitleLoader::save->generation() == Generation::LGPE)
+            // Only the first failure is shown so a bad batch doesn't turn into hundreds of warnings
+            if (injectPkm(data + i * length, gen, false, box, slot, error.empty(), &error))
             {
-                if (pkm->generation() == Generation::LGPE)
-                {
-                    TitleLoader::save->pkm(*pkm, box, slot);
-                }
+                injected++;
             }
-            else
+            if (++slot == 30)
             {
-                if (pkm->generation() != Generation::LGPE)
-                {
-                    while (pkm->generation() != TitleLoader::save->generation())
-                    {
-                        if (pkm->generation() < TitleLoader::save->generation())
-                        {
-                            pkm = pkm->next();
-                        }
-                        else
-                        {
-                            pkm = pkm->previous();
-                        }
-                    }
-                    u8 (*formCounter)(u16);
-                    switch (TitleLoader::save->generation())
-                    {
-                        case Generation::FOUR:
-                            formCounter = PersonalDPPtHGSS::formCount;
-                            break;
-                        case Generation::FIVE:
-                            formCounter = PersonalBWB2W2::formCount;
-                            break;
-                        case Generation::SIX:
-                            formCounter = PersonalXYORAS::formCount;
-                            break;
-                        case Generation::SEVEN:
-                        default:
-                            formCounter = PersonalSMUSUM::formCount;
-                            break;
-                    }
-                    bool moveBad = false;
-                    for (int i = 0; i < 4; i++)
-                    {
-                        if (pkm->move(i) > TitleLoader::save->maxMove())
-                        {
-                            moveBad = true;
-                            break;
-                        }
-                        if (pkm->generation() == Generation::SIX)
-                        {
-                            PK6* pk6 = (PK6*) pkm.get();
-                            if (pk6->relearnMove(i) > TitleLoader::save->maxMove())
-                            {
-                                moveBad = true;
-                                break;
-                            }
-                        }
-                        else if (pkm->generation() == Generation::SEVEN)
-                        {
-                            PK7* pk7 = (PK7*) pkm.get();
-                            if (pk7->relearnMove(i) > TitleLoader::save->maxMove())
-                            {
-                                moveBad = true;
-                                break;
-                            }
-                        }
-                    }
-                    if (pkm->species() > TitleLoader::save->maxSpecies())
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_SPECIES"));
-                        return;
-                    }
-                    else if (pkm->alternativeForm() > formCounter(pkm->species()))
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_FORM"));
-                        return;
-                    }
-                    else if (pkm->ability() > TitleLoader::save->maxAbility())
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_ABILITY"));
-                        return;
-                    }
-                    else if (pkm->heldItem() > TitleLoader::save->maxItem())
-                    {
-                        
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_ITEM"));
-                        return;
-                    }
-                    else if (pkm->ball() > TitleLoader::save->maxBall())
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_BALL"));
-                        return;
-                    }
-                    else if (moveBad)
-                    {
-                        Gui::warn(i18n::localize("STORAGE_BAD_TRANFER"), i18n::localize("STORAGE_BAD_MOVE"));
-                        return;
-                    }
-                    TitleLoader::save->pkm(*pkm, box, slot);
-                }
+                slot = 0;
+                box++;
             }
         }
+        ReturnValue->Val->Integer = injected;
     }
 
     void cfg_default_ot(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
@@ -730,6 +690,54 @@ extern "C" {
         memcpy(data, pkm.get()->rawData(), pkm.get()->getLength());
     }
 
+    void sav_get_pkx_range(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        u8* data = (u8*) Param[0]->Val->Pointer;
+        int box = Param[1]->Val->Integer;
+        int slot = Param[2]->Val->Integer;
+        int count = Param[3]->Val->Integer;
+
+        int copied = 0;
+        for (int index = box * 30 + slot; copied < count && index < TitleLoader::save->maxSlot(); index++, copied++)
+        {
+            auto pkm = TitleLoader::save->pkm(index / 30, index % 30);
+            memcpy(data, pkm->rawData(), pkm->getLength());
+            data += pkm->getLength();
+        }
+        ReturnValue->Val->Integer = copied;
+    }
+
+    void sav_find_slots(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        int* out = (int*) Param[0]->Val->Pointer;
+        int max = Param[1]->Val->Integer;
+        int species = Param[2]->Val->Integer;
+
+        int found = 0;
+        for (int index = 0; found < max && index < TitleLoader::save->maxSlot(); index++)
+        {
+            u16 slotSpecies = TitleLoader::save->pkm(index / 30, index % 30)->species();
+            // -1 finds empty slots, 0 any Pokemon, anything else that species
+            if ((species == -1 && slotSpecies == 0) || (species == 0 && slotSpecies != 0) || (species > 0 && slotSpecies == species))
+            {
+                out[found++] = index;
+            }
+        }
+        ReturnValue->Val->Integer = found;
+    }
+
+    void sav_box_data(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
+    {
+        int box = Param[0]->Val->Integer;
+
+        if (box < 0 || box >= TitleLoader::save->maxBoxes())
+        {
+            ReturnValue->Val->Pointer = nullptr;
+            return;
+        }
+        ReturnValue->Val->Pointer = TitleLoader::save->rawData() + TitleLoader::save->boxOffset(box, 0);
+    }
+
     void party_get_pkx(struct ParseState *Parser, struct Value *ReturnValue, struct Value **Param, int NumArgs)
     {
         u8* data = (u8*) Param[0]->Val->Pointer;
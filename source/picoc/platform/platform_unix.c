@@ -1,5 +1,46 @@
 #include "picoc.h"
 #include "interpreter.h"
+#include "sha256.h"
+
+#define TOKEN_CACHE_SIZE 8                  /* number of tokenised scripts remembered between runs */
+
+/* tokenised scripts, keyed by the hash of their source text, for scripts which get a fresh interpreter:
+ * a different script from the last one, or one which can't be kept (see Kept below). The tokens outlive
+ * the interpreter, so they're kept in a relocatable form (see LexTokensSave()) */
+struct TokenCacheEntry
+{
+    unsigned char Hash[SHA256_BLOCK_SIZE];
+    void *Tokens;
+};
+
+static struct TokenCacheEntry TokenCache[TOKEN_CACHE_SIZE];
+static int TokenCacheNext = 0;
+
+/* a global of the kept script, with the data its declarations left it */
+struct KeptGlobal
+{
+    struct Value *Val;
+    int Size;                               /* 0 for functions, macros and platform variables */
+    int Offset;                             /* of the data in Kept.Data */
+};
+
+/* the interpreter of the last script run, kept so running the same script again goes straight to
+ * main(). Once the script is scanned the data of its globals is saved, and before each repeat run
+ * the globals defined since (static locals, main()'s arguments) are removed and the rest put back,
+ * which leaves the interpreter as a fresh scan would. A script whose declarations call functions
+ * could have done anything, so it's scanned afresh every time */
+static struct
+{
+    Picoc *pc;                              /* the interpreter initialised here, or NULL */
+    unsigned char Hash[SHA256_BLOCK_SIZE];  /* of the file it runs */
+    char *FileName;                         /* NULL if the file can't be hashed */
+    int Ready;                              /* its globals are as the scan left them */
+    struct KeptGlobal *Globals;             /* sorted by Val, NULL if the script can't be kept */
+    int NumGlobals;
+    char *Data;
+    void *StackTop;                         /* where the stack was after the scan */
+    struct ValueType *Types;                /* the newest struct, union or enum after the scan */
+} Kept;
 
 /* mark where to end the program for platforms which require this */
 jmp_buf PicocExitBuf;
@@ -65,7 +106,8 @@ char *PlatformReadFile(Picoc *pc, const char *FileName)
     if (stat(FileName, &FileInfo))
         ProgramFailNoParser(pc, "can't read file %s\n", FileName);
     
-    ReadText = malloc(FileInfo.st_size + 1);
+    /* freed along with the tokens by HeapFreeMem() */
+    ReadText = HeapAllocMem(pc, FileInfo.st_size + 1);
     if (ReadText == NULL)
         ProgramFailNoParser(pc, "out of memory\n");
         
@@ -91,6 +133,35 @@ char *PlatformReadFile(Picoc *pc, const char *FileName)
     return ReadText;    
 }
 
+/* tokenise a source file, reusing the tokens from an earlier run of the same source if possible */
+static void *PlatformTokenise(Picoc *pc, const char *FileName, char *SourceStr)
+{
+    unsigned char Hash[SHA256_BLOCK_SIZE];
+    int SourceLen = strlen(SourceStr);
+    struct TokenCacheEntry *Entry;
+    void *Tokens;
+    int TokenLen;
+    int Count;
+    
+    sha256(Hash, (unsigned char *)SourceStr, SourceLen);
+    for (Count = 0; Count < TOKEN_CACHE_SIZE; Count++)
+    {
+        if (TokenCache[Count].Tokens != NULL && memcmp(TokenCache[Count].Hash, Hash, SHA256_BLOCK_SIZE) == 0)
+            return LexTokensRestore(pc, TokenCache[Count].Tokens);
+    }
+    
+    Tokens = LexAnalyse(pc, TableStrRegister(pc, FileName), SourceStr, SourceLen, &TokenLen);
+    
+    /* replace the oldest entry */
+    Entry = &TokenCache[TokenCacheNext];
+    TokenCacheNext = (TokenCacheNext + 1) % TOKEN_CACHE_SIZE;
+    free(Entry->Tokens);
+    Entry->Tokens = LexTokensSave(pc, Tokens, TokenLen);
+    memcpy(Entry->Hash, Hash, SHA256_BLOCK_SIZE);
+    
+    return Tokens;
+}
+
 /* read and scan a file for definitions */
 void PicocPlatformScanFile(Picoc *pc, const char *FileName)
 {
@@ -103,7 +174,179 @@ void PicocPlatformScanFile(Picoc *pc, const char *FileName)
         SourceStr[1] = '/'; 
     }
 
-    PicocParse(pc, FileName, SourceStr, strlen(SourceStr), TRUE, FALSE, TRUE, TRUE);
+    PicocParseTokens(pc, FileName, SourceStr, PlatformTokenise(pc, FileName, SourceStr), TRUE, FALSE, TRUE, TRUE);
+}
+
+/* hash a file, FALSE if it can't be read */
+static int PlatformHashFile(const char *FileName, unsigned char *Hash)
+{
+    SHA256_CTX Context;
+    unsigned char Buf[4096];
+    FILE *InFile = fopen(FileName, "rb");
+    size_t BytesRead;
+    
+    if (InFile == NULL)
+        return FALSE;
+    
+    sha256_init(&Context);
+    while ((BytesRead = fread(Buf, 1, sizeof(Buf), InFile)) > 0)
+        sha256_update(&Context, Buf, BytesRead);
+    
+    sha256_final(&Context, Hash);
+    fclose(InFile);
+    return TRUE;
+}
+
+static int KeptGlobalCompare(const void *Key, const void *Global)
+{
+    const struct Value *Val = ((const struct KeptGlobal *)Key)->Val;
+    const struct Value *Other = ((const struct KeptGlobal *)Global)->Val;
+    
+    return (Val > Other) - (Val < Other);
+}
+
+/* save the globals of a freshly scanned script */
+static void KeptSave(Picoc *pc)
+{
+    struct TableEntry *Entry;
+    struct Value *Val;
+    int DataSize = 0;
+    int Count;
+    
+    Kept.Globals = malloc(sizeof(struct KeptGlobal) * pc->GlobalTable.Count);
+    if (Kept.Globals == NULL)
+        return;
+    
+    Kept.NumGlobals = 0;
+    for (Count = 0; Count < pc->GlobalTable.Size; Count++)
+    {
+        for (Entry = pc->GlobalTable.HashTable[Count]; Entry != NULL; Entry = Entry->Next)
+        {
+            struct KeptGlobal *Global = &Kept.Globals[Kept.NumGlobals++];
+            
+            Val = Entry->p.v.Val;
+            Global->Val = Val;
+            Global->Size = 0;
+            Global->Offset = DataSize;
+            
+            /* only the data a value owns is the script's, a platform variable's belongs to the library */
+            if (Val->Typ->Base != TypeFunction && Val->Typ->Base != TypeMacro && 
+                    (Val->AnyValOnHeap || (char *)Val->Val == (char *)Val + MEM_ALIGN(sizeof(struct Value))))
+            {
+                Global->Size = TypeSizeValue(Val, TRUE);
+                DataSize += Global->Size;
+            }
+        }
+    }
+    
+    Kept.Data = malloc(DataSize + 1);
+    if (Kept.Data == NULL)
+    {
+        free(Kept.Globals);
+        Kept.Globals = NULL;
+        return;
+    }
+    
+    for (Count = 0; Count < Kept.NumGlobals; Count++)
+        memcpy(&Kept.Data[Kept.Globals[Count].Offset], Kept.Globals[Count].Val->Val, Kept.Globals[Count].Size);
+    
+    qsort(Kept.Globals, Kept.NumGlobals, sizeof(struct KeptGlobal), KeptGlobalCompare);
+    Kept.StackTop = pc->HeapStackTop;
+    Kept.Types = pc->UberType.DerivedTypeList;
+}
+
+/* put the globals back as the scan left them */
+static void KeptRestore(Picoc *pc)
+{
+    struct TableEntry *Entry;
+    struct TableEntry *NextEntry;
+    struct KeptGlobal *Global;
+    int Count;
+    
+    for (Count = 0; Count < pc->GlobalTable.Size; Count++)
+    {
+        for (Entry = pc->GlobalTable.HashTable[Count]; Entry != NULL; Entry = NextEntry)
+        {
+            struct KeptGlobal Key;
+            
+            NextEntry = Entry->Next;
+            Key.Val = Entry->p.v.Val;
+            Global = bsearch(&Key, Kept.Globals, Kept.NumGlobals, sizeof(struct KeptGlobal), KeptGlobalCompare);
+            if (Global == NULL)
+                VariableFree(pc, TableDelete(pc, &pc->GlobalTable, Entry->p.v.Key));
+            else
+                memcpy(Global->Val->Val, &Kept.Data[Global->Offset], Global->Size);
+        }
+    }
+    
+    pc->PicocExitValue = 0;
+#ifdef PICOC_PROFILE
+    ProfileCleanup(pc);
+    ProfileInit(pc);
+#endif
+}
+
+/* get an interpreter ready to run a script file with PicocPlatformRunFile(): the one kept from the
+ * last run if that was the same file and it finished, otherwise a fresh one. Only one interpreter is
+ * kept at a time, and one which was given here has to be freed with PicocPlatformReleaseFile() rather
+ * than PicocCleanup(). Returns TRUE if the interpreter was kept */
+int PicocPlatformPrepareFile(Picoc *pc, const char *FileName, int StackSize)
+{
+    unsigned char Hash[SHA256_BLOCK_SIZE];
+    int Hashed = PlatformHashFile(FileName, Hash);
+    
+    if (Kept.pc == pc && Kept.Ready && Hashed && memcmp(Kept.Hash, Hash, SHA256_BLOCK_SIZE) == 0 && 
+            strcmp(Kept.FileName, FileName) == 0)
+    {
+        KeptRestore(pc);
+        return TRUE;
+    }
+    
+    if (Kept.pc != NULL)
+        PicocPlatformReleaseFile(Kept.pc);
+    
+    PicocInitialise(pc, StackSize);
+    Kept.pc = pc;
+    if (Hashed)
+    {
+        memcpy(Kept.Hash, Hash, SHA256_BLOCK_SIZE);
+        Kept.FileName = strdup(FileName);
+    }
+    
+    return FALSE;
+}
+
+/* run a script file's main() in an interpreter from PicocPlatformPrepareFile(), scanning the file
+ * first unless the interpreter was kept */
+void PicocPlatformRunFile(Picoc *pc, const char *FileName, int argc, char **argv)
+{
+    if (!Kept.Ready)
+    {
+        int FunctionCalls = pc->FunctionCalls;
+        
+        PicocPlatformScanFile(pc, FileName);
+        if (Kept.FileName != NULL && pc->FunctionCalls == FunctionCalls)
+            KeptSave(pc);
+    }
+    
+    /* a run which exits or fails doesn't come back here, and leaves the interpreter to be thrown away */
+    Kept.Ready = FALSE;
+    PicocCallMain(pc, argc, argv);
+    Kept.Ready = Kept.Globals != NULL && pc->TopStackFrame == NULL && pc->HeapStackTop == Kept.StackTop && 
+            pc->UberType.DerivedTypeList == Kept.Types;
+}
+
+/* free an interpreter from PicocPlatformPrepareFile() */
+void PicocPlatformReleaseFile(Picoc *pc)
+{
+    if (Kept.pc != pc)
+        return;
+    
+    PicocCleanup(pc);
+    free(Kept.FileName);
+    free(Kept.Globals);
+    free(Kept.Data);
+    memset(&Kept, '\0', sizeof(Kept));
 }
 
 /* exit the program */
@@ -0,0 +1,276 @@
+/* picoc execution profiler. The time between two statements is charged to
+ * the line and call stack of the first one, and the time spent in a library
+ * function is charged to the function and the line which called it. The
+ * result is written as collapsed stacks - "main;fill:42 1234", one stack
+ * and its microseconds per line - which flame graph tools read directly */
+
+#ifdef PICOC_PROFILE
+
+#include "interpreter.h"
+#include <sys/time.h>
+
+#define PROFILE_KEY_MAX 512                 /* longest call stack description */
+#define PROFILE_DEPTH_MAX 64                /* deepest call stack described in full */
+
+struct ProfileEntry
+{
+    struct ProfileEntry *Next;
+    unsigned long long Time;                /* microseconds charged to this stack */
+    unsigned long Count;                    /* statements run or library calls made */
+    int Native;                             /* is this a library call */
+    char Key[1];                            /* the collapsed stack */
+};
+
+static unsigned long long ProfileTime(void)
+{
+    struct timeval Now;
+
+    gettimeofday(&Now, NULL);
+    return (unsigned long long)Now.tv_sec * 1000000 + Now.tv_usec;
+}
+
+static unsigned int ProfileHash(const char *Key)
+{
+    unsigned int Hash = 5381;
+
+    while (*Key != '\0')
+        Hash = Hash * 33 + (unsigned char)*Key++;
+
+    return Hash % PROFILE_TABLE_SIZE;
+}
+
+/* find the entry for a stack, adding it if it's new. Entries are malloc()ed so
+ * they don't show up in the heap usage being measured */
+static struct ProfileEntry *ProfileEntryGet(Picoc *pc, const char *Key, int Native)
+{
+    unsigned int Hash = ProfileHash(Key);
+    struct ProfileEntry *Entry;
+
+    for (Entry = pc->ProfileHashTable[Hash]; Entry != NULL; Entry = Entry->Next)
+    {
+        if (Entry->Native == Native && strcmp(Entry->Key, Key) == 0)
+            return Entry;
+    }
+
+    Entry = malloc(sizeof(struct ProfileEntry) + strlen(Key));
+    if (Entry == NULL)
+        return NULL;
+
+    strcpy(Entry->Key, Key);
+    Entry->Time = 0;
+    Entry->Count = 0;
+    Entry->Native = Native;
+    Entry->Next = pc->ProfileHashTable[Hash];
+    pc->ProfileHashTable[Hash] = Entry;
+    return Entry;
+}
+
+/* describe the call stack of the parser, outermost function first and the current line last */
+static void ProfileStackKey(struct ParseState *Parser, char *Key)
+{
+    const char *Frames[PROFILE_DEPTH_MAX];
+    struct StackFrame *Frame;
+    int Depth = 0;
+    int Used = 0;
+
+    /* the innermost function is named along with the line instead */
+    Frame = Parser->pc->TopStackFrame != NULL ? Parser->pc->TopStackFrame->PreviousStackFrame : NULL;
+    for (; Frame != NULL && Depth < PROFILE_DEPTH_MAX; Frame = Frame->PreviousStackFrame)
+        Frames[Depth++] = Frame->FuncName;
+
+    if (Frame != NULL)
+        Used = snprintf(Key, PROFILE_KEY_MAX, "...;");
+
+    while (Depth > 0 && Used < PROFILE_KEY_MAX)
+    {
+        Depth--;
+        Used += snprintf(&Key[Used], PROFILE_KEY_MAX - Used, "%s;", Frames[Depth]);
+    }
+
+    /* statements outside of any function are described by their file instead */
+    if (Used < PROFILE_KEY_MAX)
+    {
+        if (Parser->pc->TopStackFrame != NULL)
+            snprintf(&Key[Used], PROFILE_KEY_MAX - Used, "%s:%d", Parser->pc->TopStackFrame->FuncName, Parser->Line);
+        else
+            snprintf(&Key[Used], PROFILE_KEY_MAX - Used, "%s:%d", Parser->FileName, Parser->Line);
+    }
+}
+
+void ProfileInit(Picoc *pc)
+{
+    int Count;
+
+    for (Count = 0; Count < PROFILE_TABLE_SIZE; Count++)
+        pc->ProfileHashTable[Count] = NULL;
+
+    pc->ProfileCurrent = NULL;
+    pc->ProfileLastTime = ProfileTime();
+    pc->ProfileHeapInUse = 0;
+    pc->ProfileHeapHighWater = 0;
+    pc->ProfileStackHighWater = 0;
+}
+
+void ProfileCleanup(Picoc *pc)
+{
+    struct ProfileEntry *Entry;
+    struct ProfileEntry *NextEntry;
+    int Count;
+
+    for (Count = 0; Count < PROFILE_TABLE_SIZE; Count++)
+    {
+        for (Entry = pc->ProfileHashTable[Count]; Entry != NULL; Entry = NextEntry)
+        {
+            NextEntry = Entry->Next;
+            free(Entry);
+        }
+
+        pc->ProfileHashTable[Count] = NULL;
+    }
+
+    pc->ProfileCurrent = NULL;
+}
+
+/* a statement is about to run - close off the previous one */
+void ProfileStatement(struct ParseState *Parser)
+{
+    Picoc *pc = Parser->pc;
+    char Key[PROFILE_KEY_MAX];
+
+    if (pc->ProfileCurrent != NULL)
+        pc->ProfileCurrent->Time += ProfileTime() - pc->ProfileLastTime;
+
+    ProfileStackKey(Parser, Key);
+    pc->ProfileCurrent = ProfileEntryGet(pc, Key, FALSE);
+    if (pc->ProfileCurrent != NULL)
+        pc->ProfileCurrent->Count++;
+
+    /* don't charge the profiler's own bookkeeping to the script */
+    pc->ProfileLastTime = ProfileTime();
+}
+
+/* a library function is about to be called */
+void ProfileNativeBegin(Picoc *pc)
+{
+    unsigned long long Now = ProfileTime();
+
+    if (pc->ProfileCurrent != NULL)
+        pc->ProfileCurrent->Time += Now - pc->ProfileLastTime;
+
+    pc->ProfileLastTime = Now;
+}
+
+/* a library function has returned. The calling statement carries on being charged afterwards */
+void ProfileNativeEnd(struct ParseState *Parser, const char *FuncName)
+{
+    Picoc *pc = Parser->pc;
+    unsigned long long Elapsed = ProfileTime() - pc->ProfileLastTime;
+    struct ProfileEntry *Entry;
+    char Key[PROFILE_KEY_MAX];
+    int Used;
+
+    ProfileStackKey(Parser, Key);
+    Used = strlen(Key);
+    snprintf(&Key[Used], PROFILE_KEY_MAX - Used, ";%s", FuncName);
+    Entry = ProfileEntryGet(pc, Key, TRUE);
+    if (Entry != NULL)
+    {
+        Entry->Time += Elapsed;
+        Entry->Count++;
+    }
+
+    pc->ProfileLastTime = ProfileTime();
+}
+
+void ProfileHeapAlloc(Picoc *pc, int Size)
+{
+    pc->ProfileHeapInUse += Size;
+    if (pc->ProfileHeapInUse > pc->ProfileHeapHighWater)
+        pc->ProfileHeapHighWater = pc->ProfileHeapInUse;
+}
+
+void ProfileHeapFree(Picoc *pc, int Size)
+{
+    pc->ProfileHeapInUse -= Size;
+}
+
+void ProfileStackUsed(Picoc *pc, long Size)
+{
+    if (Size > pc->ProfileStackHighWater)
+        pc->ProfileStackHighWater = Size;
+}
+
+static int ProfileCompareTime(const void *A, const void *B)
+{
+    const struct ProfileEntry *EntryA = *(const struct ProfileEntry **)A;
+    const struct ProfileEntry *EntryB = *(const struct ProfileEntry **)B;
+
+    if (EntryA->Time != EntryB->Time)
+        return EntryA->Time < EntryB->Time ? 1 : -1;
+
+    return strcmp(EntryA->Key, EntryB->Key);
+}
+
+/* write the collapsed stacks to StacksFileName, and memory use plus every stack
+ * with its statement or call count, slowest first, to SummaryFileName */
+void PicocProfileWrite(Picoc *pc, const char *StacksFileName, const char *SummaryFileName)
+{
+    struct ProfileEntry **Sorted;
+    struct ProfileEntry *Entry;
+    FILE *Out;
+    int NumEntries = 0;
+    int Count;
+
+    /* close off the last statement */
+    if (pc->ProfileCurrent != NULL)
+        pc->ProfileCurrent->Time += ProfileTime() - pc->ProfileLastTime;
+
+    pc->ProfileCurrent = NULL;
+
+    for (Count = 0; Count < PROFILE_TABLE_SIZE; Count++)
+    {
+        for (Entry = pc->ProfileHashTable[Count]; Entry != NULL; Entry = Entry->Next)
+            NumEntries++;
+    }
+
+    Sorted = malloc(sizeof(struct ProfileEntry *) * (NumEntries + 1));
+    if (Sorted == NULL)
+        return;
+
+    NumEntries = 0;
+    for (Count = 0; Count < PROFILE_TABLE_SIZE; Count++)
+    {
+        for (Entry = pc->ProfileHashTable[Count]; Entry != NULL; Entry = Entry->Next)
+            Sorted[NumEntries++] = Entry;
+    }
+
+    qsort(Sorted, NumEntries, sizeof(struct ProfileEntry *), ProfileCompareTime);
+
+    Out = fopen(StacksFileName, "w");
+    if (Out != NULL)
+    {
+        for (Count = 0; Count < NumEntries; Count++)
+        {
+            if (Sorted[Count]->Time > 0)
+                fprintf(Out, "%s %llu\n", Sorted[Count]->Key, Sorted[Count]->Time);
+        }
+
+        fclose(Out);
+    }
+
+    Out = fopen(SummaryFileName, "w");
+    if (Out != NULL)
+    {
+        fprintf(Out, "stack high water: %ld bytes\n", pc->ProfileStackHighWater);
+        fprintf(Out, "heap high water: %ld bytes\n\n", pc->ProfileHeapHighWater);
+        fprintf(Out, "%12s %10s  %s\n", "us", "count", "stack");
+        for (Count = 0; Count < NumEntries; Count++)
+            fprintf(Out, "%12llu %10lu  %s%s\n", Sorted[Count]->Time, Sorted[Count]->Count, Sorted[Count]->Key, Sorted[Count]->Native ? " (library)" : "");
+
+        fclose(Out);
+    }
+
+    free(Sorted);
+}
+
+#endif /* PICOC_PROFILE */
@@ -28,20 +28,93 @@ static unsigned int TableHash(const char *Key, int Len)
     return Hash;
 }
 
+/* hash function for shared strings - they have unique addresses so we don't need to hash them.
+ * The low bit is ignored since it's used to hide variables which are out of scope */
+#define TableHashShared(Key, Size) ((((unsigned long)(Key)) & ~1UL) % (Size))
+
+/* sizes tables grow through. They're prime since shared string addresses are all aligned */
+static const short TableGrowSizes[] = { 97, 389, 1543, 6151, 24593 };
+
 /* initialise a table */
 void TableInitTable(struct Table *Tbl, struct TableEntry **HashTable, int Size, int OnHeap)
 {
     Tbl->Size = Size;
     Tbl->OnHeap = OnHeap;
+    Tbl->Grown = FALSE;
+    Tbl->Count = 0;
     Tbl->HashTable = HashTable;
     memset((void *)HashTable, '\0', sizeof(struct TableEntry *) * Size);
 }
 
+/* rehash a heap table into more buckets once its chains get long. Tables on the stack stay as they are */
+static void TableGrow(Picoc *pc, struct Table *Tbl, int IsIdentifierTable)
+{
+    struct TableEntry **NewHashTable;
+    struct TableEntry *Entry;
+    struct TableEntry *NextEntry;
+    int NewSize = 0;
+    int HashValue;
+    int Count;
+    
+    if (!Tbl->OnHeap || Tbl->Count <= Tbl->Size * TABLE_MAX_LOAD)
+        return;
+    
+    for (Count = 0; Count < (int) (sizeof(TableGrowSizes) / sizeof(TableGrowSizes[0])); Count++)
+    {
+        if (TableGrowSizes[Count] > Tbl->Size)
+        {
+            NewSize = TableGrowSizes[Count];
+            break;
+        }
+    }
+    
+    if (NewSize == 0)
+        return;     /* as big as it gets - just let the chains get longer */
+    
+    NewHashTable = HeapAllocMem(pc, sizeof(struct TableEntry *) * NewSize);
+    if (NewHashTable == NULL)
+        return;     /* not fatal, it's only slower */
+    
+    for (Count = 0; Count < Tbl->Size; Count++)
+    {
+        for (Entry = Tbl->HashTable[Count]; Entry != NULL; Entry = NextEntry)
+        {
+            NextEntry = Entry->Next;
+            if (IsIdentifierTable)
+                HashValue = TableHash(&Entry->p.s.Key[0], Entry->p.s.Len) % NewSize;
+            else
+                HashValue = TableHashShared(Entry->p.v.Key, NewSize);
+            
+            Entry->Next = NewHashTable[HashValue];
+            NewHashTable[HashValue] = Entry;
+        }
+    }
+    
+    if (Tbl->Grown)
+        HeapFreeMem(pc, Tbl->HashTable);
+    
+    Tbl->HashTable = NewHashTable;
+    Tbl->Size = NewSize;
+    Tbl->Grown = TRUE;
+}
+
+/* free the buckets of a table which has grown. The entries have to be freed first */
+void TableFreeHashTable(Picoc *pc, struct Table *Tbl)
+{
+    if (Tbl->Grown)
+    {
+        HeapFreeMem(pc, Tbl->HashTable);
+        Tbl->HashTable = NULL;
+        Tbl->Size = 0;
+        Tbl->Grown = FALSE;
+    }
+}
+
 /* check a hash table entry for a key */
 static struct TableEntry *TableSearch(struct Table *Tbl, const char *Key, int *AddAt)
 {
     struct TableEntry *Entry;
-    int HashValue = ((unsigned long)Key) % Tbl->Size;   /* shared strings have unique addresses so we don't need to hash them */
+    int HashValue = TableHashShared(Key, Tbl->Size);
     
     for (Entry = Tbl->HashTable[HashValue]; Entry != NULL; Entry = Entry->Next)
     {
@@ -70,6 +143,8 @@ int TableSet(Picoc *pc, struct Table *Tbl, char *Key, struct Value *Val, const c
         NewEntry->p.v.Val = Val;
         NewEntry->Next = Tbl->HashTable[AddAt];
         Tbl->HashTable[AddAt] = NewEntry;
+        Tbl->Count++;
+        TableGrow(pc, Tbl, FALSE);
         return TRUE;
     }
 
@@ -101,7 +176,7 @@ int TableGet(struct Table *Tbl, const char *Key, struct Value **Val, const char
 struct Value *TableDelete(Picoc *pc, struct Table *Tbl, const char *Key)
 {
     struct TableEntry **EntryPtr;
-    int HashValue = ((unsigned long)Key) % Tbl->Size;   /* shared strings have unique addresses so we don't need to hash them */
+    int HashValue = TableHashShared(Key, Tbl->Size);
     
     for (EntryPtr = &Tbl->HashTable[HashValue]; *EntryPtr != NULL; EntryPtr = &(*EntryPtr)->Next)
     {
@@ -111,6 +186,7 @@ struct Value *TableDelete(Picoc *pc, struct Table *Tbl, const char *Key)
             struct Value *Val = DeleteEntry->p.v.Val;
             *EntryPtr = DeleteEntry->Next;
             HeapFreeMem(pc, DeleteEntry);
+            Tbl->Count--;
 
             return Val;
         }
@@ -127,7 +203,7 @@ static struct TableEntry *TableSearchIdentifier(struct Table *Tbl, const char *K
     
     for (Entry = Tbl->HashTable[HashValue]; Entry != NULL; Entry = Entry->Next)
     {
-        if (strncmp(&Entry->p.Key[0], (char *)Key, Len) == 0 && Entry->p.Key[Len] == '\0')
+        if (Entry->p.s.Len == Len && memcmp(&Entry->p.s.Key[0], Key, Len) == 0)
             return Entry;   /* found */
     }
     
@@ -142,18 +218,22 @@ char *TableSetIdentifier(Picoc *pc, struct Table *Tbl, const char *Ident, int Id
     struct TableEntry *FoundEntry = TableSearchIdentifier(Tbl, Ident, IdentLen, &AddAt);
     
     if (FoundEntry != NULL)
-        return &FoundEntry->p.Key[0];
+        return &FoundEntry->p.s.Key[0];
     else
     {   /* add it to the table - we economise by not allocating the whole structure here */
-        struct TableEntry *NewEntry = HeapAllocMem(pc, sizeof(struct TableEntry) - sizeof(union TableEntryPayload) + IdentLen + 1);
+        struct TableEntry *NewEntry = HeapAllocMem(pc, offsetof(struct TableEntry, p.s.Key) + IdentLen + 1);
         if (NewEntry == NULL)
             ProgramFailNoParser(pc, "out of memory");
             
-        strncpy((char *)&NewEntry->p.Key[0], (char *)Ident, IdentLen);
-        NewEntry->p.Key[IdentLen] = '\0';
+        /* string literals can have '\0's inside them, so the length is kept rather than worked out */
+        NewEntry->p.s.Len = IdentLen;
+        memcpy((char *)&NewEntry->p.s.Key[0], (char *)Ident, IdentLen);
+        NewEntry->p.s.Key[IdentLen] = '\0';
         NewEntry->Next = Tbl->HashTable[AddAt];
         Tbl->HashTable[AddAt] = NewEntry;
-        return &NewEntry->p.Key[0];
+        Tbl->Count++;
+        TableGrow(pc, Tbl, TRUE);
+        return &NewEntry->p.s.Key[0];
     }
 }
 
@@ -168,6 +248,12 @@ char *TableStrRegister(Picoc *pc, const char *Str)
     return TableStrRegister2(pc, Str, strlen((char *)Str));
 }
 
+/* the length of a shared string from TableStrRegister(), counting any '\0's inside it */
+int TableStrLen(const char *Str)
+{
+    return ((const struct TableEntry *)(Str - offsetof(struct TableEntry, p.s.Key)))->p.s.Len;
+}
+
 /* free all the strings */
 void TableStrFree(Picoc *pc)
 {
@@ -183,4 +269,6 @@ void TableStrFree(Picoc *pc)
             HeapFreeMem(pc, Entry);
         }
     }
+    
+    TableFreeHashTable(pc, &pc->StringTable);
 }
@@ -56,10 +56,32 @@ void VariableTableCleanup(Picoc *pc, struct Table *HashTable)
             HeapFreeMem(pc, Entry);
         }
     }
+    
+    TableFreeHashTable(pc, HashTable);
+}
+
+/* free the data of local variables which was too big for the stack */
+static void VariableLocalsFree(Picoc *pc, struct Table *LocalTable)
+{
+    struct TableEntry *Entry;
+    int Count;
+    
+    for (Count = 0; Count < LocalTable->Size; Count++)
+    {
+        for (Entry = LocalTable->HashTable[Count]; Entry != NULL; Entry = Entry->Next)
+        {
+            if (Entry->p.v.Val->AnyValOnHeap)
+                HeapFreeMem(pc, Entry->p.v.Val->Val);
+        }
+    }
 }
 
 void VariableCleanup(Picoc *pc)
 {
+    /* a script which exited from inside a function leaves its stack frames behind */
+    for (; pc->TopStackFrame != NULL; pc->TopStackFrame = pc->TopStackFrame->PreviousStackFrame)
+        VariableLocalsFree(pc, &pc->TopStackFrame->LocalTable);
+    
     VariableTableCleanup(pc, &pc->GlobalTable);
     VariableTableCleanup(pc, &pc->StringLiteralTable);
 }
@@ -268,6 +290,15 @@ struct Value *VariableDefine(Picoc *pc, struct ParseState *Parser, char *Ident,
     
     if (InitValue != NULL)
         AssignValue = VariableAllocValueAndCopy(pc, Parser, InitValue, pc->TopStackFrame == NULL);
+    else if (pc->TopStackFrame != NULL && TypeSize(Typ, Typ->ArraySize, FALSE) >= LOCAL_ON_HEAP_MIN)
+    {
+        /* keep big local arrays and structs off the stack. The data is freed when the function returns */
+        AssignValue = VariableAllocValueAndData(pc, Parser, 0, MakeWritable, NULL, FALSE);
+        AssignValue->Typ = Typ;
+        AssignValue->Val = VariableAlloc(pc, Parser, TypeSize(Typ, Typ->ArraySize, FALSE), TRUE);
+        AssignValue->AnyValOnHeap = TRUE;
+        AssignValue->ValOnStack = FALSE;
+    }
     else
         AssignValue = VariableAllocValueFromType(pc, Parser, Typ, MakeWritable, NULL, pc->TopStackFrame == NULL);
     
@@ -432,6 +463,7 @@ void VariableStackFramePop(struct ParseState *Parser)
     if (Parser->pc->TopStackFrame == NULL)
         ProgramFail(Parser, "stack is empty - can't go back");
         
+    VariableLocalsFree(Parser->pc, &Parser->pc->TopStackFrame->LocalTable);
     ParserCopy(Parser, &Parser->pc->TopStackFrame->ReturnParser);
     Parser->pc->TopStackFrame = Parser->pc->TopStackFrame->PreviousStackFrame;
     HeapPopStackFrame(Parser->pc);
@@ -301,42 +301,76 @@ static void flood_fill_seed(struct quirc *q, int start_x, int start_y, int from,
 #define THRESHOLD_S_DEN		8
 #define THRESHOLD_T		5
 
-static void threshold(struct quirc *q)
+/* The moving average divides by threshold_s twice per pixel, and the ARM11
+ * has no divide instruction. For the widths we see, the quotient is exactly
+ * a multiply by a rounded-up reciprocal followed by a shift: the numerator
+ * never exceeds 255 * s^2, so the rounding error stays below one as long as
+ * 255 * s^3 < 2^32.
+ */
+#define THRESHOLD_RECIP_MAX_S	255
+
+static inline int threshold_div(int n, int s, uint64_t recip)
+{
+	if (!recip)
+		return n / s;
+
+	return (int)(((uint64_t)n * recip) >> 32);
+}
+
+/* Only the columns from left up to right and the rows from top up to
+ * bottom are thresholded. The averaging window stays relative to the
+ * whole image width, but the running averages only ever see pixels
+ * inside the region and carry over from one row's end to the next, so
+ * pixels near the region's edges can come out differently from a
+ * whole-image pass.
+ */
+static void threshold(struct quirc *q, int left, int top, int right,
+		      int bottom)
 {
 	int x, y;
 	int avg_w = 0;
 	int avg_u = 0;
 	int threshold_s = q->w / THRESHOLD_S_DEN;
-	quirc_pixel_t *row = q->pixels;
+	int keep = 0;
+	uint64_t recip = 0;
+	quirc_pixel_t *row = q->pixels + top * q->w;
+	int *row_average = q->row_average;
+
+	if (threshold_s < 1)
+		threshold_s = 1;
 
-	for (y = 0; y < q->h; y++) {
-		int row_average[q->w];
+	keep = threshold_s - 1;
+	if (threshold_s <= THRESHOLD_RECIP_MAX_S)
+		recip = (((uint64_t)1) << 32) / threshold_s + 1;
 
-		memset(row_average, 0, sizeof(row_average));
+	for (y = top; y < bottom; y++) {
+		memset(row_average + left, 0, (right - left) * sizeof(int));
 
-		for (x = 0; x < q->w; x++) {
+		for (x = 0; x < right - left; x++) {
 			int w, u;
 
 			if (y & 1) {
-				w = x;
-				u = q->w - 1 - x;
+				w = left + x;
+				u = right - 1 - x;
 			} else {
-				w = q->w - 1 - x;
-				u = x;
+				w = right - 1 - x;
+				u = left + x;
 			}
 
-			avg_w = (avg_w * (threshold_s - 1)) /
-				threshold_s + row[w];
-			avg_u = (avg_u * (threshold_s - 1)) /
-				threshold_s + row[u];
+			avg_w = threshold_div(avg_w * keep, threshold_s,
+					      recip) + row[w];
+			avg_u = threshold_div(avg_u * keep, threshold_s,
+					      recip) + row[u];
 
 			row_average[w] += avg_w;
 			row_average[u] += avg_u;
 		}
 
-		for (x = 0; x < q->w; x++) {
-			if (row[x] < row_average[x] *
-			    (100 - THRESHOLD_T) / (200 * threshold_s))
+		/* row[x] < avg * (100 - T) / (200 * s), rounded down,
+		 * without the division */
+		for (x = left; x < right; x++) {
+			if ((row[x] + 1) * 200 * threshold_s <=
+			    row_average[x] * (100 - THRESHOLD_T))
 				row[x] = QUIRC_PIXEL_BLACK;
 			else
 				row[x] = QUIRC_PIXEL_WHITE;
@@ -1222,12 +1256,45 @@ uint8_t *quirc_begin(struct quirc *q, int *w, int *h)
 
 void quirc_end(struct quirc *q)
 {
+	quirc_end_roi(q, 0, 0, q->w, q->h);
+}
+
+void quirc_end_roi(struct quirc *q, int x, int y, int w, int h)
+{
+	int left = x < 0 ? 0 : x;
+	int top = y < 0 ? 0 : y;
+	int right = x + w > q->w ? q->w : x + w;
+	int bottom = y + h > q->h ? q->h : y + h;
 	int i;
 
+	if (left >= right || top >= bottom) {
+		left = 0;
+		top = 0;
+		right = q->w;
+		bottom = q->h;
+	}
+
 	pixels_setup(q);
-	threshold(q);
 
-	for (i = 0; i < q->h; i++)
+	/* Everything outside the region is left white, so the flood fills
+	 * and finder scans never leave it. */
+	for (i = 0; i < q->h; i++) {
+		quirc_pixel_t *row = q->pixels + i * q->w;
+
+		if (i < top || i >= bottom) {
+			memset(row, QUIRC_PIXEL_WHITE,
+			       q->w * sizeof(quirc_pixel_t));
+		} else {
+			memset(row, QUIRC_PIXEL_WHITE,
+			       left * sizeof(quirc_pixel_t));
+			memset(row + right, QUIRC_PIXEL_WHITE,
+			       (q->w - right) * sizeof(quirc_pixel_t));
+		}
+	}
+
+	threshold(q, left, top, right, bottom);
+
+	for (i = top; i < bottom; i++)
 		finder_scan(q, i);
 
 	for (i = 0; i < q->num_capstones; i++)
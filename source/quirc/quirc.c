@@ -40,6 +40,7 @@ void quirc_destroy(struct quirc *q)
 		free(q->image);
 	if (sizeof(*q->image) != sizeof(*q->pixels))
 		free(q->pixels);
+	free(q->row_average);
 
 	free(q);
 }
@@ -47,9 +48,16 @@ void quirc_destroy(struct quirc *q)
 int quirc_resize(struct quirc *q, int w, int h)
 {
 	uint8_t *new_image = realloc(q->image, w * h);
+	int *new_row_average;
 
 	if (!new_image)
 		return -1;
+	q->image = new_image;
+
+	new_row_average = realloc(q->row_average, w * sizeof(int));
+	if (!new_row_average)
+		return -1;
+	q->row_average = new_row_average;
 
 	if (sizeof(*q->image) != sizeof(*q->pixels)) {
 		size_t new_size = w * h * sizeof(quirc_pixel_t);
@@ -59,7 +67,6 @@ int quirc_resize(struct quirc *q, int w, int h)
 		q->pixels = new_pixels;
 	}
 
-	q->image = new_image;
 	q->w = w;
 	q->h = h;
 
@@ -152,10 +152,10 @@ const struct quirc_version_info quirc_version_db[QUIRC_MAX_VERSION + 1] = {
 		    .data_bytes = 581,
 		    .apat = {6, 26, 46, 66, 0},
 		    .ecc = {
-			    {.bs = 65, .dw = 41, .ce = 12},
-			    {.bs = 109, .dw = 87, .ce = 11},
+			    {.bs = 64, .dw = 40, .ce = 12},
+			    {.bs = 145, .dw = 115, .ce = 15},
 			    {.bs = 36, .dw = 12, .ce = 12},
-			    {.bs = 54, .dw = 24, .ce = 15}
+			    {.bs = 36, .dw = 16, .ce = 10}
 		    }
 	    },
 	    { /* Version 15 */
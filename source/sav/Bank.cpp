@@ -25,6 +25,7 @@
 */
 
 #include "Bank.hpp"
+#include "BackupStore.hpp"
 #include "Configuration.hpp"
 #include "FSStream.hpp"
 #include "archive.hpp"
@@ -486,17 +487,10 @@ void Bank::pkm(PKX& pkm, int box, int slot)
 void Bank::backup() const
 {
     Gui::waitFrame(i18n::localize("BANK_BACKUP"));
-    FSUSER_DeleteFile(Archive::sd(), fsMakePath(PATH_UTF16, u"/3ds/PKSM/banks/pksm_1.bnk.bak"));
-    FSUSER_DeleteFile(Archive::sd(), fsMakePath(PATH_UTF16, u"/3ds/PKSM/banks/pksm_1.json.bak"));
-
-    std::ofstream out("/3ds/PKSM/banks/pksm_1.bnk.bak");
-    out.write((char*)data, sizeof(BankHeader) + sizeof(BankEntry) * Configuration::getInstance().storageSize() * 30);
-    out.close();
+    BackupStore::backup(BackupStore::BANK, "pksm_1.bnk", data, sizeof(BankHeader) + sizeof(BankEntry) * Configuration::getInstance().storageSize() * 30);
 
     std::string jsonData = boxNames.dump(2);
-    out = std::ofstream("/3ds/PKSM/banks/pksm_1.json.bak");
-    out.write(jsonData.data(), jsonData.size());
-    out.close();
+    BackupStore::backup(BackupStore::BANK_NAMES, "pksm_1.json", (u8*)jsonData.data(), jsonData.size());
 }
 
 std::string Bank::boxName(int box) const
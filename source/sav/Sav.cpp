@@ -77,76 +77,77 @@ std::unique_ptr<Sav> Sav::getSave(u8* dt, size_t length)
     }
 }
 
-bool Sav::isValidDSSave(u8* dt)
+// block footers which identify the Gen 4 games, the first two bytes being where the footer ends
+static u8 dpPattern[] = { 0x00, 0xC1, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
+static u8 ptPattern[] = { 0x2C, 0xCF, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
+static u8 hgssPattern[] = { 0x28, 0xF6, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
+
+const std::array<std::pair<u32, u32>, 8> Sav::dsProbeRegions = {{
+    { 0x24000 - 0x100, 0x8C + 0x10 },   // BW checksummed block and its checksum
+    { 0x26000 - 0x100, 0x94 + 0x10 },   // B2W2 checksummed block and its checksum
+    { 0xC100 - 0xC, 10 },               // DP footer
+    { 0xCF2C - 0xC, 10 },               // Pt footer
+    { 0xF628 - 0xC, 10 },               // HGSS footer
+    { 0x40000 + 0xC100 - 0xC, 10 },     // and the same for the second copy of the save
+    { 0x40000 + 0xCF2C - 0xC, 10 },
+    { 0x40000 + 0xF628 - 0xC, 10 }
+}};
+
+DSSaveType Sav::dsSaveType(u8* dt)
 {
     u16 chk1 = *(u16*)(dt + 0x24000 - 0x100 + 0x8C + 0xE);
     u16 actual1 = ccitt16(dt + 0x24000 - 0x100, 0x8C);
     if (chk1 == actual1)
     {
-        return true;
+        return DSSaveType::BW;
     }
     u16 chk2 = *(u16*)(dt + 0x26000 - 0x100 + 0x94 + 0xE);
     u16 actual2 = ccitt16(dt + 0x26000 - 0x100, 0x94);
     if (chk2 == actual2)
     {
-        return true;
+        return DSSaveType::B2W2;
     }
 
-    // Check for block identifiers
-    u8 dpPattern[] = { 0x00, 0xC1, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
-    u8 ptPattern[] = { 0x2C, 0xCF, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
-    u8 hgssPattern[] = { 0x28, 0xF6, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
-    if (validSequence(dt, dpPattern))
-        return true;
-    if (validSequence(dt, ptPattern))
-        return true;
-    if (validSequence(dt, hgssPattern))
-        return true;
+    // Check for block identifiers, then the other save
+    for (int shift : { 0, 0x40000 })
+    {
+        if (validSequence(dt, dpPattern, shift))
+            return DSSaveType::DP;
+        if (validSequence(dt, ptPattern, shift))
+            return DSSaveType::PT;
+        if (validSequence(dt, hgssPattern, shift))
+            return DSSaveType::HGSS;
+    }
+    return DSSaveType::NONE;
+}
 
-    // Check the other save
-    if (validSequence(dt, dpPattern, 0x40000))
-        return true;
-    if (validSequence(dt, ptPattern, 0x40000))
-        return true;
-    if (validSequence(dt, hgssPattern, 0x40000))
-        return true;
-    return false;
+bool Sav::isValidDSSave(u8* dt)
+{
+    return dsSaveType(dt) != DSSaveType::NONE;
 }
 
-std::unique_ptr<Sav> Sav::checkDSType(u8* dt)
+std::unique_ptr<Sav> Sav::getDSSave(u8* dt, DSSaveType type)
 {
-    u16 chk1 = *(u16*)(dt + 0x24000 - 0x100 + 0x8C + 0xE);
-    u16 actual1 = ccitt16(dt + 0x24000 - 0x100, 0x8C);
-    if (chk1 == actual1)
-    {
-        return std::make_unique<SavBW>(dt);
-    }
-    u16 chk2 = *(u16*)(dt + 0x26000 - 0x100 + 0x94 + 0xE);
-    u16 actual2 = ccitt16(dt + 0x26000 - 0x100, 0x94);
-    if (chk2 == actual2)
+    switch (type)
     {
-        return std::make_unique<SavB2W2>(dt);
+        case DSSaveType::BW:
+            return std::make_unique<SavBW>(dt);
+        case DSSaveType::B2W2:
+            return std::make_unique<SavB2W2>(dt);
+        case DSSaveType::DP:
+            return std::make_unique<SavDP>(dt);
+        case DSSaveType::PT:
+            return std::make_unique<SavPT>(dt);
+        case DSSaveType::HGSS:
+            return std::make_unique<SavHGSS>(dt);
+        default:
+            return nullptr;
     }
+}
 
-    // Check for block identifiers
-    u8 dpPattern[] = { 0x00, 0xC1, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
-    u8 ptPattern[] = { 0x2C, 0xCF, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
-    u8 hgssPattern[] = { 0x28, 0xF6, 0x00, 0x00, 0x23, 0x06, 0x06, 0x20, 0x00, 0x00 };
-    if (validSequence(dt, dpPattern))
-        return std::make_unique<SavDP>(dt);
-    if (validSequence(dt, ptPattern))
-        return std::make_unique<SavPT>(dt);
-    if (validSequence(dt, hgssPattern))
-        return std::make_unique<SavHGSS>(dt);
-
-    // Check the other save
-    if (validSequence(dt, dpPattern, 0x40000))
-        return std::make_unique<SavDP>(dt);
-    if (validSequence(dt, ptPattern, 0x40000))
-        return std::make_unique<SavPT>(dt);
-    if (validSequence(dt, hgssPattern, 0x40000))
-        return std::make_unique<SavHGSS>(dt);
-    return nullptr;
+std::unique_ptr<Sav> Sav::checkDSType(u8* dt)
+{
+    return getDSSave(dt, dsSaveType(dt));
 }
 
 bool Sav::validSequence(u8* dt, u8* pattern, int shift)
@@ -158,6 +159,25 @@ bool Sav::validSequence(u8* dt, u8* pattern, int shift)
     return true;
 }
 
+size_t Sav::mysteryGifts(const std::vector<std::unique_ptr<WCX>>& cards)
+{
+    int pos = emptyGiftLocation();
+    size_t available = maxWondercards() - pos;
+    // emptyGiftLocation also returns the last slot when every slot is taken
+    auto last = mysteryGift(pos);
+    if (std::any_of(last->rawData(), last->rawData() + last->size(), [](u8 v){ return v != 0; }))
+    {
+        available--;
+    }
+
+    size_t injected = std::min(available, cards.size());
+    for (size_t i = 0; i < injected; i++)
+    {
+        mysteryGift(*cards[i], pos);
+    }
+    return injected;
+}
+
 void Sav::fixParty()
 {
     // Poor man's bubble sort-like thing
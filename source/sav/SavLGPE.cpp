@@ -541,211 +541,217 @@ void SavLGPE::cryptBoxData(bool crypted)
     }
 }
 
-void SavLGPE::mysteryGift(WCX& wc, int& pos)
+// Builds the Pokemon a card gives and stores it in slot, which the caller has checked is free
+void SavLGPE::giftPkm(WB7* wb7, u16 slot)
 {
-    WB7* wb7 = (WB7*)&wc;
-    if (wb7->pokemon())
+    PB7 pkm;
+    pkm.species(wb7->species());
+    pkm.alternativeForm(wb7->alternativeForm());
+    if (wb7->level() > 0)
     {
-        if (boxedPkm() == maxSlot())
-        {
-            Gui::warn(i18n::localize("LGPE_TOO_MANY_PKM"), i18n::localize("BAD_INJECT"));
-            return;
-        }
-        PB7 pkm;
-        pkm.species(wb7->species());
-        pkm.alternativeForm(wb7->alternativeForm());
-        if (wb7->level() > 0)
-        {
-            pkm.level(wb7->level());
-            pkm.partyLevel(wb7->level());
-        }
-        else
-        {
-            pkm.level(randomNumbers() % 100 + 1);
-            pkm.partyLevel(pkm.level());
-        }
-        if (wb7->metLevel() > 0)
-        {
-            pkm.metLevel(wb7->metLevel());
-        }
-        else
-        {
-            pkm.metLevel(pkm.level());
-        }
-        pkm.TID(wb7->TID());
-        pkm.SID(wb7->SID());
-        for (int i = 0; i < 4; i++)
-        {
-            pkm.move(i, wb7->move(i));
-            pkm.relearnMove(i, wb7->move(i));
-        }
-        if (wb7->nature() == 255)
-        {
-            pkm.nature(randomNumbers() % 25);
-        }
-        else
-        {
-            pkm.nature(wb7->nature());
-        }
-        if (wb7->gender() == 3)
-        {
-            pkm.gender(randomNumbers() % 3);
-        }
-        else
-        {
-            pkm.gender(wb7->gender());
-        }
-        pkm.heldItem(wb7->heldItem());
-        pkm.encryptionConstant(wb7->encryptionConstant());
-        if (wb7->version() == 0)
-        {
-            pkm.version(wb7->version());
-        }
-        else
-        {
-            pkm.version(version());
-        }
-        pkm.language(language());
-        pkm.ball(wb7->ball());
-        pkm.country(country());
-        pkm.region(subRegion());
-        pkm.consoleRegion(consoleRegion());
-        pkm.metLocation(wb7->metLocation());
-        pkm.eggLocation(wb7->eggLocation());
-        for (int i = 0; i < 6; i++)
-        {
-            pkm.awakened(i, wb7->awakened(i));
-            pkm.ev(i, wb7->ev(i));
-        }
-        if (wb7->nickname((Language)language()).length() == 0)
-        {
-            pkm.nickname(i18n::species(language(), pkm.species()).c_str());
-        }
-        else
-        {
-            pkm.nickname(wb7->nickname((Language)language()).c_str());
-            pkm.nicknamed(pkm.nickname() != i18n::species(language(), pkm.species()));
-        }
-        if (wb7->otName((Language)language()).length() == 0)
-        {
-            pkm.otName(otName().c_str());
-            pkm.otGender(gender());
-            pkm.currentHandler(0);
-        }
-        else
-        {
-            pkm.otName(wb7->otName((Language)language()).c_str());
-            pkm.htName(otName().c_str());
-            pkm.otGender(wb7->otGender());
-            pkm.htGender(gender());
-            pkm.otFriendship(PersonalSMUSUM::baseFriendship(pkm.formSpecies())); // TODO: PersonalLGPE
-            pkm.currentHandler(1);
-        }
+        pkm.level(wb7->level());
+        pkm.partyLevel(wb7->level());
+    }
+    else
+    {
+        pkm.level(randomNumbers() % 100 + 1);
+        pkm.partyLevel(pkm.level());
+    }
+    if (wb7->metLevel() > 0)
+    {
+        pkm.metLevel(wb7->metLevel());
+    }
+    else
+    {
+        pkm.metLevel(pkm.level());
+    }
+    pkm.TID(wb7->TID());
+    pkm.SID(wb7->SID());
+    for (int i = 0; i < 4; i++)
+    {
+        pkm.move(i, wb7->move(i));
+        pkm.relearnMove(i, wb7->move(i));
+    }
+    if (wb7->nature() == 255)
+    {
+        pkm.nature(randomNumbers() % 25);
+    }
+    else
+    {
+        pkm.nature(wb7->nature());
+    }
+    if (wb7->gender() == 3)
+    {
+        pkm.gender(randomNumbers() % 3);
+    }
+    else
+    {
+        pkm.gender(wb7->gender());
+    }
+    pkm.heldItem(wb7->heldItem());
+    pkm.encryptionConstant(wb7->encryptionConstant());
+    if (wb7->version() == 0)
+    {
+        pkm.version(wb7->version());
+    }
+    else
+    {
+        pkm.version(version());
+    }
+    pkm.language(language());
+    pkm.ball(wb7->ball());
+    pkm.country(country());
+    pkm.region(subRegion());
+    pkm.consoleRegion(consoleRegion());
+    pkm.metLocation(wb7->metLocation());
+    pkm.eggLocation(wb7->eggLocation());
+    for (int i = 0; i < 6; i++)
+    {
+        pkm.awakened(i, wb7->awakened(i));
+        pkm.ev(i, wb7->ev(i));
+    }
+    if (wb7->nickname((Language)language()).length() == 0)
+    {
+        pkm.nickname(i18n::species(language(), pkm.species()).c_str());
+    }
+    else
+    {
+        pkm.nickname(wb7->nickname((Language)language()).c_str());
+        pkm.nicknamed(pkm.nickname() != i18n::species(language(), pkm.species()));
+    }
+    if (wb7->otName((Language)language()).length() == 0)
+    {
+        pkm.otName(otName().c_str());
+        pkm.otGender(gender());
+        pkm.currentHandler(0);
+    }
+    else
+    {
+        pkm.otName(wb7->otName((Language)language()).c_str());
+        pkm.htName(otName().c_str());
+        pkm.otGender(wb7->otGender());
+        pkm.htGender(gender());
+        pkm.otFriendship(PersonalSMUSUM::baseFriendship(pkm.formSpecies())); // TODO: PersonalLGPE
+        pkm.currentHandler(1);
+    }
 
-        int perfectIVs = 0;
-        for (int i = 0; i < 6; i++)
+    int perfectIVs = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        pkm.iv(randomNumbers() % 30 + 1); // Initialize IVs so that none are perfect (though they can be close)
+        if (wb7->iv(i) - 0xFC < 3)
         {
-            pkm.iv(randomNumbers() % 30 + 1); // Initialize IVs so that none are perfect (though they can be close)
-            if (wb7->iv(i) - 0xFC < 3)
-            {
-                perfectIVs = wb7->iv(i) - 0xFB; // How many perfects should there be?
-                break;
-            }
+            perfectIVs = wb7->iv(i) - 0xFB; // How many perfects should there be?
+            break;
         }
-        if (perfectIVs > 0)
+    }
+    if (perfectIVs > 0)
+    {
+        for (int i = 0; i < perfectIVs; i++)
         {
-            for (int i = 0; i < perfectIVs; i++)
-            {
-                u8 chosenIV;
-                do {
-                    chosenIV = randomNumbers() % 6;
-                }
-                while (pkm.iv(chosenIV) == 31);
-                pkm.iv(chosenIV, 31);
-            }
-            for (int i = 0; i < 6; i++)
-            {
-                if (pkm.iv(i) != 31)
-                {
-                    pkm.iv(i, randomNumbers() % 32);
-                }
+            u8 chosenIV;
+            do {
+                chosenIV = randomNumbers() % 6;
             }
+            while (pkm.iv(chosenIV) == 31);
+            pkm.iv(chosenIV, 31);
         }
-        else
+        for (int i = 0; i < 6; i++)
         {
-            for (int i = 0; i < 6; i++)
+            if (pkm.iv(i) != 31)
             {
                 pkm.iv(i, randomNumbers() % 32);
             }
         }
-
-        if (wb7->otGender() == 3)
+    }
+    else
+    {
+        for (int i = 0; i < 6; i++)
         {
-            pkm.TID(TID());
-            pkm.SID(SID());
+            pkm.iv(i, randomNumbers() % 32);
         }
+    }
 
-        // Sets the ability to the one specific to the formSpecies and sets abilitynumber (Why? Don't quite understand that)
-        switch (wb7->abilityType())
-        {
-            case 0:
-            case 1:
-            case 2:
-                pkm.ability(wb7->abilityType());
-                break;
-            case 3:
-            case 4:
-                pkm.ability(randomNumbers() % (wb7->abilityType() - 1));
-                break;
-        }
+    if (wb7->otGender() == 3)
+    {
+        pkm.TID(TID());
+        pkm.SID(SID());
+    }
 
-        switch (wb7->PIDType())
-        {
-            case 0: // Fixed value
-                pkm.PID(wb7->PID());
-                break;
-            case 1: // Random
-                pkm.PID((u32)randomNumbers());
-                break;
-            case 2: // Always shiny
-                pkm.PID((u32)randomNumbers());
-                pkm.shiny(true);
-                break;
-            case 3: // Never shiny
-                pkm.PID((u32)randomNumbers());
-                pkm.shiny(false);
-                break;
-        }
+    // Sets the ability to the one specific to the formSpecies and sets abilitynumber (Why? Don't quite understand that)
+    switch (wb7->abilityType())
+    {
+        case 0:
+        case 1:
+        case 2:
+            pkm.ability(wb7->abilityType());
+            break;
+        case 3:
+        case 4:
+            pkm.ability(randomNumbers() % (wb7->abilityType() - 1));
+            break;
+    }
 
-        if (wb7->egg())
-        {
-            pkm.egg(true);
-            pkm.eggYear(wb7->year());
-            pkm.eggMonth(wb7->month());
-            pkm.eggDay(wb7->day());
-            pkm.nickname(i18n::species(language(), pkm.species()).c_str());
-            pkm.nicknamed(true);
-        }
+    switch (wb7->PIDType())
+    {
+        case 0: // Fixed value
+            pkm.PID(wb7->PID());
+            break;
+        case 1: // Random
+            pkm.PID((u32)randomNumbers());
+            break;
+        case 2: // Always shiny
+            pkm.PID((u32)randomNumbers());
+            pkm.shiny(true);
+            break;
+        case 3: // Never shiny
+            pkm.PID((u32)randomNumbers());
+            pkm.shiny(false);
+            break;
+    }
 
-        pkm.metDay(wb7->day());
-        pkm.metMonth(wb7->month());
-        pkm.metYear(wb7->year());
-        pkm.currentFriendship(PersonalSMUSUM::baseFriendship(pkm.formSpecies())); // TODO: PersonalLGPE
+    if (wb7->egg())
+    {
+        pkm.egg(true);
+        pkm.eggYear(wb7->year());
+        pkm.eggMonth(wb7->month());
+        pkm.eggDay(wb7->day());
+        pkm.nickname(i18n::species(language(), pkm.species()).c_str());
+        pkm.nicknamed(true);
+    }
 
-        pkm.partyCP(pkm.CP());
-        pkm.partyCurrHP(pkm.stat(0));
-        for (int i = 0; i < 6; i++)
+    pkm.metDay(wb7->day());
+    pkm.metMonth(wb7->month());
+    pkm.metYear(wb7->year());
+    pkm.currentFriendship(PersonalSMUSUM::baseFriendship(pkm.formSpecies())); // TODO: PersonalLGPE
+
+    pkm.partyCP(pkm.CP());
+    pkm.partyCurrHP(pkm.stat(0));
+    for (int i = 0; i < 6; i++)
+    {
+        pkm.partyStat(pkm.stat(i));
+    }
+    
+    pkm.height(randomNumbers() % 256);
+    pkm.weight(randomNumbers() % 256);
+    pkm.fatefulEncounter(true);
+
+    pkm.refreshChecksum();
+    SavLGPE::pkm(pkm, slot); // qualify so there are no stupid errors
+}
+
+void SavLGPE::mysteryGift(WCX& wc, int& pos)
+{
+    WB7* wb7 = (WB7*)&wc;
+    if (wb7->pokemon())
+    {
+        if (boxedPkm() == maxSlot())
         {
-            pkm.partyStat(pkm.stat(i));
+            Gui::warn(i18n::localize("LGPE_TOO_MANY_PKM"), i18n::localize("BAD_INJECT"));
+            return;
         }
-        
-        pkm.height(randomNumbers() % 256);
-        pkm.weight(randomNumbers() % 256);
-        pkm.fatefulEncounter(true);
-
-        pkm.refreshChecksum();
-        SavLGPE::pkm(pkm, boxedPkm()); // qualify so there are no stupid errors
-        boxedPkm(this->boxedPkm() + 1);
+        giftPkm(wb7, boxedPkm());
+        boxedPkm(boxedPkm() + 1);
     }
     else if (wb7->item())
     {
@@ -1011,6 +1017,37 @@ std::unique_ptr<Item> SavLGPE::item(Pouch pouch, u16 slot) const
     }
 }
 
+size_t SavLGPE::mysteryGifts(const std::vector<std::unique_ptr<WCX>>& cards)
+{
+    // Cards aren't stored, so the only limit is room in the box for gifted Pokemon, which fill it up from the
+    // first free slot
+    u16 slot = boxedPkm();
+    size_t injected = 0;
+    int pos = 0;
+    for (auto& card : cards)
+    {
+        if (card->pokemon())
+        {
+            if (slot == maxSlot())
+            {
+                continue;
+            }
+            giftPkm((WB7*)card.get(), slot++);
+        }
+        else
+        {
+            mysteryGift(*card, pos);
+        }
+        injected++;
+    }
+    boxedPkm(slot);
+    if (injected < cards.size())
+    {
+        Gui::warn(i18n::localize("LGPE_TOO_MANY_PKM"), i18n::localize("BAD_INJECT"));
+    }
+    return injected;
+}
+
 std::unique_ptr<WCX> SavLGPE::mysteryGift(int pos) const
 {
     return nullptr;
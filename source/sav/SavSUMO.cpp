@@ -80,6 +80,11 @@ void SavSUMO::resign(void)
 
     u8 decryptedSignature[0x80];
     reverseCrypt(currentSignature, decryptedSignature);
+    // the signature starts with the hash it was made for. If that's still right, skip the slow private key step
+    if (std::equal(hash, hash + SHA256_BLOCK_SIZE, decryptedSignature))
+    {
+        return;
+    }
     std::copy(hash, hash + SHA256_BLOCK_SIZE, decryptedSignature);
 
     memecrypto_sign(decryptedSignature, currentSignature, 0x80);
@@ -32,22 +32,43 @@ Title::~Title(void)
         C3D_TexDelete(mIcon.tex);
 }
 
+static const Tex3DS_SubTexture iconSubTexture = { SMDH_ICON_SIZE, SMDH_ICON_SIZE, 0.0f, 48/64.0f, 48/64.0f, 0.0f };
+
+// the icon fills the end of the texture
+static u16* iconStart(C3D_Tex* tex)
+{
+    return (u16*)tex->data + (ICON_TEXTURE_SIZE - SMDH_ICON_SIZE) * ICON_TEXTURE_SIZE;
+}
+
 static C2D_Image loadTextureIcon(smdh_s *smdh)
 {
     C3D_Tex* tex = new C3D_Tex;
-    static const Tex3DS_SubTexture subt3x = { 48, 48, 0.0f, 48/64.0f, 48/64.0f, 0.0f };
-    C3D_TexInit(tex, 64, 64, GPU_RGB565);
+    C3D_TexInit(tex, ICON_TEXTURE_SIZE, ICON_TEXTURE_SIZE, GPU_RGB565);
+    smdh_icon_to_texture((u16*)smdh->bigIconData, iconStart(tex));
+    return C2D_Image {tex, &iconSubTexture};
+}
 
-    u16* dest = (u16*)tex->data + (64-48)*64;
-    u16* src = (u16*)smdh->bigIconData;
-    for (int j = 0; j < 48; j += 8)
-    {
-        std::copy(src, src + 48*8, dest);
-        src += 48*8;
-        dest += 64*8;
-    }
-    
-    return C2D_Image {tex, &subt3x};
+static C2D_Image loadTextureIcon(const u16* texels)
+{
+    C3D_Tex* tex = new C3D_Tex;
+    C3D_TexInit(tex, ICON_TEXTURE_SIZE, ICON_TEXTURE_SIZE, GPU_RGB565);
+    std::copy(texels, texels + ICON_TEXTURE_TEXELS, iconStart(tex));
+    return C2D_Image {tex, &iconSubTexture};
+}
+
+void Title::load(u64 id, FS_MediaType media, const std::string& name, const std::string& prefix, const u16* icon)
+{
+    mId = id;
+    mMedia = media;
+    mCard = CARD_CTR;
+    mName = name;
+    mPrefix = prefix;
+    mIcon = loadTextureIcon(icon);
+}
+
+const u16* Title::iconTexels(void)
+{
+    return mCard == CARD_CTR && mIcon.tex ? iconStart(mIcon.tex) : nullptr;
 }
 
 bool Title::load(u64 id, FS_MediaType media, FS_CardType card)
@@ -25,9 +25,11 @@
 */
 
 #include "loader.hpp"
+#include "BackupStore.hpp"
 #include "Configuration.hpp"
 #include "Directory.hpp"
 #include "FSStream.hpp"
+#include <algorithm>
 #include <ctime>
 
 static constexpr char langIds[8] = {
@@ -68,27 +70,150 @@ static constexpr std::array<unsigned long long, 8> ctrTitleIds = {
 // title list
 std::vector<std::shared_ptr<Title>> TitleLoader::nandTitles;
 std::shared_ptr<Title> TitleLoader::cardTitle = nullptr;
-std::unordered_map<std::string, std::vector<std::string>> TitleLoader::sdSaves;
+static std::unordered_map<std::string, std::vector<std::string>> sdSaves;
 std::shared_ptr<Sav> TitleLoader::save;
 
 static bool saveIsFile;
 static std::string saveFileName;
 static std::shared_ptr<Title> loadedTitle;
+// what the DS card's save chip holds, so writing a save back only touches the pages which changed. Only
+// trusted while cardShadowValid is set, which a failed read or write clears
+static std::vector<u8> cardShadow;
+static std::shared_ptr<Title> cardShadowTitle;
+static bool cardShadowValid = false;
+// what scanCard found the DS card's save to be
+static DSSaveType cardSaveType = DSSaveType::NONE;
 
-void TitleLoader::scanTitles(void)
+static Result readCardSave(std::shared_ptr<Title> title, u8* data, u32 size)
+{
+    Result res = 0;
+    u32 sectorSize = (size < 0x10000) ? size : 0x10000;
+    for (u32 i = 0; i < size / sectorSize; ++i)
+    {
+        res = SPIReadSaveData(title->SPICardType(), sectorSize * i, data + sectorSize * i, sectorSize);
+        if (R_FAILED(res))
+        {
+            break;
+        }
+    }
+    return res;
+}
+
+static bool readString(FILE* in, std::string& str)
+{
+    u16 size;
+    if (fread(&size, sizeof(size), 1, in) != 1)
+    {
+        return false;
+    }
+    str.resize(size);
+    return size == 0 || fread(&str[0], 1, size, in) == size;
+}
+
+static void writeString(FILE* out, const std::string& str)
+{
+    u16 size = str.size();
+    fwrite(&size, sizeof(size), 1, out);
+    fwrite(str.data(), 1, size, out);
+}
+
+// what a title's SMDH held the last time its version was seen
+struct TitleCacheEntry
+{
+    u16 version;
+    std::string name;
+    std::string prefix;
+    std::vector<u16> icon;
+};
+
+static constexpr const char* titleCachePath = "/3ds/PKSM/titlecache.bin";
+static constexpr u32 titleCacheVersion = 1;
+
+// layout: u32 version, u32 title count, then each title's u64 id, u16 version, name, prefix and icon texels
+static std::unordered_map<u64, TitleCacheEntry> readTitleCache(void)
+{
+    std::unordered_map<u64, TitleCacheEntry> cache;
+    FILE* in = fopen(titleCachePath, "rb");
+    if (in)
+    {
+        u32 header[2] = {0};
+        bool good = fread(header, sizeof(header), 1, in) == 1 && header[0] == titleCacheVersion;
+        for (u32 i = 0; good && i < header[1]; i++)
+        {
+            u64 id;
+            TitleCacheEntry entry;
+            entry.icon.resize(ICON_TEXTURE_TEXELS);
+            good = fread(&id, sizeof(id), 1, in) == 1 && fread(&entry.version, sizeof(entry.version), 1, in) == 1 &&
+                   readString(in, entry.name) && readString(in, entry.prefix) &&
+                   fread(entry.icon.data(), sizeof(u16), entry.icon.size(), in) == entry.icon.size();
+            if (good)
+            {
+                cache.emplace(id, std::move(entry));
+            }
+        }
+        fclose(in);
+        if (!good)
+        {
+            cache.clear();
+        }
+    }
+    return cache;
+}
+
+static void writeTitleCache(const std::vector<std::shared_ptr<Title>>& titles, const std::unordered_map<u64, u16>& versions)
+{
+    FILE* out = fopen(titleCachePath, "wb");
+    if (out)
+    {
+        u32 header[2] = {titleCacheVersion, (u32) titles.size()};
+        fwrite(header, sizeof(header), 1, out);
+        for (auto& title : titles)
+        {
+            u64 id = ((u64) title->highId() << 32) | title->lowId();
+            u16 version = versions.at(id);
+            fwrite(&id, sizeof(id), 1, out);
+            fwrite(&version, sizeof(version), 1, out);
+            writeString(out, title->name());
+            writeString(out, title->checkpointPrefix());
+            fwrite(title->iconTexels(), sizeof(u16), ICON_TEXTURE_TEXELS, out);
+        }
+        fclose(out);
+    }
+}
+
+static void sortTitles(std::vector<std::shared_ptr<Title>>& titles)
+{
+    std::sort(titles.begin(), titles.end(), [](std::shared_ptr<Title>& l, std::shared_ptr<Title>& r) {
+        return l->name() < r->name();
+    });
+}
+
+// the scan thread hands each list it builds to the main thread through pendingTitles, as nandTitles is only
+// touched there. titlesLock guards pendingTitles and titlesPending
+static LightLock titlesLock;
+static std::vector<std::shared_ptr<Title>> pendingTitles;
+static bool titlesPending = false;
+
+static void publishTitles(const std::vector<std::shared_ptr<Title>>& titles)
+{
+    LightLock_Lock(&titlesLock);
+    pendingTitles = titles;
+    titlesPending = true;
+    LightLock_Unlock(&titlesLock);
+}
+
+static void scanTitlesThread(void*)
 {
     Result res = 0;
     u32 count = 0;
     
-    // clear title list if filled previously
-    nandTitles.clear();
-
-    scanCard();
+    TitleLoader::scanCard();
 
     // get title count
     res = AM_GetTitleCount(MEDIATYPE_SD, &count);
     if (R_FAILED(res))
     {
+        publishTitles({});
         return;
     }
 
@@ -98,192 +223,418 @@ void TitleLoader::scanTitles(void)
     res = AM_GetTitleList(NULL, MEDIATYPE_SD, count, p);
     if (R_FAILED(res))
     {
+        publishTitles({});
         return;
     }
 
+    std::vector<u64> installed;
     for (size_t i = 0; i < ctrTitleIds.size(); i++)
     {
-        u64 id = ctrTitleIds.at(i);
-        if (std::find(ids.begin(), ids.end(), id) != ids.end())
+        if (std::find(ids.begin(), ids.end(), ctrTitleIds[i]) != ids.end())
+        {
+            installed.push_back(ctrTitleIds[i]);
+        }
+    }
+
+    // titles whose version hasn't changed are shown from the cache straight away, the rest are read afterwards
+    std::vector<AM_TitleEntry> info(installed.size());
+    bool versionsKnown = !installed.empty() && R_SUCCEEDED(AM_GetTitleInfo(MEDIATYPE_SD, installed.size(), installed.data(), info.data()));
+    std::unordered_map<u64, u16> versions;
+    auto cache = readTitleCache();
+    std::vector<std::shared_ptr<Title>> titles;
+    std::vector<u64> stale;
+    for (size_t i = 0; i < installed.size(); i++)
+    {
+        auto cached = cache.find(installed[i]);
+        if (versionsKnown && cached != cache.end() && cached->second.version == info[i].version)
         {
             auto title = std::make_shared<Title>();
-            if (title->load(id, MEDIATYPE_SD, CARD_CTR))
-            {
-                nandTitles.push_back(title);
-            }
+            title->load(installed[i], MEDIATYPE_SD, cached->second.name, cached->second.prefix, cached->second.icon.data());
+            titles.push_back(title);
+        }
+        else
+        {
+            stale.push_back(installed[i]);
+        }
+        if (versionsKnown)
+        {
+            versions[installed[i]] = info[i].version;
         }
     }
+    sortTitles(titles);
+    publishTitles(titles);
 
-    // sort the list alphabetically
-    std::sort(nandTitles.begin(), nandTitles.end(), [](std::shared_ptr<Title>& l, std::shared_ptr<Title>& r) {
-        return l->name() < r->name();
-    });
+    for (auto id : stale)
+    {
+        auto title = std::make_shared<Title>();
+        if (title->load(id, MEDIATYPE_SD, CARD_CTR))
+        {
+            titles.push_back(title);
+        }
+    }
+
+    if (!stale.empty())
+    {
+        sortTitles(titles);
+        publishTitles(titles);
+    }
+
+    // only titles with a save to load are listed, so those without aren't cached and get checked again next time
+    if (versionsKnown && (!stale.empty() || cache.size() != titles.size()))
+    {
+        writeTitleCache(titles, versions);
+    }
 }
 
-void TitleLoader::scanSaves(void)
+void TitleLoader::scanTitles(void)
 {
-    std::u16string chkpntDir = StringUtils::UTF8toUTF16("/3ds/Checkpoint/saves");
-    Directory checkpoint(Archive::sd(), chkpntDir);
-    std::u16string sSeparator = StringUtils::UTF8toUTF16("/");
-    for (size_t i = 0; i < ctrTitleIds.size(); i++)
+    LightLock_Init(&titlesLock);
+    Threads::create((ThreadFunc)scanTitlesThread);
+}
+
+bool TitleLoader::updateTitles(void)
+{
+    LightLock_Lock(&titlesLock);
+    bool updated = titlesPending;
+    if (updated)
     {
-        u32 uniqueId = (u32) ctrTitleIds[i] >> 8;
-        std::string id = StringUtils::format("0x%05X", uniqueId);
-        std::vector<std::string> saves;
-        for (size_t j = 0; j < checkpoint.count(); j++)
+        // the old list is swapped out and freed here rather than on the scan thread
+        nandTitles.swap(pendingTitles);
+        pendingTitles.clear();
+        titlesPending = false;
+    }
+    LightLock_Unlock(&titlesLock);
+    return updated;
+}
+
+// a Checkpoint title folder's backups, as they were when the folder was last listed
+struct SaveFolder
+{
+    u64 mtime;
+    std::vector<std::string> saves;
+};
+
+static constexpr const char* saveCachePath = "/3ds/PKSM/savecache.bin";
+static constexpr u32 saveCacheVersion = 1;
+static const std::string chkpntDir = "/3ds/Checkpoint/saves";
+
+// sdSaves is filled in by the scan thread while the UI reads it, savesLock guards both it and savesCount
+static LightLock savesLock;
+static u32 savesCount = 0;
+static std::vector<std::string> saveIds;
+
+// layout: u32 version, u32 folder count, then each folder's name, u64 mtime, u32 save count and save names
+static std::unordered_map<std::string, SaveFolder> readSaveCache(void)
+{
+    std::unordered_map<std::string, SaveFolder> cache;
+    FILE* in = fopen(saveCachePath, "rb");
+    if (in)
+    {
+        u32 header[2] = {0};
+        bool good = fread(header, sizeof(header), 1, in) == 1 && header[0] == saveCacheVersion;
+        for (u32 i = 0; good && i < header[1]; i++)
         {
-            if (checkpoint.folder(j))
+            std::string name;
+            SaveFolder folder;
+            u32 count = 0;
+            good = readString(in, name) && fread(&folder.mtime, sizeof(folder.mtime), 1, in) == 1 && fread(&count, sizeof(count), 1, in) == 1;
+            for (u32 j = 0; good && j < count; j++)
             {
-                std::u16string fileName = checkpoint.item(j);
-                if (fileName.substr(0, 7) == StringUtils::UTF8toUTF16(id.c_str()))
-                {
-                    Directory subdir(Archive::sd(), chkpntDir + sSeparator + fileName);
-                    for (size_t k = 0; k < subdir.count(); k++)
-                    {
-                        if (subdir.folder(k))
-                        {
-                            std::u16string savePath = chkpntDir + sSeparator + fileName + sSeparator + subdir.item(k)
-                                                      + StringUtils::UTF8toUTF16("/main");
-                            saves.push_back(StringUtils::UTF16toUTF8(savePath));
-                        }
-                    }
-                }
+                folder.saves.emplace_back();
+                good = readString(in, folder.saves.back());
             }
-        }
-        auto others = Configuration::getInstance().extraSaves(id);
-        if (!others.first.empty())
-        {
-            for (auto saveDir : others.first)
+            if (good)
             {
-                Directory dir(Archive::sd(), StringUtils::UTF8toUTF16(saveDir));
-                for (size_t j = 0; j < dir.count(); j++)
-                {
-                    if (dir.folder(j))
-                    {
-                        saves.push_back(saveDir + StringUtils::UTF16toUTF8(sSeparator + dir.item(j)) + "/main");
-                    }
-                }
+                cache.emplace(std::move(name), std::move(folder));
             }
         }
-        if (!others.second.empty())
+        fclose(in);
+        if (!good)
         {
-            for (auto save : others.second)
+            cache.clear();
+        }
+    }
+    return cache;
+}
+
+static void writeSaveCache(const std::unordered_map<std::string, SaveFolder>& cache)
+{
+    FILE* out = fopen(saveCachePath, "wb");
+    if (out)
+    {
+        u32 header[2] = {saveCacheVersion, (u32) cache.size()};
+        fwrite(header, sizeof(header), 1, out);
+        for (auto& folder : cache)
+        {
+            writeString(out, folder.first);
+            fwrite(&folder.second.mtime, sizeof(folder.second.mtime), 1, out);
+            u32 count = folder.second.saves.size();
+            fwrite(&count, sizeof(count), 1, out);
+            for (auto& save : folder.second.saves)
             {
-                saves.push_back(save);
+                writeString(out, save);
             }
         }
-        sdSaves[id] = saves;
+        fclose(out);
     }
+}
 
-    for (size_t game = 0; game < 9; game++)
+static void addSaves(const std::string& id, const std::vector<std::string>& saves)
+{
+    if (!saves.empty())
     {
-        for (size_t lang = 0; lang < 8; lang++)
+        LightLock_Lock(&savesLock);
+        auto& found = sdSaves[id];
+        found.insert(found.end(), saves.begin(), saves.end());
+        savesCount++;
+        LightLock_Unlock(&savesLock);
+    }
+}
+
+// the full paths of the backups in a Checkpoint title folder
+static std::vector<std::string> savePaths(const std::string& fileName, const std::vector<std::string>& saves)
+{
+    bool ctr = fileName.compare(0, 2, "0x") == 0;
+    std::string file = ctr ? "/main" : '/' + fileName.substr(std::min<size_t>(5, fileName.size())) + ".sav";
+    std::vector<std::string> paths;
+    for (auto& save : saves)
+    {
+        paths.push_back(chkpntDir + '/' + fileName + '/' + save + file);
+    }
+    return paths;
+}
+
+// swaps a title's paths from a folder which turned out to have changed for the ones it has now
+static void replaceSaves(const std::string& id, const std::vector<std::string>& stale, const std::vector<std::string>& saves)
+{
+    LightLock_Lock(&savesLock);
+    auto& found = sdSaves[id];
+    for (auto& save : stale)
+    {
+        auto it = std::find(found.begin(), found.end(), save);
+        if (it != found.end())
+        {
+            found.erase(it);
+        }
+    }
+    found.insert(found.end(), saves.begin(), saves.end());
+    savesCount++;
+    LightLock_Unlock(&savesLock);
+}
+
+// the backup folders in a Checkpoint title folder
+static std::vector<std::string> listSaveFolder(const std::string& path)
+{
+    std::vector<std::string> saves;
+    Directory subdir(Archive::sd(), StringUtils::UTF8toUTF16(path));
+    for (size_t j = 0; j < subdir.count(); j++)
+    {
+        if (subdir.folder(j))
+        {
+            saves.push_back(StringUtils::UTF16toUTF8(subdir.item(j)));
+        }
+    }
+    return saves;
+}
+
+// the paths configured for a title on top of the Checkpoint ones
+static std::vector<std::string> extraSaves(const std::string& id)
+{
+    std::vector<std::string> saves;
+    bool ds = id.size() == 4;
+    auto others = Configuration::getInstance().extraSaves(id);
+    for (auto& saveDir : others.first)
+    {
+        Directory dir(Archive::sd(), StringUtils::UTF8toUTF16(saveDir));
+        for (size_t i = 0; i < dir.count(); i++)
         {
-            std::string id = std::string(dsIds[game]) + langIds[lang];
-            std::vector<std::string> saves;
-            for (size_t i = 0; i < checkpoint.count(); i++)
+            if (dir.folder(i))
             {
-                if (checkpoint.folder(i))
+                std::string thisDir = saveDir + '/' + StringUtils::UTF16toUTF8(dir.item(i));
+                if (!ds)
                 {
-                    std::u16string fileName = checkpoint.item(i);
-                    if (StringUtils::UTF16toUTF8(fileName).substr(0, 4) == id)
-                    {
-                        Directory subdir(Archive::sd(), chkpntDir + sSeparator + fileName);
-                        {
-                            for(size_t j = 0; j < subdir.count(); j++)
-                            {
-                                if (subdir.folder(j))
-                                {
-                                    std::u16string savePath = chkpntDir + sSeparator + fileName + sSeparator + subdir.item(j) + sSeparator
-                                                              + fileName.substr(5) + StringUtils::UTF8toUTF16(".sav");
-                                    saves.push_back(StringUtils::UTF16toUTF8(savePath));
-                                }
-                            }
-                        }
-                    }
+                    saves.push_back(thisDir + "/main");
+                    continue;
                 }
-            }
-            auto others = Configuration::getInstance().extraSaves(id);
-            if (!others.first.empty())
-            {
-                for (auto saveDir : others.first)
+                Directory subdir(Archive::sd(), StringUtils::UTF8toUTF16(thisDir));
+                for (size_t j = 0; j < subdir.count(); j++)
                 {
-                    Directory dir(Archive::sd(), StringUtils::UTF8toUTF16(saveDir));
-                    for (size_t i = 0; i < dir.count(); i++)
+                    std::string file = StringUtils::UTF16toUTF8(subdir.item(j));
+                    if (file.size() >= 3 && file.compare(file.size() - 3, 3, "sav") == 0)
                     {
-                        if (dir.folder(i))
-                        {
-                            std::u16string thisDir = StringUtils::UTF8toUTF16(saveDir) + sSeparator + dir.item(i);
-                            Directory subdir(Archive::sd(), thisDir);
-                            for (size_t j = 0; j < subdir.count(); j++)
-                            {
-                                std::u16string file = subdir.item(j);
-                                if (file.substr(file.size() - 3) == StringUtils::UTF8toUTF16("sav"))
-                                {
-                                    saves.push_back(StringUtils::UTF16toUTF8(thisDir + sSeparator + file));
-                                }
-                            }
-                        }
+                        saves.push_back(thisDir + '/' + file);
                     }
                 }
             }
-            if (!others.second.empty())
-            {
-                for (auto save : others.second)
-                {
-                    saves.push_back(save);
-                }
-            }
-            sdSaves[id] = saves;
         }
     }
+    saves.insert(saves.end(), others.second.begin(), others.second.end());
+    return saves;
+}
+
+// one pass over the Checkpoint folder: each title folder is matched to its id by name, and only listed
+// again if it has changed since the last launch. Results are published as they're found. FAT doesn't always
+// update a folder's mtime, so once everything is published the folders taken from the cache are listed
+// again anyway, and any which were stale are published a second time
+static void scanSavesThread(void*)
+{
+    auto cache = readSaveCache();
+    bool cacheChanged = false;
+    std::unordered_map<std::string, SaveFolder> seen;
+    // the folders taken from the cache, as name and title id
+    std::vector<std::pair<std::string, std::string>> unchecked;
+
+    Directory checkpoint(Archive::sd(), StringUtils::UTF8toUTF16(chkpntDir));
+    for (size_t i = 0; i < checkpoint.count(); i++)
+    {
+        if (!checkpoint.folder(i))
+        {
+            continue;
+        }
+
+        // Checkpoint names 3DS title folders "0x<unique id> <name>" and DS ones "<game code><lang> <name>"
+        std::string fileName = StringUtils::UTF16toUTF8(checkpoint.item(i));
+        bool ctr = fileName.compare(0, 2, "0x") == 0;
+        std::string id = fileName.substr(0, ctr ? 7 : 4);
+        // every key is added before the thread starts, so they can be looked up without the lock
+        if (sdSaves.find(id) == sdSaves.end())
+        {
+            continue;
+        }
+
+        std::string path = chkpntDir + '/' + fileName;
+        u64 mtime = 0;
+        bool dated = R_SUCCEEDED(sdmc_getmtime(path.c_str(), &mtime));
+        SaveFolder folder;
+        auto cached = cache.find(fileName);
+        if (dated && cached != cache.end() && cached->second.mtime == mtime)
+        {
+            folder = std::move(cached->second);
+            unchecked.emplace_back(fileName, id);
+        }
+        else
+        {
+            folder.mtime = mtime;
+            folder.saves = listSaveFolder(path);
+            cacheChanged = true;
+        }
+
+        addSaves(id, savePaths(fileName, folder.saves));
+
+        if (dated)
+        {
+            seen.emplace(fileName, std::move(folder));
+        }
+    }
+
+    for (auto& id : saveIds)
+    {
+        addSaves(id, extraSaves(id));
+    }
+
+    for (auto& folder : unchecked)
+    {
+        auto& cached = seen[folder.first];
+        auto saves = listSaveFolder(chkpntDir + '/' + folder.first);
+        if (saves != cached.saves)
+        {
+            replaceSaves(folder.second, savePaths(folder.first, cached.saves), savePaths(folder.first, saves));
+            cached.saves = std::move(saves);
+            cacheChanged = true;
+        }
+    }
+
+    // folders which have been removed also need dropping
+    if (cacheChanged || seen.size() != cache.size())
+    {
+        writeSaveCache(seen);
+    }
+}
+
+void TitleLoader::scanSaves(void)
+{
+    LightLock_Init(&savesLock);
+    saveIds.clear();
+    for (size_t i = 0; i < ctrTitleIds.size(); i++)
+    {
+        saveIds.push_back(StringUtils::format("0x%05X", (u32) ctrTitleIds[i] >> 8));
+    }
+    for (size_t game = 0; game < 9; game++)
+    {
+        for (size_t lang = 0; lang < 8; lang++)
+        {
+            saveIds.push_back(std::string(dsIds[game]) + langIds[lang]);
+        }
+    }
+
+    sdSaves.clear();
+    for (auto& id : saveIds)
+    {
+        sdSaves[id] = {};
+    }
+    savesCount = 0;
+
+    Threads::create((ThreadFunc)scanSavesThread, 0x8000);
+}
+
+std::vector<std::string> TitleLoader::savesFor(const std::string& id)
+{
+    LightLock_Lock(&savesLock);
+    auto found = sdSaves.find(id);
+    std::vector<std::string> saves = found != sdSaves.end() ? found->second : std::vector<std::string>{};
+    LightLock_Unlock(&savesLock);
+    return saves;
+}
+
+std::unordered_map<std::string, std::vector<std::string>> TitleLoader::allSaves(void)
+{
+    LightLock_Lock(&savesLock);
+    auto saves = sdSaves;
+    LightLock_Unlock(&savesLock);
+    return saves;
+}
+
+u32 TitleLoader::savesVersion(void)
+{
+    LightLock_Lock(&savesLock);
+    u32 count = savesCount;
+    LightLock_Unlock(&savesLock);
+    return count;
 }
 
 void TitleLoader::backupSave()
 {
     Gui::waitFrame(i18n::localize("LOADER_BACKING_UP"));
-    char stringTime[15] = {0};
-    time_t unixTime = time(NULL);
-    struct tm* timeStruct = gmtime((const time_t *)&unixTime);
-    std::strftime(stringTime, 14,"%Y%m%d%H%M%S", timeStruct);
-    std::string path = "/3ds/PKSM/backups/";
+    std::string name;
     if (loadedTitle)
     {
-        path += loadedTitle->checkpointPrefix();
+        name = loadedTitle->checkpointPrefix();
     }
     else
     {
-        path += saveFileName.substr(saveFileName.find_last_of('/') + 1);
-        path = path.substr(0, path.find(".sav"));
+        name = saveFileName.substr(saveFileName.find_last_of('/') + 1);
+        name = name.substr(0, name.find(".sav"));
     }
-    mkdir(path.c_str(), 777);
-    path += '/' + std::string(stringTime);
-    mkdir(path.c_str(), 777);
+    std::string fileName;
     if (!loadedTitle || saveIsFile)
     {
-        path += '/' + saveFileName.substr(saveFileName.find_last_of('/') + 1);
+        fileName = saveFileName.substr(saveFileName.find_last_of('/') + 1);
     }
     else
     {
         if (save->generation() == Generation::FOUR || save->generation() == Generation::FIVE)
         {
-            path += '/' + loadedTitle->name() + ".sav";
+            fileName = loadedTitle->name() + ".sav";
         }
         else
         {
-            path += "/main";
+            fileName = "main";
         }
     }
-    FSStream out = FSStream(Archive::sd(), StringUtils::UTF8toUTF16(path), FS_OPEN_WRITE | FS_OPEN_CREATE, TitleLoader::save->length);
-    if (out.good())
-    {
-        out.write(TitleLoader::save->data, TitleLoader::save->length);
-    }
-    else
+    if (!BackupStore::backup(name, fileName, TitleLoader::save->data, TitleLoader::save->length))
     {
         Gui::warn(i18n::localize("BAD_OPEN_BACKUP"));
     }
-    out.close();
 }
 
 bool TitleLoader::load(u8* data, size_t size)
@@ -333,14 +684,36 @@ bool TitleLoader::load(std::shared_ptr<Title> title)
             return false;
         }
 
+        // the chip only changes through saveToTitle, which keeps the shadow up to date, so it's only read once
         u8* data = new u8[cap];
-        u32 sectorSize = (cap < 0x10000) ? cap : 0x10000;
-
-        for (u32 i = 0; i < cap / sectorSize; ++i) {
-            SPIReadSaveData(title->SPICardType(), sectorSize * i, data + sectorSize * i, sectorSize);
+        Result res;
+        if (cardShadowValid && cardShadowTitle == title && cardShadow.size() == cap)
+        {
+            std::copy(cardShadow.begin(), cardShadow.end(), data);
+        }
+        else if (R_SUCCEEDED(res = readCardSave(title, data, cap)))
+        {
+            cardShadow.assign(data, data + cap);
+            cardShadowTitle = title;
+            cardShadowValid = true;
+        }
+        else
+        {
+            cardShadowValid = false;
+            delete[] data;
+            loadedTitle = nullptr;
+            Gui::error(i18n::localize("BAD_OPEN_SAVE"), res);
+            return false;
         }
 
-        save = Sav::getSave(data, cap);
+        if (title == cardTitle && cardSaveType != DSSaveType::NONE)
+        {
+            save = Sav::getDSSave(data, cardSaveType);
+        }
+        else
+        {
+            save = Sav::getSave(data, cap);
+        }
         delete[] data;
         if (Configuration::getInstance().autoBackup())
         {
@@ -424,17 +797,26 @@ void TitleLoader::saveToTitle(bool ask)
             }
             else
             {
-                Result res = 0;
-                u32 pageSize = SPIGetPageSize(title->SPICardType());
-                for (u32 i = 0; i < save->length / pageSize; ++i)
+                // the save may have come from a file rather than this card, then the chip has to be read first
+                if (!cardShadowValid || cardShadowTitle != title || cardShadow.size() != save->length)
                 {
-                    res = SPIWriteSaveData(title->SPICardType(), pageSize * i, save->data + pageSize * i, pageSize);
-                    if (R_FAILED(res))
+                    cardShadow.resize(save->length);
+                    cardShadowTitle = title;
+                    cardShadowValid = R_SUCCEEDED(readCardSave(title, cardShadow.data(), cardShadow.size()));
+                    if (!cardShadowValid)
                     {
-                        break;
+                        // nothing can be skipped without knowing what's there
+                        std::transform(save->data, save->data + save->length, cardShadow.begin(), [](u8 v) { return (u8)~v; });
                     }
-                    Gui::showRestoreProgress(pageSize * (i + 1), save->length);
                 }
+                // a failed write leaves the chip somewhere between the two, so it has to be read again
+                if (R_FAILED(res = SPIWriteChangedSaveData(title->SPICardType(), save->data, cardShadow.data(), save->length, &Gui::showRestoreProgress)))
+                {
+                    cardShadowValid = false;
+                    Gui::error(i18n::localize("FAIL_CARD_WRITE"), res);
+                    return;
+                }
+                cardShadowValid = true;
             }
         }
         else
@@ -510,6 +892,7 @@ void TitleLoader::scanCard()
         isScanning = true;
     }
     cardTitle = nullptr;
+    cardSaveType = DSSaveType::NONE;
     Result res = 0;
     u32 count = 0;
     // check for cartridge and push at the beginning of the title list
@@ -542,25 +925,29 @@ void TitleLoader::scanCard()
             auto title = std::make_shared<Title>();
             if (title->load(0, MEDIATYPE_GAME_CARD, cardType))
             {
+                // only the few parts of the save which identify the game are read
                 CardType cardType = title->SPICardType();
-                u32 saveSize = SPIGetCapacity(cardType);
-                u32 sectorSize = (saveSize < 0x10000) ? saveSize : 0x10000;
-                u8* saveFile = new u8[saveSize];
-                for (u32 i = 0; i < saveSize/sectorSize; ++i)
+                if (SPIGetCapacity(cardType) >= 0x80000)
                 {
-                    res = SPIReadSaveData(cardType, sectorSize*i, saveFile + sectorSize*i, sectorSize);
-                    if (R_FAILED(res))
+                    std::vector<u8> saveFile(0x80000);
+                    for (auto& region : Sav::dsProbeRegions)
                     {
-                        break;
+                        res = SPIReadSaveData(cardType, region.first, saveFile.data() + region.first, region.second);
+                        if (R_FAILED(res))
+                        {
+                            break;
+                        }
                     }
-                }
 
-                if (R_SUCCEEDED(res) && Sav::isValidDSSave(saveFile))
-                {
-                    cardTitle = title;
+                    if (R_SUCCEEDED(res))
+                    {
+                        cardSaveType = Sav::dsSaveType(saveFile.data());
+                        if (cardSaveType != DSSaveType::NONE)
+                        {
+                            cardTitle = title;
+                        }
+                    }
                 }
-
-                delete[] saveFile;
             }
         }
     }
@@ -26,50 +26,84 @@
 
 #include "base64.h"
 
-static char encoding_table[] = {
-	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
-	'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-	'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
-	'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-	'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
-	'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-	'w', 'x', 'y', 'z', '0', '1', '2', '3',
-	'4', '5', '6', '7', '8', '9', '+', '/'
+// sextet for each character, with bit 7 set for anything that isn't base64
+static const unsigned char decoding_table[256] = {
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3E, 0x80, 0x80, 0x80, 0x3F,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
 };
-static char *decoding_table = NULL;
 
-unsigned char *base64_decode(const char *data, size_t input_length, size_t *output_length)
+size_t base64_decoded_length(const char *data, size_t input_length)
 {
-    decoding_table = malloc(256);
-    for (int i = 0; i < 64; i++)
-        decoding_table[(unsigned char) encoding_table[i]] = i;
+    if (input_length == 0 || input_length % 4 != 0) return 0;
 
-    if (input_length % 4 != 0) return NULL;
+    size_t length = input_length / 4 * 3;
+    if (data[input_length - 1] == '=') length--;
+    if (data[input_length - 2] == '=') length--;
+    return length;
+}
 
-    *output_length = input_length / 4 * 3;
-    if (data[input_length - 1] == '=') (*output_length)--;
-    if (data[input_length - 2] == '=') (*output_length)--;
+size_t base64_decode_to(const char *data, size_t input_length, unsigned char *out, size_t out_length)
+{
+    size_t length = base64_decoded_length(data, input_length);
+    if (length == 0 || length > out_length) return 0;
 
-    unsigned char *decoded_data = malloc(*output_length);
-    if (decoded_data == NULL) return NULL;
+    const unsigned char *in = (const unsigned char *)data;
+    uint32_t invalid = 0;
 
-    for (size_t i = 0, j = 0; i < input_length;) {
+    // every quad but a padded last one decodes to three whole bytes, so there's no per-byte bounds check.
+    // Invalid characters are only checked for once at the end
+    for (size_t i = 0; i < length / 3; i++, in += 4, out += 3) {
+        uint32_t sextet_a = decoding_table[in[0]];
+        uint32_t sextet_b = decoding_table[in[1]];
+        uint32_t sextet_c = decoding_table[in[2]];
+        uint32_t sextet_d = decoding_table[in[3]];
+        invalid |= sextet_a | sextet_b | sextet_c | sextet_d;
 
-        uint32_t sextet_a = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
-        uint32_t sextet_b = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
-        uint32_t sextet_c = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
-        uint32_t sextet_d = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
+        uint32_t triple = (sextet_a << 18) | (sextet_b << 12) | (sextet_c << 6) | sextet_d;
+        out[0] = triple >> 16;
+        out[1] = triple >> 8;
+        out[2] = triple;
+    }
 
-        uint32_t triple = (sextet_a << 3 * 6)
-        + (sextet_b << 2 * 6)
-        + (sextet_c << 1 * 6)
-        + (sextet_d << 0 * 6);
+    if (length % 3 != 0) {
+        uint32_t sextet_a = decoding_table[in[0]];
+        uint32_t sextet_b = decoding_table[in[1]];
+        uint32_t sextet_c = length % 3 == 2 ? decoding_table[in[2]] : 0;
+        invalid |= sextet_a | sextet_b | sextet_c;
 
-        if (j < *output_length) decoded_data[j++] = (triple >> 2 * 8) & 0xFF;
-        if (j < *output_length) decoded_data[j++] = (triple >> 1 * 8) & 0xFF;
-        if (j < *output_length) decoded_data[j++] = (triple >> 0 * 8) & 0xFF;
+        uint32_t triple = (sextet_a << 18) | (sextet_b << 12) | (sextet_c << 6);
+        out[0] = triple >> 16;
+        if (length % 3 == 2) out[1] = triple >> 8;
     }
 
-	free(decoding_table);
+    return (invalid & 0x80) ? 0 : length;
+}
+
+unsigned char *base64_decode(const char *data, size_t input_length, size_t *output_length)
+{
+    *output_length = base64_decoded_length(data, input_length);
+    if (*output_length == 0) return NULL;
+
+    unsigned char *decoded_data = malloc(*output_length);
+    if (decoded_data == NULL) return NULL;
+
+    if (base64_decode_to(data, input_length, decoded_data, *output_length) == 0) {
+        free(decoded_data);
+        return NULL;
+    }
     return decoded_data;
-}
\ No newline at end of file
+}
@@ -25,82 +25,340 @@
 */
 
 #include "download.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/stat.h>
 
-static char* result_buf = NULL;
-static size_t result_sz = 0;
-static size_t result_written = 0;
+#define PATH_MAX_LENGTH 256
+#define META_MAX_LENGTH 256
 
-static size_t handle_data(char*, size_t, size_t, void*);
+/* Each transfer streams into "<path>.part", hashing as it goes, and is renamed over <path> once it's complete
+ * and matches its hash. A .part left behind by a failed transfer is resumed with a Range request, made
+ * conditional on the validators it was started with, which are kept in "<path>.part.meta". The ETag and
+ * Last-Modified of each download are kept in "<path>.meta" so an existing file can be revalidated instead of
+ * fetched again. */
+struct transfer {
+    struct download_item *item;
+    CURL *handle;
+    FILE *file;
+    SHA256_CTX sha;
+    curl_off_t resumeFrom;
+    struct curl_slist *headers;
+    char part[PATH_MAX_LENGTH];
+    char meta[PATH_MAX_LENGTH];
+    char partMeta[PATH_MAX_LENGTH];
+    char etag[META_MAX_LENGTH];
+    char lastModified[META_MAX_LENGTH];
+};
 
-Result download(const char* url, const char* path)
+static bool fileExists(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static void readMeta(struct transfer *t, const char *path)
+{
+    t->etag[0] = '\0';
+    t->lastModified[0] = '\0';
+    FILE *file = fopen(path, "r");
+    if (file) {
+        if (fgets(t->etag, META_MAX_LENGTH, file))
+            t->etag[strcspn(t->etag, "\r\n")] = '\0';
+        if (fgets(t->lastModified, META_MAX_LENGTH, file))
+            t->lastModified[strcspn(t->lastModified, "\r\n")] = '\0';
+        fclose(file);
+    }
+}
+
+static void writeMeta(struct transfer *t, const char *path)
+{
+    if (t->etag[0] == '\0' && t->lastModified[0] == '\0') {
+        remove(path);
+        return;
+    }
+    FILE *file = fopen(path, "w");
+    if (file) {
+        fprintf(file, "%s\n%s\n", t->etag, t->lastModified);
+        fclose(file);
+    }
+}
+
+/* keeps the validators of the final response, redirects and all */
+static size_t handle_header(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    struct transfer *t = userdata;
+    const size_t bsz = size*nmemb;
+    char *dest = NULL;
+    size_t name = 0;
+
+    if (bsz > 5 && strncmp(ptr, "HTTP/", 5) == 0) {
+        t->etag[0] = '\0';
+        t->lastModified[0] = '\0';
+    } else if (bsz > 5 && strncasecmp(ptr, "ETag:", 5) == 0) {
+        dest = t->etag;
+        name = 5;
+    } else if (bsz > 14 && strncasecmp(ptr, "Last-Modified:", 14) == 0) {
+        dest = t->lastModified;
+        name = 14;
+    }
+
+    if (dest) {
+        while (name < bsz && ptr[name] == ' ')
+            name++;
+        size_t length = bsz - name;
+        while (length > 0 && (ptr[name + length - 1] == '\r' || ptr[name + length - 1] == '\n'))
+            length--;
+        if (length < META_MAX_LENGTH) {
+            memcpy(dest, ptr + name, length);
+            dest[length] = '\0';
+        }
+    }
+    return bsz;
+}
+
+static size_t handle_data(char *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    struct transfer *t = userdata;
+    const size_t bsz = size*nmemb;
+
+    if (!t->file || fwrite(ptr, 1, bsz, t->file) != bsz)
+        return 0;
+    sha256_update(&t->sha, (const BYTE *)ptr, bsz);
+    return bsz;
+}
+
+/* hashes what an earlier attempt left in the .part file, so the hash carries on from there */
+static curl_off_t hashPartial(struct transfer *t)
 {
-    CURL *hnd = curl_easy_init();
+    curl_off_t size = 0;
+    FILE *file = fopen(t->part, "rb");
+    if (file) {
+        BYTE *buffer = malloc(0x10000);
+        size_t read;
+        while (buffer && (read = fread(buffer, 1, 0x10000, file)) > 0) {
+            sha256_update(&t->sha, buffer, read);
+            size += read;
+        }
+        free(buffer);
+        fclose(file);
+    }
+    return size;
+}
+
+static bool transferStart(struct transfer *t, struct download_item *item)
+{
+    memset(t, 0, sizeof(*t));
+    t->item = item;
+    item->result = -1;
+    if (snprintf(t->part, PATH_MAX_LENGTH, "%s.part", item->path) >= PATH_MAX_LENGTH ||
+        snprintf(t->meta, PATH_MAX_LENGTH, "%s.meta", item->path) >= PATH_MAX_LENGTH ||
+        snprintf(t->partMeta, PATH_MAX_LENGTH, "%s.part.meta", item->path) >= PATH_MAX_LENGTH)
+        return false;
+
+    /* a .part is only resumed if the server can say whether the file is still the one it was started on, or
+     * the hash will catch it if not */
+    sha256_init(&t->sha);
+    if (fileExists(t->part)) {
+        readMeta(t, t->partMeta);
+        if (t->etag[0] != '\0' || t->lastModified[0] != '\0' || item->sha256)
+            t->resumeFrom = hashPartial(t);
+    }
+
+    char header[META_MAX_LENGTH + 32];
+    if (t->resumeFrom > 0) {
+        /* if the file changed, If-Range gets the whole of it back instead, which curl fails with
+         * CURLE_RANGE_ERROR so it's fetched again from the start. Weak ETags can't be used for it */
+        if (t->etag[0] != '\0' && strncmp(t->etag, "W/", 2) != 0) {
+            snprintf(header, sizeof(header), "If-Range: %s", t->etag);
+            t->headers = curl_slist_append(t->headers, header);
+        } else if (t->lastModified[0] != '\0') {
+            snprintf(header, sizeof(header), "If-Range: %s", t->lastModified);
+            t->headers = curl_slist_append(t->headers, header);
+        }
+    } else {
+        /* a file with an expected hash is only fetched again because the one on disk doesn't have it, so it
+         * mustn't be revalidated: a 304 would keep it */
+        readMeta(t, t->meta);
+        if (!item->sha256 && fileExists(item->path)) {
+            if (t->etag[0] != '\0') {
+                snprintf(header, sizeof(header), "If-None-Match: %s", t->etag);
+                t->headers = curl_slist_append(t->headers, header);
+            }
+            if (t->lastModified[0] != '\0') {
+                snprintf(header, sizeof(header), "If-Modified-Since: %s", t->lastModified);
+                t->headers = curl_slist_append(t->headers, header);
+            }
+        }
+    }
+
+    t->file = fopen(t->part, t->resumeFrom > 0 ? "ab" : "wb");
+    t->handle = curl_easy_init();
+    if (!t->file || !t->handle)
+        return false;
+
+    CURL *hnd = t->handle;
     curl_easy_setopt(hnd, CURLOPT_BUFFERSIZE, 102400L);
-    curl_easy_setopt(hnd, CURLOPT_URL, (const uint8_t*)url);
+    curl_easy_setopt(hnd, CURLOPT_URL, (const uint8_t*)item->url);
     curl_easy_setopt(hnd, CURLOPT_NOPROGRESS, 1L);
     curl_easy_setopt(hnd, CURLOPT_USERAGENT, "PKSM-curl/7.59.0");
     curl_easy_setopt(hnd, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(hnd, CURLOPT_MAXREDIRS, 50L);
     curl_easy_setopt(hnd, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
     curl_easy_setopt(hnd, CURLOPT_WRITEFUNCTION, handle_data);
+    curl_easy_setopt(hnd, CURLOPT_WRITEDATA, t);
+    curl_easy_setopt(hnd, CURLOPT_HEADERFUNCTION, handle_header);
+    curl_easy_setopt(hnd, CURLOPT_HEADERDATA, t);
+    curl_easy_setopt(hnd, CURLOPT_FAILONERROR, 1L);
     curl_easy_setopt(hnd, CURLOPT_SSL_VERIFYPEER, 0L);
     curl_easy_setopt(hnd, CURLOPT_VERBOSE, 0L);
-    CURLcode cres = curl_easy_perform(hnd);
-    
-    // cleanup
-    curl_easy_cleanup(hnd);
-    result_sz = 0;
-
-    if (cres == CURLE_OK)
-    {
-        // write to disk
-        FILE* file = fopen(path, "wb");
-        fwrite(result_buf, result_written, 1, file);
-        fclose(file);
+    if (t->resumeFrom > 0)
+        curl_easy_setopt(hnd, CURLOPT_RESUME_FROM_LARGE, t->resumeFrom);
+    if (t->headers)
+        curl_easy_setopt(hnd, CURLOPT_HTTPHEADER, t->headers);
+    return true;
+}
+
+static void transferFinish(struct transfer *t, CURLcode cres)
+{
+    long code = 0;
+    if (t->handle)
+        curl_easy_getinfo(t->handle, CURLINFO_RESPONSE_CODE, &code);
+    if (t->file)
+        fclose(t->file);
+    t->file = NULL;
+
+    if (cres == CURLE_OK && code == 304) {
+        /* the file we have is still current */
+        remove(t->part);
+        remove(t->partMeta);
+        t->item->result = 0;
+    } else if (cres == CURLE_OK) {
+        BYTE hash[SHA256_BLOCK_SIZE];
+        sha256_final(&t->sha, hash);
+        remove(t->partMeta);
+        if (t->item->sha256 && memcmp(hash, t->item->sha256, SHA256_BLOCK_SIZE) != 0) {
+            remove(t->part);
+            t->item->result = -1;
+        } else {
+            remove(t->item->path);
+            t->item->result = rename(t->part, t->item->path) == 0 ? 0 : -1;
+            writeMeta(t, t->meta);
+        }
+    } else {
+        /* a connection that dropped leaves the .part to resume from; anything the server refused, including
+         * a Range it doesn't support, starts over */
+        if (cres == CURLE_HTTP_RETURNED_ERROR || cres == CURLE_RANGE_ERROR || t->handle == NULL) {
+            remove(t->part);
+            remove(t->partMeta);
+        } else {
+            writeMeta(t, t->partMeta);
+        }
+        t->item->result = (Result)-cres;
     }
 
-    free(result_buf);
-    result_buf = NULL;
-    result_written = 0;
-    return cres == CURLE_OK ? 0 : (Result)-cres;
+    if (t->handle)
+        curl_easy_cleanup(t->handle);
+    curl_slist_free_all(t->headers);
+    t->handle = NULL;
+    t->headers = NULL;
 }
 
-// following code is from 
-// https://github.com/angelsl/libctrfgh/blob/master/curl_test/src/main.c
-static size_t handle_data(char* ptr, size_t size, size_t nmemb, void* userdata)
+Result download_all(struct download_item *items, size_t count)
 {
-    (void) userdata;
-    const size_t bsz = size*nmemb;
+    struct transfer *transfers = calloc(count, sizeof(struct transfer));
+    CURLM *multi = curl_multi_init();
+    Result res = 0;
+    size_t i;
 
-    if (result_sz == 0 || !result_buf)
-    {
-        result_sz = 0x1000;
-        result_buf = malloc(result_sz);
+    if (!transfers || !multi) {
+        free(transfers);
+        if (multi)
+            curl_multi_cleanup(multi);
+        return -1;
     }
 
-    bool need_realloc = false;
-    while (result_written + bsz > result_sz) 
-    {
-        result_sz <<= 1;
-        need_realloc = true;
+    for (i = 0; i < count; i++) {
+        if (transferStart(&transfers[i], &items[i]))
+            curl_multi_add_handle(multi, transfers[i].handle);
+        else
+            transferFinish(&transfers[i], CURLE_FAILED_INIT);
     }
 
-    if (need_realloc)
-    {
-        char *new_buf = realloc(result_buf, result_sz);
-        if (!new_buf)
-        {
-            return 0;
+    int running = 1;
+    while (running > 0) {
+        if (curl_multi_perform(multi, &running) != CURLM_OK)
+            break;
+        if (running > 0)
+            curl_multi_wait(multi, NULL, 0, 1000, NULL);
+    }
+
+    CURLMsg *msg;
+    int left;
+    while ((msg = curl_multi_info_read(multi, &left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        for (i = 0; i < count; i++) {
+            if (transfers[i].handle == msg->easy_handle) {
+                curl_multi_remove_handle(multi, msg->easy_handle);
+                transferFinish(&transfers[i], msg->data.result);
+                break;
+            }
         }
-        result_buf = new_buf;
     }
 
-    if (!result_buf)
-    {
-        return 0;
+    /* anything still attached didn't get to finish */
+    for (i = 0; i < count; i++) {
+        if (transfers[i].handle) {
+            curl_multi_remove_handle(multi, transfers[i].handle);
+            transferFinish(&transfers[i], CURLE_RECV_ERROR);
+        }
+        if (R_FAILED(items[i].result) && res == 0)
+            res = items[i].result;
     }
 
-    memcpy(result_buf + result_written, ptr, bsz);
-    result_written += bsz;
-    return bsz;
-}
\ No newline at end of file
+    curl_multi_cleanup(multi);
+
+    /* the .part files of servers which couldn't resume, or whose file changed, are gone now, so those go again
+     * from the start. Without a .part they can't fail this way twice */
+    size_t retries = 0;
+    for (i = 0; i < count; i++) {
+        if (transfers[i].resumeFrom > 0 && items[i].result == (Result)-CURLE_RANGE_ERROR)
+            retries++;
+    }
+
+    if (retries > 0) {
+        struct download_item *retry = malloc(retries * sizeof(struct download_item));
+        size_t *from = malloc(retries * sizeof(size_t));
+        if (retry && from) {
+            size_t n = 0;
+            for (i = 0; i < count; i++) {
+                if (transfers[i].resumeFrom > 0 && items[i].result == (Result)-CURLE_RANGE_ERROR) {
+                    retry[n] = items[i];
+                    from[n++] = i;
+                }
+            }
+            download_all(retry, retries);
+            for (i = 0; i < retries; i++)
+                items[from[i]].result = retry[i].result;
+
+            res = 0;
+            for (i = 0; i < count && res == 0; i++) {
+                if (R_FAILED(items[i].result))
+                    res = items[i].result;
+            }
+        }
+        free(retry);
+        free(from);
+    }
+
+    free(transfers);
+    return res;
+}
+
+Result download(const char* url, const char* path)
+{
+    struct download_item item = { url, path, NULL, 0 };
+    return download_all(&item, 1);
+}
@@ -0,0 +1,108 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "grayscale.h"
+#include <string.h>
+
+// The ARM11's media instructions work on both halves of a register at once, so two pixels go through
+// each step. Only little-endian, where the first pixel of a pair is in the low half
+#if defined(__ARM_FEATURE_SIMD32) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define GRAYSCALE_SIMD32
+#include <arm_acle.h>
+#endif
+
+// BT.601 luma with the channels expanded to 8 bits folded into the weights:
+// (77 * (r << 3) + 150 * (g << 2) + 29 * (b << 3)) >> 8, which never exceeds 250
+static inline uint32_t luma(uint32_t px)
+{
+    return (((px >> 11) & 0x1F) * 616 + ((px >> 5) & 0x3F) * 600 + (px & 0x1F) * 232) >> 8;
+}
+
+#ifdef GRAYSCALE_SIMD32
+// luma() of both pixels in a pair, in the low byte of each half. Each half's sum is at most 64088, so
+// the multiplies never carry from one pixel into the other
+static inline uint32_t luma2(uint32_t pair)
+{
+    uint32_t sums = ((pair >> 11) & 0x001F001F) * 616 + ((pair >> 5) & 0x003F003F) * 600 + (pair & 0x001F001F) * 232;
+    return __uxtb16(__ror(sums, 8));
+}
+#endif
+
+void rgb565_to_gray(const uint16_t* src, int width, int height, int srcStride, uint8_t* dst, int downscale)
+{
+    if (!downscale)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            const uint16_t* row = src + y * srcStride;
+            uint8_t* out = dst + y * width;
+            int x = 0;
+            // two pixels per load
+            for (; x + 1 < width; x += 2)
+            {
+                uint32_t pair;
+                memcpy(&pair, row + x, sizeof(pair));
+#if defined(GRAYSCALE_SIMD32)
+                uint32_t lumas = luma2(pair);
+                out[x]     = lumas;
+                out[x + 1] = lumas >> 16;
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                out[x]     = luma(pair >> 16);
+                out[x + 1] = luma(pair & 0xFFFF);
+#else
+                out[x]     = luma(pair & 0xFFFF);
+                out[x + 1] = luma(pair >> 16);
+#endif
+            }
+            for (; x < width; x++)
+            {
+                out[x] = luma(row[x]);
+            }
+        }
+    }
+    else
+    {
+        int outWidth = width / 2;
+        for (int y = 0; y + 1 < height; y += 2)
+        {
+            const uint16_t* top    = src + y * srcStride;
+            const uint16_t* bottom = top + srcStride;
+            uint8_t* out           = dst + (y / 2) * outWidth;
+            for (int x = 0; x < outWidth; x++)
+            {
+#ifdef GRAYSCALE_SIMD32
+                uint32_t topPair, bottomPair;
+                memcpy(&topPair, top + 2 * x, sizeof(topPair));
+                memcpy(&bottomPair, bottom + 2 * x, sizeof(bottomPair));
+                // both columns' sums, at most 500 each, then both added together with the rounding
+                out[x] = __smlad(luma2(topPair) + luma2(bottomPair), 0x00010001, 2) >> 2;
+#else
+                out[x] = (luma(top[2 * x]) + luma(top[2 * x + 1]) + luma(bottom[2 * x]) + luma(bottom[2 * x + 1]) + 2) >> 2;
+#endif
+            }
+        }
+    }
+}
@@ -1,8 +1,55 @@
 #include "TitleLoadScreen.hpp"
+#include "BackupStore.hpp"
+
+#include <zlib.h>
+
+/*
+ * Bridge protocol. A client which starts with BRIDGE_MAGIC sends framed data; anything else is taken as a
+ * raw save, read until the client closes the connection. Saves go back to the client in the same form they
+ * came in. All numbers are u32, little endian.
+ *
+ *   sender:   BRIDGE_MAGIC, version, save size, CRC-32 of the whole save, CRC-32 of the save last exchanged
+ *             with the receiver (the base), or 0 if there wasn't one
+ *   receiver: offset to resume from, 0 unless an earlier transfer of this same save was cut short, and
+ *             whether it still has the base
+ *   sender:   frames in ascending order: offset, length, CRC-32 of the frame, number of bytes which follow.
+ *             Fewer bytes than the length means they're zlib compressed. With the base, only the blocks
+ *             which changed from it are sent; without it, the frames must cover the whole save. A frame
+ *             with a length of 0 ends the transfer
+ *   receiver: bytes received, which is the save size when everything arrived intact
+ *
+ * Version 1 had no base or compression and was never used by a released client, so it isn't accepted.
+ */
+static constexpr char BRIDGE_MAGIC[8]      = {'P', 'K', 'S', 'M', 'B', 'R', 'D', 'G'};
+static constexpr u32 BRIDGE_VERSION        = 2;
+static constexpr size_t BRIDGE_BLOCK_SIZE  = 0x1000;
+static constexpr size_t BRIDGE_FRAME_SIZE  = 0x10000;
+static constexpr size_t BRIDGE_MAX_SIZE    = 0x1000000;
+static constexpr size_t BRIDGE_LEGACY_SIZE = 0x100000;
 
 static bool saveFromBridge = false;
+static bool framedBridge   = false;
 static struct in_addr lastIPAddr;
 
+// a framed transfer which was cut short, kept so the client can pick up where it left off. baseCrc is the
+// base it was filled in from, or 0 if it was sent whole
+static struct
+{
+    u8* data;
+    u32 size;
+    u32 crc;
+    u32 baseCrc;
+    u32 received;
+} pending = {nullptr, 0, 0, 0, 0};
+
+// the save last exchanged with the client, which both sides send changes against
+static struct
+{
+    u8* data;
+    u32 size;
+    u32 crc;
+} base = {nullptr, 0, 0};
+
 bool isLoadedSaveFromBridge(void) { return saveFromBridge; }
 void setLoadedSaveFromBridge(bool v) { saveFromBridge = false; }
 
@@ -13,6 +60,220 @@ static char* getHostId()
     return inet_ntoa(addr.sin_addr);
 }
 
+static bool sendAll(int fd, const void* buffer, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        int n = send(fd, (const u8*)buffer + total, size - total, 0);
+        if (n <= 0)
+        {
+            return false;
+        }
+        total += n;
+    }
+    return true;
+}
+
+// returns how many bytes were received before the connection closed or failed
+static size_t recvAll(int fd, void* buffer, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        int n = recv(fd, (u8*)buffer + total, size - total, 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        total += n;
+    }
+    return total;
+}
+
+static void dropPending(void)
+{
+    delete[] pending.data;
+    pending = {nullptr, 0, 0, 0, 0};
+}
+
+static void setBase(const u8* data, u32 size, u32 crc)
+{
+    if (base.size != size)
+    {
+        delete[] base.data;
+        base.data = new u8[size];
+    }
+    std::copy(data, data + size, base.data);
+    base.size = size;
+    base.crc  = crc;
+}
+
+// receives framed data straight into a buffer sized from the header. Returns the save, or nullptr on failure
+static u8* recvFramed(int fd, u32& size)
+{
+    u32 header[4];
+    if (recvAll(fd, header, sizeof(header)) != sizeof(header) || header[0] != BRIDGE_VERSION || header[1] == 0 ||
+        header[1] > BRIDGE_MAX_SIZE)
+    {
+        return nullptr;
+    }
+
+    // a cut short transfer can only be picked up by one working from the same base, or without one as it was.
+    // Otherwise the blocks it skipped hold the wrong data
+    u32 hasBase = header[3] != 0 && base.data != nullptr && base.size == header[1] && base.crc == header[3];
+    if (pending.data == nullptr || pending.size != header[1] || pending.crc != header[2] ||
+        pending.baseCrc != (hasBase ? header[3] : 0))
+    {
+        dropPending();
+        pending.data    = new u8[header[1]];
+        pending.size    = header[1];
+        pending.crc     = header[2];
+        pending.baseCrc = hasBase ? header[3] : 0;
+        if (hasBase)
+        {
+            std::copy(base.data, base.data + base.size, pending.data);
+        }
+    }
+    u32 reply[2] = {pending.received, hasBase};
+    if (!sendAll(fd, reply, sizeof(reply)))
+    {
+        return nullptr;
+    }
+
+    u8* compressed = new u8[BRIDGE_FRAME_SIZE];
+    bool done      = false;
+    while (!done)
+    {
+        u32 frame[4];
+        if (recvAll(fd, frame, sizeof(frame)) != sizeof(frame))
+        {
+            break;
+        }
+        if (frame[1] == 0)
+        {
+            done = hasBase || pending.received == pending.size;
+            break;
+        }
+        if (frame[0] < pending.received || (!hasBase && frame[0] != pending.received) || frame[0] > pending.size ||
+            frame[1] > pending.size - frame[0] || frame[1] > BRIDGE_FRAME_SIZE || frame[3] == 0 || frame[3] > frame[1])
+        {
+            break;
+        }
+
+        u8* dest = pending.data + frame[0];
+        if (frame[3] == frame[1])
+        {
+            if (recvAll(fd, dest, frame[1]) != frame[1])
+            {
+                break;
+            }
+        }
+        else
+        {
+            uLongf length = frame[1];
+            if (recvAll(fd, compressed, frame[3]) != frame[3] || uncompress(dest, &length, compressed, frame[3]) != Z_OK ||
+                length != frame[1])
+            {
+                break;
+            }
+        }
+        if (crc32(0, dest, frame[1]) != frame[2])
+        {
+            break;
+        }
+        pending.received = frame[0] + frame[1];
+    }
+    delete[] compressed;
+
+    // a save that arrived whole but doesn't match its checksum has to be sent again from the start
+    if (done)
+    {
+        pending.received = pending.size;
+        if (crc32(0, pending.data, pending.size) != pending.crc)
+        {
+            dropPending();
+            done = false;
+        }
+    }
+    u32 received = done ? pending.size : pending.received;
+    sendAll(fd, &received, sizeof(received));
+
+    if (!done)
+    {
+        return nullptr;
+    }
+
+    setBase(pending.data, pending.size, pending.crc);
+    u8* data = pending.data;
+    size     = pending.size;
+    pending  = {nullptr, 0, 0, 0, 0};
+    return data;
+}
+
+static bool sendFrame(int fd, const u8* data, u32 offset, u32 length, u8* compressed)
+{
+    uLongf stored = compressBound(length);
+    if (compress2(compressed, &stored, data + offset, length, 1) != Z_OK || stored >= length)
+    {
+        stored = length;
+    }
+
+    u32 frame[4] = {offset, length, (u32)crc32(0, data + offset, length), (u32)stored};
+    return sendAll(fd, frame, sizeof(frame)) && sendAll(fd, stored == length ? data + offset : compressed, stored);
+}
+
+static bool sendFramed(int fd, const u8* data, u32 size)
+{
+    u32 crc       = crc32(0, data, size);
+    u32 header[4] = {BRIDGE_VERSION, size, crc, base.data != nullptr && base.size == size ? base.crc : 0};
+    u32 reply[2];
+    if (!sendAll(fd, BRIDGE_MAGIC, sizeof(BRIDGE_MAGIC)) || !sendAll(fd, header, sizeof(header)) ||
+        recvAll(fd, reply, sizeof(reply)) != sizeof(reply) || reply[0] > size || (reply[1] && header[3] == 0))
+    {
+        return false;
+    }
+
+    // runs of changed blocks go out as one frame each, up to the frame size
+    u8* compressed = new u8[compressBound(BRIDGE_FRAME_SIZE)];
+    bool ok        = true;
+    u32 offset     = reply[0];
+    while (ok && offset < size)
+    {
+        u32 length = std::min((u32)BRIDGE_BLOCK_SIZE, size - offset);
+        if (reply[1] && memcmp(data + offset, base.data + offset, length) == 0)
+        {
+            offset += length;
+            continue;
+        }
+
+        u32 end = offset + length;
+        while (end < size && end - offset < BRIDGE_FRAME_SIZE)
+        {
+            u32 next = std::min((u32)BRIDGE_BLOCK_SIZE, size - end);
+            if (reply[1] && memcmp(data + end, base.data + end, next) == 0)
+            {
+                break;
+            }
+            end += next;
+        }
+
+        ok     = sendFrame(fd, data, offset, end - offset, compressed);
+        offset = end;
+    }
+    delete[] compressed;
+
+    u32 end[4] = {0, 0, 0, 0};
+    u32 received;
+    if (!ok || !sendAll(fd, end, sizeof(end)) || recvAll(fd, &received, sizeof(received)) != sizeof(received) || received != size)
+    {
+        return false;
+    }
+
+    setBase(data, size, crc);
+    return true;
+}
+
 bool receiveSaveFromBridge(void)
 {
     if (!Gui::showChoiceMessage(i18n::localize("WIRELESS_WARNING"), StringUtils::format(i18n::localize("WIRELESS_IP"), getHostId())))
@@ -58,26 +319,30 @@ bool receiveSaveFromBridge(void)
 
     lastIPAddr = servaddr.sin_addr;
 
-    size_t size = 0x100000;
-    char* data = new char[size];
-
-    size_t total = 0;
-    size_t chunk = 1024;
-    int n;
-    while (total < size) {
-        size_t torecv = size - total > chunk ? chunk : size - total;
-        n = recv(fdconn, data + total, torecv, 0);
-        total += n;
-        if (n <= 0) { break; }
-        fprintf(stderr, "Recv %u bytes, %u still missing\n", total, size - total);
+    u8* data = nullptr;
+    u32 size = 0;
+    char magic[sizeof(BRIDGE_MAGIC)];
+    size_t total = recvAll(fdconn, magic, sizeof(magic));
+    framedBridge = total == sizeof(magic) && memcmp(magic, BRIDGE_MAGIC, sizeof(magic)) == 0;
+    if (framedBridge)
+    {
+        data = recvFramed(fdconn, size);
+    }
+    else
+    {
+        // older clients send the raw save and close the connection when they're done
+        data = new u8[BRIDGE_LEGACY_SIZE];
+        std::copy(magic, magic + total, data);
+        total += recvAll(fdconn, data + total, BRIDGE_LEGACY_SIZE - total);
+        size = total;
     }
 
     close(fdconn);
     close(fd);
 
-    if (n == 0 || total == size)
+    if (data != nullptr && size > 0)
     {
-        if (TitleLoader::load((u8*)data, total))
+        if (TitleLoader::load(data, size))
         {
             saveFromBridge = true;
             Gui::setScreen(std::make_unique<MainMenu>());
@@ -115,23 +380,15 @@ bool sendSaveToBridge(void)
         return result;
     }
 
-    size_t size = TitleLoader::save->length;
-    size_t total = 0;
-    size_t chunk = 1024;
-    int n;
-    while (total < size) {
-        size_t tosend = size - total > chunk ? chunk : size - total;
-        n = send(fd, TitleLoader::save->data + total, tosend, 0);
-        if (n == -1) { break; }
-        total += n;
-        fprintf(stderr, "Sent %u bytes, %u still missing\n", total, size - total);
-    }
-    if (total == size)
+    if (framedBridge)
     {
-        //Gui::createInfo("Success!", "Data sent back correctly.");
-        result = true;
+        result = sendFramed(fd, TitleLoader::save->data, TitleLoader::save->length);
     }
     else
+    {
+        result = sendAll(fd, TitleLoader::save->data, TitleLoader::save->length);
+    }
+    if (!result)
     {
         Gui::error("Failed to send data.", errno);
     }
@@ -143,15 +400,5 @@ bool sendSaveToBridge(void)
 
 void backupBridgeChanges()
 {
-    char stringTime[15] = {0};
-    time_t unixTime = time(NULL);
-    struct tm* timeStruct = gmtime((const time_t *)&unixTime);
-    std::strftime(stringTime, 14,"%Y%m%d%H%M%S", timeStruct);
-    std::string path = "/3ds/PKSM/backups/bridge/" + std::string(stringTime) + ".bak";
-    FSStream out = FSStream(Archive::sd(), StringUtils::UTF8toUTF16(path), FS_OPEN_WRITE | FS_OPEN_CREATE, TitleLoader::save->length);
-    if (out.good())
-    {
-        out.write(TitleLoader::save->data, TitleLoader::save->length);
-    }
-    out.close();
+    BackupStore::backup(BackupStore::BRIDGE, "bridge.bak", TitleLoader::save->data, TitleLoader::save->length);
 }
\ No newline at end of file
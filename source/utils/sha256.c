@@ -21,8 +21,8 @@
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32-(b))))
 
-#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define CH(x,y,z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
 #define EP0(x) (ROTRIGHT(x,2) ^ ROTRIGHT(x,13) ^ ROTRIGHT(x,22))
 #define EP1(x) (ROTRIGHT(x,6) ^ ROTRIGHT(x,11) ^ ROTRIGHT(x,25))
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
@@ -41,45 +41,66 @@ static const WORD k[64] = {
 };
 
 /*********************** FUNCTION DEFINITIONS ***********************/
-void sha256_transform(SHA256_CTX *ctx, const BYTE data[])
+// One round, with the working variables renamed instead of shifted along
+#define ROUND(a,b,c,d,e,f,g,h,i) \
+	t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[(i) & 15]; \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c)
+
+// Expands the message schedule in place, keeping only the last 16 words
+#define SCHEDULE(i) \
+	m[(i) & 15] += SIG1(m[((i) - 2) & 15]) + m[((i) - 7) & 15] + SIG0(m[((i) - 15) & 15])
+
+#define ROUNDS8(i) \
+	ROUND(a,b,c,d,e,f,g,h,(i)); \
+	ROUND(h,a,b,c,d,e,f,g,(i) + 1); \
+	ROUND(g,h,a,b,c,d,e,f,(i) + 2); \
+	ROUND(f,g,h,a,b,c,d,e,(i) + 3); \
+	ROUND(e,f,g,h,a,b,c,d,(i) + 4); \
+	ROUND(d,e,f,g,h,a,b,c,(i) + 5); \
+	ROUND(c,d,e,f,g,h,a,b,(i) + 6); \
+	ROUND(b,c,d,e,f,g,h,a,(i) + 7)
+
+static void sha256_transform(WORD state[], const BYTE data[], size_t blocks)
 {
-	WORD a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
-
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-	for ( ; i < 64; ++i)
-		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
-
-	a = ctx->state[0];
-	b = ctx->state[1];
-	c = ctx->state[2];
-	d = ctx->state[3];
-	e = ctx->state[4];
-	f = ctx->state[5];
-	g = ctx->state[6];
-	h = ctx->state[7];
-
-	for (i = 0; i < 64; ++i) {
-		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-		t2 = EP0(a) + MAJ(a,b,c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + t2;
-	}
+	WORD a, b, c, d, e, f, g, h, i, j, t1, m[16];
+
+	for (; blocks > 0; --blocks, data += 64) {
+		for (i = 0, j = 0; i < 16; ++i, j += 4)
+			m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		ROUNDS8(0);
+		ROUNDS8(8);
+		for (i = 16; i < 64; i += 8) {
+			SCHEDULE(i);
+			SCHEDULE(i + 1);
+			SCHEDULE(i + 2);
+			SCHEDULE(i + 3);
+			SCHEDULE(i + 4);
+			SCHEDULE(i + 5);
+			SCHEDULE(i + 6);
+			SCHEDULE(i + 7);
+			ROUNDS8(i);
+		}
 
-	ctx->state[0] += a;
-	ctx->state[1] += b;
-	ctx->state[2] += c;
-	ctx->state[3] += d;
-	ctx->state[4] += e;
-	ctx->state[5] += f;
-	ctx->state[6] += g;
-	ctx->state[7] += h;
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
 }
 
 void sha256_init(SHA256_CTX *ctx)
@@ -98,17 +119,35 @@ void sha256_init(SHA256_CTX *ctx)
 
 void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
+	size_t blocks, fill;
+
+	// Top up a partly filled block first
+	if (ctx->datalen > 0) {
+		fill = 64 - ctx->datalen;
+		if (fill > len)
+			fill = len;
+		memcpy(&ctx->data[ctx->datalen], data, fill);
+		ctx->datalen += fill;
+		data += fill;
+		len -= fill;
+		if (ctx->datalen < 64)
+			return;
+		sha256_transform(ctx->state, ctx->data, 1);
+		ctx->bitlen += 512;
+		ctx->datalen = 0;
+	}
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64) {
-			sha256_transform(ctx, ctx->data);
-			ctx->bitlen += 512;
-			ctx->datalen = 0;
-		}
+	// Whole blocks are hashed straight from the input
+	blocks = len / 64;
+	if (blocks > 0) {
+		sha256_transform(ctx->state, data, blocks);
+		ctx->bitlen += (unsigned long long)blocks * 512;
+		data += blocks * 64;
+		len -= blocks * 64;
 	}
+
+	memcpy(ctx->data, data, len);
+	ctx->datalen = len;
 }
 
 void sha256_final(SHA256_CTX *ctx, BYTE hash[])
@@ -127,7 +166,7 @@ void sha256_final(SHA256_CTX *ctx, BYTE hash[])
 		ctx->data[i++] = 0x80;
 		while (i < 64)
 			ctx->data[i++] = 0x00;
-		sha256_transform(ctx, ctx->data);
+		sha256_transform(ctx->state, ctx->data, 1);
 		memset(ctx->data, 0, 56);
 	}
 
@@ -141,7 +180,7 @@ void sha256_final(SHA256_CTX *ctx, BYTE hash[])
 	ctx->data[58] = ctx->bitlen >> 40;
 	ctx->data[57] = ctx->bitlen >> 48;
 	ctx->data[56] = ctx->bitlen >> 56;
-	sha256_transform(ctx, ctx->data);
+	sha256_transform(ctx->state, ctx->data, 1);
 
 	// Since this implementation uses little endian byte ordering and SHA uses big endian,
 	// reverse all the bytes when copying the final state to the output hash.
@@ -162,4 +201,14 @@ void sha256(unsigned char hash[], unsigned char data[], size_t len) {
 	sha256_init(&ctx);
 	sha256_update(&ctx, data, len);
 	sha256_final(&ctx,hash);
+}
+
+void sha256_multi(unsigned char hashes[][SHA256_BLOCK_SIZE], const unsigned char *const data[], const size_t lens[], size_t count) {
+	SHA256_CTX ctx;
+	size_t i;
+	for (i = 0; i < count; ++i) {
+		sha256_init(&ctx);
+		sha256_update(&ctx, data[i], lens[i]);
+		sha256_final(&ctx, hashes[i]);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "textLayout.hpp"
+#include <math.h>
+
+uint16_t TextLayout::nextCodepoint(const std::string& text, size_t& i)
+{
+    uint16_t codepoint = 0xFFFF;
+    if (text[i] & 0x80 && text[i] & 0x40 && text[i] & 0x20 && !(text[i] & 0x10) && i + 2 < text.size())
+    {
+        codepoint = text[i] & 0x0F;
+        codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
+        codepoint = codepoint << 6 | (text[i + 2] & 0x3F);
+        i += 2;
+    }
+    else if (text[i] & 0x80 && text[i] & 0x40 && !(text[i] & 0x20) && i + 1 < text.size())
+    {
+        codepoint = text[i] & 0x1F;
+        codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
+        i += 1;
+    }
+    else if (!(text[i] & 0x80))
+    {
+        codepoint = text[i];
+    }
+    return codepoint;
+}
+
+static float lineOffset(float width, TextPosX positionX)
+{
+    switch (positionX)
+    {
+        case TextPosX::LEFT:
+            break;
+        case TextPosX::CENTER:
+            return -(ceilf(width) / 2);
+        case TextPosX::RIGHT:
+            return -ceilf(width);
+    }
+    return 0.0f;
+}
+
+void TextLayout::layout(std::vector<Line>& lines, const std::string& text, float scaleX, TextPosX positionX, GlyphWidth glyphWidth)
+{
+    lines.clear();
+    size_t start = 0;
+    float width = 0.0f;
+    for (size_t i = 0; i <= text.size(); i++)
+    {
+        if (i == text.size() || text[i] == '\n')
+        {
+            lines.push_back({start, i - start, width, lineOffset(width, positionX)});
+            start = i + 1;
+            width = 0.0f;
+        }
+        else
+        {
+            width += glyphWidth(nextCodepoint(text, i)) * scaleX;
+        }
+    }
+}
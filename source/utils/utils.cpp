@@ -25,6 +25,7 @@
 */
 
 #include "utils.hpp"
+#include "textLayout.hpp"
 #include <algorithm>
 #include <vector>
 #include <map>
@@ -272,6 +273,25 @@ std::string& StringUtils::toLower(std::string& in)
 static std::map<u16, charWidthInfo_s*> widthCache;
 static std::queue<u16> widthCacheOrder;
 
+// the unscaled advance of a glyph, remembering the last 512 looked up
+static float charWidth(u16 codepoint)
+{
+    auto width = widthCache.find(codepoint);
+    if (width != widthCache.end())
+    {
+        return width->second->charWidth;
+    }
+    charWidthInfo_s* info = fontGetCharWidthInfo(fontGlyphIndexFromCodePoint(codepoint));
+    widthCache.insert_or_assign(codepoint, info);
+    widthCacheOrder.push(codepoint);
+    if (widthCache.size() > 512)
+    {
+        widthCache.erase(widthCacheOrder.front());
+        widthCacheOrder.pop();
+    }
+    return info->charWidth;
+}
+
 std::string StringUtils::splitWord(const std::string& text, float scaleX, float maxWidth)
 {
     std::string word = text;
@@ -280,50 +300,21 @@ std::string StringUtils::splitWord(const std::string& text, float scaleX, float
     {
         for (size_t i = 0; i < word.size(); i++)
         {
-            u16 codepoint = 0xFFFF;
-            int iMod = 0;
-            if (word[i] & 0x80 && word[i] & 0x40 && word[i] & 0x20 && !(word[i] & 0x10) && i + 2 < word.size())
-            {
-                codepoint = word[i] & 0x0F;
-                codepoint = codepoint << 6 | (word[i + 1] & 0x3F);
-                codepoint = codepoint << 6 | (word[i + 2] & 0x3F);
-                iMod = 2;
-            }
-            else if (word[i] & 0x80 && word[i] & 0x40 && !(word[i] & 0x20) && i + 1 < word.size())
-            {
-                codepoint = word[i] & 0x1F;
-                codepoint = codepoint << 6 | (word[i + 1] & 0x3F);
-                iMod = 1;
-            }
-            else if (!(word[i] & 0x80))
-            {
-                codepoint = word[i];
-            }
-            float charWidth;
-            auto width = widthCache.find(codepoint);
-            if (width != widthCache.end())
-            {
-                charWidth = width->second->charWidth * scaleX;
-            }
-            else
+            if (word[i] == '\n')
             {
-                widthCache.insert_or_assign(codepoint, fontGetCharWidthInfo(fontGlyphIndexFromCodePoint(codepoint)));
-                widthCacheOrder.push(codepoint);
-                if (widthCache.size() > 512)
-                {
-                    widthCache.erase(widthCacheOrder.front());
-                    widthCacheOrder.pop();
-                }
-                charWidth = widthCache[codepoint]->charWidth * scaleX;
+                currentWidth = 0.0f;
+                continue;
             }
-            currentWidth += charWidth;
+            size_t start = i;
+            float width = charWidth(TextLayout::nextCodepoint(word, i)) * scaleX;
+            currentWidth += width;
             if (currentWidth > maxWidth)
             {
-                word.insert(i, 1, '\n');
-                currentWidth = charWidth;
+                word.insert(start, 1, '\n');
+                // i is on the character's last byte, which has just moved one along
+                i++;
+                currentWidth = width;
             }
-
-            i += iMod; // Yay, variable width encodings
         }
     }
     return word;
@@ -341,42 +332,7 @@ float StringUtils::textWidth(const std::string& text, float scaleX)
             ret = 0.0f;
             continue;
         }
-        u16 codepoint = 0xFFFF;
-        if (text[i] & 0x80 && text[i] & 0x40 && text[i] & 0x20 && !(text[i] & 0x10) && i + 2 < text.size())
-        {
-            codepoint = text[i] & 0x0F;
-            codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
-            codepoint = codepoint << 6 | (text[i + 2] & 0x3F);
-            i += 2;
-        }
-        else if (text[i] & 0x80 && text[i] & 0x40 && !(text[i] & 0x20) && i + 1 < text.size())
-        {
-            codepoint = text[i] & 0x1F;
-            codepoint = codepoint << 6 | (text[i + 1] & 0x3F);
-            i += 1;
-        }
-        else if (!(text[i] & 0x80))
-        {
-            codepoint = text[i];
-        }
-        float charWidth;
-        auto width = widthCache.find(codepoint);
-        if (width != widthCache.end())
-        {
-            charWidth = width->second->charWidth * scaleX;
-        }
-        else
-        {
-            widthCache.insert_or_assign(codepoint, fontGetCharWidthInfo(fontGlyphIndexFromCodePoint(codepoint)));
-            widthCacheOrder.push(codepoint);
-            if (widthCache.size() > 1000)
-            {
-                widthCache.erase(widthCacheOrder.front());
-                widthCacheOrder.pop();
-            }
-            charWidth = widthCache[codepoint]->charWidth * scaleX;
-        }
-        ret += charWidth;
+        ret += charWidth(TextLayout::nextCodepoint(text, i)) * scaleX;
     }
     return std::max(largestRet, ret);
 }
@@ -393,24 +349,7 @@ float StringUtils::textWidth(const std::u16string& text, float scaleX)
             ret = 0.0f;
             continue;
         }
-        float charWidth;
-        auto width = widthCache.find(text[i]);
-        if (width != widthCache.end())
-        {
-            charWidth = width->second->charWidth * scaleX;
-        }
-        else
-        {
-            widthCache.insert_or_assign(text[i], fontGetCharWidthInfo(fontGlyphIndexFromCodePoint(text[i])));
-            widthCacheOrder.push(text[i]);
-            if (widthCache.size() > 512)
-            {
-                widthCache.erase(widthCacheOrder.front());
-                widthCacheOrder.pop();
-            }
-            charWidth = widthCache[text[i]]->charWidth * scaleX;
-        }
-        ret += charWidth;
+        ret += charWidth(text[i]) * scaleX;
     }
     return std::max(largestRet, ret);
 }
@@ -537,7 +476,7 @@ std::string StringUtils::wrap(const std::string& text, float scaleX, float maxWi
         split.pop_back();
     }
 
-    const float ellipsis = fontGetCharWidthInfo(fontGlyphIndexFromCodePoint('.'))->charWidth * 3 * scaleX;
+    const float ellipsis = charWidth('.') * 3 * scaleX;
 
     // If there's space for the ellipsis, add it
     if (textWidth(split[lines - 1], scaleX) + ellipsis <= maxWidth)
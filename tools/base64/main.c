@@ -0,0 +1,210 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/* Checks base64_decoded_length and base64_decode_to from source/utils/base64.c against a plain encoder,
+ * including bad padding, invalid characters and short output buffers, then times them against the decoder
+ * they replaced at the sizes QRScanner decodes. Exits non-zero if anything doesn't hold. */
+
+#include "base64.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_DATA 1024
+#define TIMED_BYTES (64 * 1024 * 1024)
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static size_t encode(const unsigned char *data, size_t size, char *out)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t triple = data[i] << 16 | (i + 1 < size ? data[i + 1] << 8 : 0) | (i + 2 < size ? data[i + 2] : 0);
+        out[j++] = alphabet[triple >> 18 & 0x3F];
+        out[j++] = alphabet[triple >> 12 & 0x3F];
+        out[j++] = i + 1 < size ? alphabet[triple >> 6 & 0x3F] : '=';
+        out[j++] = i + 2 < size ? alphabet[triple & 0x3F] : '=';
+    }
+    out[j] = '\0';
+    return j;
+}
+
+// the decoder base64_decode had before base64_decode_to, as it was apart from being renamed
+#pragma GCC diagnostic ignored "-Wsign-compare"
+static char encoding_table[] = {
+	'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
+	'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+	'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
+	'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+	'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
+	'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+	'w', 'x', 'y', 'z', '0', '1', '2', '3',
+	'4', '5', '6', '7', '8', '9', '+', '/'
+};
+static char *decoding_table = NULL;
+
+static unsigned char *old_base64_decode(const char *data, size_t input_length, size_t *output_length)
+{
+    decoding_table = malloc(256);
+    for (int i = 0; i < 64; i++)
+        decoding_table[(unsigned char) encoding_table[i]] = i;
+
+    if (input_length % 4 != 0) return NULL;
+
+    *output_length = input_length / 4 * 3;
+    if (data[input_length - 1] == '=') (*output_length)--;
+    if (data[input_length - 2] == '=') (*output_length)--;
+
+    unsigned char *decoded_data = malloc(*output_length);
+    if (decoded_data == NULL) return NULL;
+
+    for (size_t i = 0, j = 0; i < input_length;) {
+
+        uint32_t sextet_a = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
+        uint32_t sextet_b = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
+        uint32_t sextet_c = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
+        uint32_t sextet_d = data[i] == '=' ? 0 & i++ : decoding_table[(size_t)data[i++]];
+
+        uint32_t triple = (sextet_a << 3 * 6)
+        + (sextet_b << 2 * 6)
+        + (sextet_c << 1 * 6)
+        + (sextet_d << 0 * 6);
+
+        if (j < *output_length) decoded_data[j++] = (triple >> 2 * 8) & 0xFF;
+        if (j < *output_length) decoded_data[j++] = (triple >> 1 * 8) & 0xFF;
+        if (j < *output_length) decoded_data[j++] = (triple >> 0 * 8) & 0xFF;
+    }
+
+	free(decoding_table);
+    return decoded_data;
+}
+
+static bool rejects(const char *text)
+{
+    unsigned char out[16];
+    size_t unused;
+    if (base64_decode_to(text, strlen(text), out, sizeof(out)) != 0)
+        return false;
+    unsigned char *decoded = base64_decode(text, strlen(text), &unused);
+    if (decoded == NULL)
+        return true;
+    free(decoded);
+    return false;
+}
+
+static bool decodesTo(const char *text, const char *expected)
+{
+    unsigned char out[16];
+    size_t length = base64_decode_to(text, strlen(text), out, sizeof(out));
+    return base64_decoded_length(text, strlen(text)) == strlen(expected) && length == strlen(expected) &&
+           memcmp(out, expected, length) == 0;
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(void)
+{
+    static unsigned char data[MAX_DATA], out[MAX_DATA + 4];
+    static char text[MAX_DATA * 4 / 3 + 8];
+    srand(1);
+
+    bool roundTrips = true, exactFit = true, tooSmall = true, untouchedTail = true;
+    for (size_t size = 1; size <= MAX_DATA; size++) {
+        for (size_t i = 0; i < size; i++)
+            data[i] = rand();
+        size_t length = encode(data, size, text);
+        memset(out, 0xEE, sizeof(out));
+        roundTrips = roundTrips && base64_decoded_length(text, length) == size &&
+                     base64_decode_to(text, length, out, sizeof(out)) == size && memcmp(out, data, size) == 0;
+        untouchedTail = untouchedTail && out[size] == 0xEE;
+        exactFit = exactFit && base64_decode_to(text, length, out, size) == size;
+        tooSmall = tooSmall && base64_decode_to(text, length, out, size - 1) == 0;
+    }
+    check(roundTrips, "everything from 1 to 1024 bytes decodes back to what was encoded");
+    check(untouchedTail, "nothing past the decoded length is written");
+    check(exactFit && tooSmall, "an output buffer of exactly the decoded length is enough, one byte less isn't");
+
+    check(decodesTo("TWFu", "Man") && decodesTo("TWE=", "Ma") && decodesTo("TQ==", "M"), "no, one and two padding characters");
+    check(rejects("") && rejects("TWF") && rejects("TWFuT") && rejects("TWFu\n"), "lengths which aren't a multiple of 4");
+    check(rejects("====") && rejects("T===") && rejects("TW=u") && rejects("TQ==TWFu") && rejects("=WFu"),
+        "padding anywhere but the end");
+
+    bool everyPosition = true, everyCharacter = true;
+    const char bad[] = {' ', '\n', '-', '_', '.', '\0', (char)0x80, (char)0xFF, (char)0xC3};
+    for (size_t i = 0; i < 12; i++) {
+        char quads[] = "TWFuTWFuTWE=";
+        quads[i == 11 ? 10 : i] = '*';
+        everyPosition = everyPosition && base64_decode_to(quads, 12, out, sizeof(out)) == 0;
+    }
+    for (size_t i = 0; i < sizeof(bad); i++) {
+        char quad[] = "TWFu";
+        quad[2] = bad[i];
+        everyCharacter = everyCharacter && base64_decode_to(quad, 4, out, sizeof(out)) == 0;
+    }
+    check(everyPosition, "an invalid character anywhere, padded quad included, is caught");
+    check(everyCharacter, "whitespace, URL-safe base64, NUL and bytes above 0x7F are invalid");
+
+    // the sizes QRScanner's formats decode: PK4/5, PGF, PK6, PGT, WC6, WC6 full and WC4
+    const size_t sizes[] = {136, 204, 232, 260, 264, 784, 856};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s], length = encode(data, sizes[s], text), runs = TIMED_BYTES / length;
+        unsigned sum = 0;
+        double start = seconds();
+        for (size_t n = 0; n < runs; n++) {
+            size_t decoded;
+            unsigned char *old = old_base64_decode(text, length, &decoded);
+            sum += old[n % size];
+            free(old);
+        }
+        double oldTime = seconds() - start;
+        start = seconds();
+        for (size_t n = 0; n < runs; n++) {
+            sum += base64_decode_to(text, length, out, size);
+            sum += out[n % size];
+        }
+        double newTime = seconds() - start;
+        printf("     %4zu bytes: old %7.1f ns, base64_decode_to %6.1f ns, %.1fx (%u)\n", size, oldTime / runs * 1e9,
+            newTime / runs * 1e9, oldTime / newTime, sum & 1);
+    }
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,152 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Runs source/utils/pksmbridge.cpp against the stand-in peer over loopback: whole transfers, unchanged and
+// edited saves going both ways, and transfers which are cut short and picked up again, with and without the
+// base. Exits non-zero if anything doesn't hold.
+
+#include "TitleLoadScreen.hpp"
+#include "peer.hpp"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+static constexpr size_t SAVE_SIZE = 0x100000;
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+static void report(void)
+{
+    const Peer::Stats& stats = Peer::stats();
+    printf("     %u frames, %u bytes, %s base, resumed from 0x%X\n", (unsigned)stats.frames, (unsigned)stats.bytes,
+        stats.withBase ? "with" : "without", (unsigned)stats.resumedFrom);
+}
+
+// the peer sends save to PKSM, which is waiting for it in receiveSaveFromBridge
+static bool peerToPKSM(const std::vector<u8>& save, const Peer::SendOptions& options = {})
+{
+    Stand::loaded.clear();
+    std::thread pksm(receiveSaveFromBridge);
+    bool sent = Peer::send("127.0.0.1", PKSM_PORT, save, options);
+    pksm.join();
+    return sent && Stand::loaded == save;
+}
+
+// PKSM sends save back to the peer with sendSaveToBridge
+static bool pksmToPeer(std::vector<u8>& save)
+{
+    std::vector<u8> received;
+    int fd = Peer::listen(PKSM_PORT);
+    if (fd < 0)
+    {
+        return false;
+    }
+    TitleLoader::save = std::make_shared<Sav>(Sav{save.data(), (u32)save.size()});
+    bool sent         = false;
+    std::thread pksm([&sent]() { sent = sendSaveToBridge(); });
+    bool ok = Peer::receive(fd, received);
+    pksm.join();
+    close(fd);
+    return ok && sent && received == save;
+}
+
+// changes one byte in each of count blocks spread over the save, so each needs a frame of its own
+static void scatter(std::vector<u8>& save, size_t count, u8 seed)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        save[(i * 7 + 3) * 0x1000 % save.size() + seed] ^= 0xA5;
+    }
+}
+
+int main(void)
+{
+    // PKSM writes to a peer which hung up without ignoring SIGPIPE, which the 3DS doesn't raise
+    signal(SIGPIPE, SIG_IGN);
+
+    // a save with stretches of noise between empty space, like box data
+    std::vector<u8> save(SAVE_SIZE);
+    srand(1);
+    for (size_t pos = 0; pos < save.size(); pos += 0x4000)
+    {
+        for (size_t i = pos; i < pos + 0x1000; i++)
+        {
+            save[i] = rand();
+        }
+    }
+
+    check(peerToPKSM(save), "a whole save reaches PKSM");
+    check(!Peer::stats().withBase && Peer::stats().bytes < save.size(), "it goes without a base, compressed");
+    report();
+
+    check(pksmToPeer(save), "an unchanged save comes back");
+    check(Peer::stats().withBase && Peer::stats().frames == 0, "no frames are sent for it");
+
+    scatter(save, 5, 0);
+    check(pksmToPeer(save), "an edited save comes back");
+    check(Peer::stats().withBase && Peer::stats().frames == 5, "only the changed blocks are sent");
+    report();
+
+    scatter(save, 3, 1);
+    check(peerToPKSM(save), "an edited save reaches PKSM");
+    check(Peer::stats().withBase && Peer::stats().frames == 3, "only the changed blocks are sent");
+
+    // cut short without the base, then picked up where it stopped
+    scatter(save, 20, 2);
+    int errors = Stand::errors;
+    check(!peerToPKSM(save, {true, 3}) && Stand::errors == errors + 1, "a transfer cut short fails");
+    check(peerToPKSM(save, {true, -1}), "sending it again finishes it");
+    check(!Peer::stats().withBase && Peer::stats().resumedFrom == 3 * 0x10000, "it resumes from the last frame");
+    report();
+
+    // cut short without the base, then sent again with it: the resumed buffer never had the base copied in
+    scatter(save, 20, 3);
+    check(!peerToPKSM(save, {true, 3}), "a transfer without the base is cut short");
+    check(peerToPKSM(save), "sending it again with the base finishes it");
+    check(Peer::stats().withBase && Peer::stats().resumedFrom == 0, "it starts over from the base");
+    report();
+
+    // and the other way around
+    scatter(save, 20, 4);
+    check(!peerToPKSM(save, {false, 3}), "a transfer with the base is cut short");
+    check(peerToPKSM(save, {true, -1}), "sending it again whole finishes it");
+    check(!Peer::stats().withBase && Peer::stats().resumedFrom == 0, "it starts over without the base");
+
+    check(pksmToPeer(save), "the last save comes back");
+    check(Peer::stats().frames == 0, "no frames are sent for it");
+
+    printf("%d failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}
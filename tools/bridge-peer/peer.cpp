@@ -0,0 +1,305 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "peer.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+static constexpr char BRIDGE_MAGIC[8]     = {'P', 'K', 'S', 'M', 'B', 'R', 'D', 'G'};
+static constexpr uint32_t BRIDGE_VERSION  = 2;
+static constexpr size_t BRIDGE_BLOCK_SIZE = 0x1000;
+static constexpr size_t BRIDGE_FRAME_SIZE = 0x10000;
+static constexpr size_t BRIDGE_MAX_SIZE   = 0x1000000;
+
+static std::vector<uint8_t> base;
+static uint32_t baseCrc = 0;
+static Peer::Stats lastStats;
+
+static bool sendAll(int fd, const void* buffer, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t n = ::send(fd, (const uint8_t*)buffer + total, size - total, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            return false;
+        }
+        total += n;
+    }
+    return true;
+}
+
+static size_t recvAll(int fd, void* buffer, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t n = recv(fd, (uint8_t*)buffer + total, size - total, 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        total += n;
+    }
+    return total;
+}
+
+static int connectTo(const char* host, uint16_t port)
+{
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+    {
+        return -1;
+    }
+
+    for (int attempt = 0; attempt < 200; attempt++)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        close(fd);
+        usleep(10000);
+    }
+    return -1;
+}
+
+static bool sendFrame(int fd, const uint8_t* data, uint32_t offset, uint32_t length, uint8_t* compressed)
+{
+    uLongf stored = compressBound(length);
+    if (compress2(compressed, &stored, data + offset, length, 1) != Z_OK || stored >= length)
+    {
+        stored = length;
+    }
+    uint32_t frame[4] = {offset, length, (uint32_t)crc32(0, data + offset, length), (uint32_t)stored};
+    lastStats.frames++;
+    lastStats.bytes += stored;
+    return sendAll(fd, frame, sizeof(frame)) && sendAll(fd, stored == length ? data + offset : compressed, stored);
+}
+
+bool Peer::send(const char* host, uint16_t port, const std::vector<uint8_t>& save, const SendOptions& options)
+{
+    lastStats = {0, false, 0, 0};
+    int fd    = connectTo(host, port);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    uint32_t size      = save.size();
+    uint32_t crc       = crc32(0, save.data(), size);
+    bool useBase       = !options.forgetBase && base.size() == size;
+    uint32_t header[4] = {BRIDGE_VERSION, size, crc, useBase ? baseCrc : 0};
+    uint32_t reply[2];
+    if (!sendAll(fd, BRIDGE_MAGIC, sizeof(BRIDGE_MAGIC)) || !sendAll(fd, header, sizeof(header)) ||
+        recvAll(fd, reply, sizeof(reply)) != sizeof(reply) || reply[0] > size || (reply[1] && !useBase))
+    {
+        close(fd);
+        return false;
+    }
+    lastStats.resumedFrom = reply[0];
+    lastStats.withBase    = reply[1];
+
+    // the same runs of changed blocks PKSM sends
+    std::vector<uint8_t> compressed(compressBound(BRIDGE_FRAME_SIZE));
+    bool ok         = true;
+    uint32_t offset = reply[0];
+    while (ok && offset < size)
+    {
+        if (options.cutAfter >= 0 && lastStats.frames == (uint32_t)options.cutAfter)
+        {
+            close(fd);
+            return false;
+        }
+
+        uint32_t length = std::min((uint32_t)BRIDGE_BLOCK_SIZE, size - offset);
+        if (reply[1] && memcmp(&save[offset], &base[offset], length) == 0)
+        {
+            offset += length;
+            continue;
+        }
+
+        uint32_t end = offset + length;
+        while (end < size && end - offset < BRIDGE_FRAME_SIZE)
+        {
+            uint32_t next = std::min((uint32_t)BRIDGE_BLOCK_SIZE, size - end);
+            if (reply[1] && memcmp(&save[end], &base[end], next) == 0)
+            {
+                break;
+            }
+            end += next;
+        }
+
+        ok     = sendFrame(fd, save.data(), offset, end - offset, compressed.data());
+        offset = end;
+    }
+
+    uint32_t end[4] = {0, 0, 0, 0};
+    uint32_t received;
+    ok = ok && sendAll(fd, end, sizeof(end)) && recvAll(fd, &received, sizeof(received)) == sizeof(received) && received == size;
+    close(fd);
+    if (ok)
+    {
+        base    = save;
+        baseCrc = crc;
+    }
+    return ok;
+}
+
+int Peer::listen(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, 1) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// never resumes, so it always asks for everything from the start
+static bool receiveFramed(int fd, std::vector<uint8_t>& save)
+{
+    char magic[sizeof(BRIDGE_MAGIC)];
+    uint32_t header[4];
+    if (recvAll(fd, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, BRIDGE_MAGIC, sizeof(magic)) != 0 ||
+        recvAll(fd, header, sizeof(header)) != sizeof(header) || header[0] != BRIDGE_VERSION || header[1] == 0 ||
+        header[1] > BRIDGE_MAX_SIZE)
+    {
+        return false;
+    }
+
+    bool hasBase = header[3] != 0 && base.size() == header[1] && baseCrc == header[3];
+    std::vector<uint8_t> data(hasBase ? base : std::vector<uint8_t>(header[1]));
+    uint32_t reply[2] = {0, hasBase};
+    lastStats.withBase = hasBase;
+    if (!sendAll(fd, reply, sizeof(reply)))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> compressed(BRIDGE_FRAME_SIZE);
+    uint32_t received = 0;
+    bool done         = false;
+    while (true)
+    {
+        uint32_t frame[4];
+        if (recvAll(fd, frame, sizeof(frame)) != sizeof(frame))
+        {
+            break;
+        }
+        if (frame[1] == 0)
+        {
+            done = hasBase || received == header[1];
+            break;
+        }
+        if (frame[0] < received || (!hasBase && frame[0] != received) || frame[0] > header[1] ||
+            frame[1] > header[1] - frame[0] || frame[1] > BRIDGE_FRAME_SIZE || frame[3] == 0 || frame[3] > frame[1])
+        {
+            break;
+        }
+
+        uint8_t* dest = &data[frame[0]];
+        if (frame[3] == frame[1])
+        {
+            if (recvAll(fd, dest, frame[1]) != frame[1])
+            {
+                break;
+            }
+        }
+        else
+        {
+            uLongf length = frame[1];
+            if (recvAll(fd, compressed.data(), frame[3]) != frame[3] ||
+                uncompress(dest, &length, compressed.data(), frame[3]) != Z_OK || length != frame[1])
+            {
+                break;
+            }
+        }
+        if (crc32(0, dest, frame[1]) != frame[2])
+        {
+            break;
+        }
+        received = frame[0] + frame[1];
+        lastStats.frames++;
+        lastStats.bytes += frame[3];
+    }
+
+    done = done && crc32(0, data.data(), data.size()) == header[2];
+    received = done ? header[1] : received;
+    sendAll(fd, &received, sizeof(received));
+    if (done)
+    {
+        save    = data;
+        base    = data;
+        baseCrc = header[2];
+    }
+    return done;
+}
+
+bool Peer::receive(int fd, std::vector<uint8_t>& save)
+{
+    lastStats = {0, false, 0, 0};
+    int conn  = accept(fd, nullptr, nullptr);
+    if (conn < 0)
+    {
+        return false;
+    }
+    bool ok = receiveFramed(conn, save);
+    close(conn);
+    return ok;
+}
+
+const Peer::Stats& Peer::stats(void)
+{
+    return lastStats;
+}
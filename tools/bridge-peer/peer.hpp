@@ -0,0 +1,66 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// The other end of the PKSM bridge, speaking protocol version 2 as described in source/utils/pksmbridge.cpp.
+// It keeps the save last exchanged as its base, like PKSM does, and can be told to misbehave so resuming gets
+// exercised
+
+#ifndef BRIDGE_PEER_PEER_HPP
+#define BRIDGE_PEER_PEER_HPP
+
+#include <stdint.h>
+#include <vector>
+
+namespace Peer
+{
+    struct SendOptions
+    {
+        // send the save whole, as a peer which lost its base would
+        bool forgetBase = false;
+        // drop the connection after this many frames, or never if negative
+        int cutAfter = -1;
+    };
+
+    // what the last transfer did
+    struct Stats
+    {
+        uint32_t resumedFrom;
+        bool withBase;
+        uint32_t frames;
+        uint32_t bytes;
+    };
+
+    // sends save to PKSM listening at host, retrying the connection for a couple of seconds. Returns whether
+    // PKSM took all of it
+    bool send(const char* host, uint16_t port, const std::vector<uint8_t>& save, const SendOptions& options = {});
+    // returns a socket listening on port for PKSM to send a save back, or -1
+    int listen(uint16_t port);
+    // accepts one connection on fd and receives the save PKSM sends over it
+    bool receive(int fd, std::vector<uint8_t>& save);
+    const Stats& stats(void);
+}
+
+#endif
@@ -0,0 +1,117 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Just enough of PKSM for source/utils/pksmbridge.cpp to build on a PC, with the socket calls going to the
+// host's own. What the bridge loads and reports is kept in Stand so main.cpp can check it
+
+#ifndef BRIDGE_PEER_TITLELOADSCREEN_HPP
+#define BRIDGE_PEER_TITLELOADSCREEN_HPP
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <memory>
+#include <netinet/in.h>
+#include <optional>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef s32 Result;
+
+#define PKSM_PORT 34567
+
+// The bridge doesn't ask for SO_REUSEADDR, which the 3DS doesn't need. Here the checks listen on the same
+// port back to back, so a connection still in TIME_WAIT from the last one mustn't stop the next bind
+static inline int reusableBind(int fd, const struct sockaddr* addr, socklen_t length)
+{
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    return bind(fd, addr, length);
+}
+#define bind reusableBind
+
+class Screen
+{
+public:
+    virtual ~Screen() {}
+};
+
+class MainMenu : public Screen
+{
+};
+
+struct Sav
+{
+    u8* data;
+    u32 length;
+};
+
+namespace Gui
+{
+    void setScreen(std::unique_ptr<Screen> screen);
+    bool showChoiceMessage(const std::string& message, std::optional<std::string> message2 = std::nullopt, int timer = 0);
+    void error(const std::string& message, Result errorCode);
+}
+
+namespace i18n
+{
+    std::string localize(const std::string& key);
+}
+
+namespace StringUtils
+{
+    std::string format(const std::string fmt_str, ...);
+}
+
+namespace TitleLoader
+{
+    bool load(u8* data, size_t size);
+    extern std::shared_ptr<Sav> save;
+}
+
+namespace Stand
+{
+    // the last save the bridge loaded, and how many errors it has shown
+    extern std::vector<u8> loaded;
+    extern int errors;
+}
+
+bool isLoadedSaveFromBridge(void);
+bool receiveSaveFromBridge(void);
+bool sendSaveToBridge(void);
+void setLoadedSaveFromBridge(bool v);
+void backupBridgeChanges(void);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "TitleLoadScreen.hpp"
+#include "BackupStore.hpp"
+
+std::vector<u8> Stand::loaded;
+int Stand::errors = 0;
+std::shared_ptr<Sav> TitleLoader::save;
+const std::string BackupStore::BRIDGE = "%bridge";
+
+void Gui::setScreen(std::unique_ptr<Screen>) {}
+
+bool Gui::showChoiceMessage(const std::string&, std::optional<std::string>, int)
+{
+    return true;
+}
+
+void Gui::error(const std::string&, Result)
+{
+    Stand::errors++;
+}
+
+std::string i18n::localize(const std::string& key)
+{
+    return key;
+}
+
+std::string StringUtils::format(const std::string fmt_str, ...)
+{
+    return fmt_str;
+}
+
+bool TitleLoader::load(u8* data, size_t size)
+{
+    Stand::loaded.assign(data, data + size);
+    return true;
+}
+
+bool BackupStore::backup(const std::string&, const std::string&, const u8*, size_t)
+{
+    return true;
+}
@@ -0,0 +1,251 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/* Runs source/utils/download.c against server.py: fresh downloads, revalidation, a file on disk which fails
+ * its hash, transfers that drop halfway and are resumed, and a file which changes on the server before the
+ * rest of it is fetched. Exits non-zero if anything doesn't hold. */
+
+#include "download.h"
+#include <arpa/inet.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PORT "8765"
+#define URL "http://127.0.0.1:" PORT
+#define SERVED "work/served/"
+#define SAVED "work/saved/"
+#define LOG "work/requests.log"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+static void writeFile(const char *path, const unsigned char *data, size_t size)
+{
+    FILE *file = fopen(path, "wb");
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+/* fills a file on the server with noise, returning its hash */
+static void serve(const char *name, size_t size, unsigned char hash[SHA256_BLOCK_SIZE])
+{
+    char path[256];
+    unsigned char *data = malloc(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = rand();
+    snprintf(path, sizeof(path), SERVED "%s", name);
+    writeFile(path, data, size);
+    if (hash)
+        sha256(hash, data, size);
+    free(data);
+}
+
+static bool exists(const char *path)
+{
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static bool sameFile(const char *a, const char *b)
+{
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    bool same = fa && fb;
+    int ca, cb;
+    while (same) {
+        ca = fgetc(fa);
+        cb = fgetc(fb);
+        same = ca == cb;
+        if (ca == EOF)
+            break;
+    }
+    if (fa)
+        fclose(fa);
+    if (fb)
+        fclose(fb);
+    return same;
+}
+
+static bool served(const char *name)
+{
+    char a[256], b[256];
+    snprintf(a, sizeof(a), SERVED "%s", name);
+    snprintf(b, sizeof(b), SAVED "%s", name);
+    return sameFile(a, b);
+}
+
+/* how many logged requests have every one of the given fields. NULL matches anything, "-" a missing header */
+static int requests(const char *path, const char *status, const char *range, const char *ifRange, const char *ifNoneMatch)
+{
+    const char *want[5] = { path, status, range, ifRange, ifNoneMatch };
+    char line[1024];
+    int count = 0;
+    FILE *log = fopen(LOG, "r");
+    if (!log)
+        return 0;
+    while (fgets(line, sizeof(line), log)) {
+        char *field[5] = { NULL };
+        char *pos = line;
+        line[strcspn(line, "\n")] = '\0';
+        for (int i = 0; i < 5 && pos; i++) {
+            field[i] = pos;
+            pos = strchr(pos, '\t');
+            if (pos)
+                *pos++ = '\0';
+        }
+        bool match = true;
+        for (int i = 0; i < 5; i++) {
+            if (want[i] && (!field[i] || strcmp(field[i], want[i]) != 0))
+                match = false;
+        }
+        count += match;
+    }
+    fclose(log);
+    return count;
+}
+
+static void clearLog(void)
+{
+    remove(LOG);
+}
+
+static pid_t startServer(void)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        execlp("python3", "python3", "server.py", PORT, SERVED, LOG, (char *)NULL);
+        _exit(127);
+    }
+
+    /* wait for it to listen */
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(atoi(PORT));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int attempt = 0; attempt < 500; attempt++) {
+        if (waitpid(pid, NULL, WNOHANG) == pid)
+            return -1;  /* it couldn't start, perhaps because something else has the port */
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int ok = connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        close(fd);
+        if (ok)
+            return pid;
+        usleep(10000);
+    }
+    kill(pid, SIGTERM);
+    return -1;
+}
+
+int main(void)
+{
+    unsigned char hashA[SHA256_BLOCK_SIZE], hashWrong[SHA256_BLOCK_SIZE] = { 0 };
+    char etag[256];
+
+    if (system("rm -rf work && mkdir -p " SERVED " " SAVED) != 0)
+        return 1;
+    srand(1);
+    serve("a.bin", 1500000, hashA);
+    serve("b.bin", 300000, NULL);
+    serve("c.bin", 800000, NULL);
+    serve("d.bin", 800000, NULL);
+    serve("e.bin", 200000, NULL);
+    serve("f.bin", 100000, NULL);
+
+    pid_t server = startServer();
+    if (server < 0) {
+        printf("FAIL server.py didn't start\n");
+        return 1;
+    }
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    struct download_item first[] = {
+        { URL "/a.bin", SAVED "a.bin", hashA, 0 },
+        { URL "/b.bin", SAVED "b.bin", NULL, 0 },
+    };
+    check(download_all(first, 2) == 0 && served("a.bin") && served("b.bin"), "fresh files are downloaded");
+    check(exists(SAVED "a.bin.meta") && exists(SAVED "b.bin.meta") && !exists(SAVED "a.bin.part"), "their validators are kept");
+
+    clearLog();
+    check(download(URL "/b.bin", SAVED "b.bin") == 0 && served("b.bin"), "a current file is kept");
+    check(requests("/b.bin", "304", "-", "-", NULL) == 1, "it's revalidated with If-None-Match");
+
+    /* the sheet on disk went bad, or PKSM now expects a newer one: the server mustn't be asked whether it's current */
+    writeFile(SAVED "a.bin", (const unsigned char *)"corrupt", 7);
+    clearLog();
+    struct download_item rehash = { URL "/a.bin", SAVED "a.bin", hashA, 0 };
+    check(download_all(&rehash, 1) == 0 && served("a.bin"), "a file which fails its hash is replaced");
+    check(requests("/a.bin", "200", "-", "-", "-") == 1, "it's fetched without conditions");
+
+    struct download_item wrong = { URL "/f.bin", SAVED "f.bin", hashWrong, 0 };
+    check(download_all(&wrong, 1) != 0 && !exists(SAVED "f.bin") && !exists(SAVED "f.bin.part"), "a download with the wrong hash isn't kept");
+
+    /* a connection that drops halfway leaves a .part, which is picked up with If-Range */
+    struct download_item dropped = { URL "/drop/c.bin", SAVED "c.bin", NULL, 0 };
+    check(download_all(&dropped, 1) != 0 && exists(SAVED "c.bin.part") && exists(SAVED "c.bin.part.meta"), "a dropped transfer leaves its .part");
+    FILE *meta = fopen(SAVED "c.bin.part.meta", "r");
+    etag[0] = '\0';
+    if (meta) {
+        if (fgets(etag, sizeof(etag), meta))
+            etag[strcspn(etag, "\n")] = '\0';
+        fclose(meta);
+    }
+    clearLog();
+    check(download(URL "/c.bin", SAVED "c.bin") == 0 && served("c.bin"), "it's resumed");
+    check(requests("/c.bin", "206", "bytes=400000-", etag, "-") == 1, "from where it stopped, with If-Range");
+    check(!exists(SAVED "c.bin.part") && !exists(SAVED "c.bin.part.meta"), "the .part is gone");
+
+    /* the file changes on the server before the rest is fetched: only that one is fetched again */
+    struct download_item droppedD = { URL "/drop/d.bin", SAVED "d.bin", NULL, 0 };
+    download_all(&droppedD, 1);
+    serve("d.bin", 800000, NULL);
+    clearLog();
+    struct download_item changed[] = {
+        { URL "/d.bin", SAVED "d.bin", NULL, 0 },
+        { URL "/e.bin", SAVED "e.bin", NULL, 0 },
+    };
+    check(download_all(changed, 2) == 0 && served("d.bin") && served("e.bin"), "a file which changed is fetched whole");
+    check(requests("/d.bin", "200", "bytes=400000-", NULL, NULL) == 1 && requests("/d.bin", "200", "-", "-", "-") == 1,
+        "after its range request got the whole file");
+    check(requests("/e.bin", NULL, NULL, NULL, NULL) == 1, "the other download isn't repeated");
+
+    curl_global_cleanup();
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+
+    printf("%d failure%s\n", failures, failures == 1 ? "" : "s");
+    return failures == 0 ? 0 : 1;
+}
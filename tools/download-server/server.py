@@ -0,0 +1,76 @@
+#!/usr/bin/python3
+# A stand-in for the asset server, for checking source/utils/download.c on a PC. Serves the files in a folder
+# with a strong ETag and Last-Modified, and answers If-None-Match, Range and If-Range the way a real server
+# does. A path starting with /drop/ serves the same file but hangs up halfway through the body. Every request
+# is logged as one tab separated line: path, status, Range, If-Range, If-None-Match.
+#
+# Usage: server.py <port> <folder> <log>
+
+import email.utils, hashlib, http.server, os, re, sys
+
+port, root, log = int(sys.argv[1]), sys.argv[2], sys.argv[3]
+
+class Handler(http.server.BaseHTTPRequestHandler):
+	protocol_version = 'HTTP/1.1'
+
+	def do_GET(self):
+		path = self.path
+		drop = path.startswith('/drop/')
+		if drop:
+			path = path[5:]
+		try:
+			with open(os.path.join(root, path.lstrip('/')), 'rb') as f:
+				data = f.read()
+			mtime = os.path.getmtime(os.path.join(root, path.lstrip('/')))
+		except OSError:
+			self.reply(404, b'', None, None)
+			return
+
+		etag = '"%s"' % hashlib.sha256(data).hexdigest()[:16]
+		modified = email.utils.formatdate(mtime, usegmt=True)
+		ranged = self.headers.get('Range')
+		ifRange = self.headers.get('If-Range')
+		ifNoneMatch = self.headers.get('If-None-Match')
+
+		if ifNoneMatch is not None and ifNoneMatch == etag:
+			self.reply(304, b'', etag, modified)
+		elif ranged and (ifRange is None or ifRange in (etag, modified)):
+			start = int(re.match(r'bytes=(\d+)-', ranged).group(1))
+			if start >= len(data):
+				self.reply(416, b'', etag, modified)
+			else:
+				self.reply(206, data[start:], etag, modified, 'bytes %d-%d/%d' % (start, len(data) - 1, len(data)), drop)
+		else:
+			self.reply(200, data, etag, modified, None, drop)
+
+	def reply(self, status, body, etag, modified, contentRange=None, drop=False):
+		# logged before replying, so the line is there by the time the client has its answer
+		with open(log, 'a') as f:
+			f.write('\t'.join([self.path, str(status)] +
+				[self.headers.get(h) or '-' for h in ('Range', 'If-Range', 'If-None-Match')]) + '\n')
+		self.send_response(status)
+		if etag:
+			self.send_header('ETag', etag)
+			self.send_header('Last-Modified', modified)
+		if contentRange:
+			self.send_header('Content-Range', contentRange)
+		self.send_header('Content-Length', str(len(body)))
+		if drop:
+			self.send_header('Connection', 'close')
+		self.end_headers()
+		self.wfile.write(body[:len(body) // 2] if drop else body)
+		if drop:
+			self.wfile.flush()
+			self.close_connection = True
+
+	def log_message(self, *args):
+		pass
+
+class Server(http.server.ThreadingHTTPServer):
+	# download.c hangs up on purpose when a resumed request gets the whole file back
+	def handle_error(self, request, address):
+		if not isinstance(sys.exc_info()[1], ConnectionError):
+			super().handle_error(request, address)
+
+server = Server(('127.0.0.1', port), Handler)
+server.serve_forever()
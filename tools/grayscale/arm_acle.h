@@ -0,0 +1,53 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// The ACLE intrinsics source/utils/grayscale.c uses on the 3DS, written out in C so its ARMv6 path can be
+// built and checked on a PC. Only what they compute is the same, not how fast
+
+#ifndef GRAYSCALE_ARM_ACLE_H
+#define GRAYSCALE_ARM_ACLE_H
+
+#include <stdint.h>
+
+static inline uint32_t __ror(uint32_t x, uint32_t y)
+{
+    y %= 32;
+    return y == 0 ? x : (x >> y) | (x << (32 - y));
+}
+
+// zero extends bytes 0 and 2 into the two halves
+static inline uint32_t __uxtb16(uint32_t x)
+{
+    return x & 0x00FF00FF;
+}
+
+// signed multiplies of the two halves, both added to a
+static inline int32_t __smlad(uint32_t x, uint32_t y, int32_t a)
+{
+    return a + (int16_t)x * (int16_t)y + (int16_t)(x >> 16) * (int16_t)(y >> 16);
+}
+
+#endif
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Writes the fixture frames grayscale-bench converts: 400x240 RGB565, little-endian, as the camera fills
+# QRScanner's frame buffers. Each is a sheet of black and white modules under uneven, tinted light with
+# sensor noise, like a code held up to the camera, except "colours" which runs through every channel value.
+#
+#     python3 frames.py <directory>
+
+import os
+import random
+import struct
+import sys
+
+WIDTH, HEIGHT = 400, 240
+
+
+def rgb565(r, g, b):
+    clamp = lambda v: max(0, min(255, int(v)))
+    return (clamp(r) >> 3) << 11 | (clamp(g) >> 2) << 5 | clamp(b) >> 3
+
+
+def sheet(rng, light, tint, noise):
+    modules = [[rng.random() < 0.5 for _ in range(33)] for _ in range(33)]
+    size = 6
+    left, top = (WIDTH - 33 * size) // 2, (HEIGHT - 33 * size) // 2
+    pixels = []
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            mx, my = (x - left) // size, (y - top) // size
+            dark = 0 <= mx < 33 and 0 <= my < 33 and modules[my][mx]
+            level = (30 if dark else 220) * light(x, y)
+            n = rng.gauss(0, noise)
+            pixels.append(rgb565(level * tint[0] + n, level * tint[1] + n, level * tint[2] + n))
+    return pixels
+
+
+def colours():
+    # every red and blue value along each row, every green value down the columns
+    return [rgb565(x * 256 // WIDTH, y * 256 // HEIGHT, 255 - x * 256 // WIDTH) for y in range(HEIGHT) for x in range(WIDTH)]
+
+
+def main():
+    out = sys.argv[1]
+    os.makedirs(out, exist_ok=True)
+    rng = random.Random(33)
+    frames = {
+        "daylight": sheet(rng, lambda x, y: 1.0, (1.0, 1.0, 0.95), 4),
+        "lamp": sheet(rng, lambda x, y: 0.5 + 0.6 * x / WIDTH, (1.1, 0.9, 0.6), 8),
+        "dim": sheet(rng, lambda x, y: 0.35 - 0.15 * y / HEIGHT, (0.9, 1.0, 1.1), 12),
+        "colours": colours(),
+    }
+    for name, pixels in frames.items():
+        with open(os.path.join(out, name + ".raw"), "wb") as f:
+            f.write(struct.pack("<%dH" % len(pixels), *pixels))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/* Checks rgb565_to_gray from source/utils/grayscale.c, built as it is for a PC and again with its ARMv6
+ * SIMD path running on arm_acle.h, on every pixel value and on fixture frames, then times it against the
+ * loop QRScanner had before it. The SIMD path's time is only that of the emulation.
+ *
+ *     grayscale-bench frame.raw...
+ *
+ * Frames are 400x240 RGB565, little-endian, as frames.py writes them. Exits non-zero if anything doesn't
+ * hold. */
+
+#include "grayscale.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_WIDTH 400
+#define FRAME_HEIGHT 240
+#define FRAME_PIXELS (FRAME_WIDTH * FRAME_HEIGHT)
+#define TIMED_FRAMES 200
+
+// grayscale.c built with __ARM_FEATURE_SIMD32, see the Makefile
+void rgb565_to_gray_simd32(const uint16_t* src, int width, int height, int srcStride, uint8_t* dst, int downscale);
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// the loop qrHandler had before rgb565_to_gray
+static void oldToGray(const uint16_t *frame, int w, int h, uint8_t *image)
+{
+    for (ssize_t x = 0; x < w; x++)
+    {
+        for (ssize_t y = 0; y < h; y++)
+        {
+            uint16_t px = frame[y * 400 + x];
+            image[y * w + x] = (uint8_t)(((((px >> 11) & 0x1F) << 3) + (((px >> 5) & 0x3F) << 2) + ((px & 0x1F) << 3)) / 3);
+        }
+    }
+}
+
+// both builds, full size and downscaled
+static bool sameBothWays(const uint16_t *src, int width, int height, int stride)
+{
+    static uint8_t scalar[FRAME_PIXELS * 2], simd[FRAME_PIXELS * 2];
+    bool same = true;
+    for (int downscale = 0; downscale <= 1; downscale++)
+    {
+        size_t size = downscale ? (width / 2) * (height / 2) : width * height;
+        memset(scalar, 0x55, size);
+        memset(simd, 0xAA, size);
+        rgb565_to_gray(src, width, height, stride, scalar, downscale);
+        rgb565_to_gray_simd32(src, width, height, stride, simd, downscale);
+        same = same && memcmp(scalar, simd, size) == 0;
+    }
+    return same;
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static double timeFrame(void (*convert)(const uint16_t *, int, int, int, uint8_t *, int), const uint16_t *frame, uint8_t *out)
+{
+    double start = seconds();
+    for (int n = 0; n < TIMED_FRAMES; n++)
+        convert(frame, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH, out, false);
+    return (seconds() - start) / TIMED_FRAMES;
+}
+
+static void oldConvert(const uint16_t *frame, int w, int h, int stride, uint8_t *out, int downscale)
+{
+    (void)stride;
+    (void)downscale;
+    oldToGray(frame, w, h, out);
+}
+
+int main(int argc, char **argv)
+{
+    // every value, once in the first pixel of a pair and once in the second, in rows of an odd width so
+    // each row also ends on a single pixel
+    static uint16_t values[0x10001];
+    for (int i = 0; i <= 0x10000; i++)
+        values[i] = i;
+    check(sameBothWays(values, 257, 255, 257) && sameBothWays(values + 1, 257, 255, 257),
+        "the SIMD path gives the scalar path's luma for every pixel value");
+    check(sameBothWays(values, 255, 255, 257), "and with rows shorter than the stride");
+
+    uint8_t black, white, level = 0;
+    rgb565_to_gray((const uint16_t[]){0x0000}, 1, 1, 1, &black, false);
+    rgb565_to_gray((const uint16_t[]){0xFFFF}, 1, 1, 1, &white, false);
+    check(black == 0 && white == 250, "black is 0 and white 250");
+    bool neutral = true;
+    for (uint16_t r = 0; r < 32; r++)
+    {
+        uint16_t gray = r << 11 | r << 6 | r, frame[400] = {gray};
+        uint8_t old;
+        rgb565_to_gray(&gray, 1, 1, 1, &level, false);
+        oldToGray(frame, 1, 1, &old);
+        neutral = neutral && level == old;
+    }
+    check(neutral, "neutral grays keep the level the old loop gave them");
+
+    static uint16_t frame[FRAME_PIXELS];
+    static uint8_t out[FRAME_PIXELS];
+    for (int i = 1; i < argc; i++)
+    {
+        FILE *in = fopen(argv[i], "rb");
+        bool read = in && fread(frame, sizeof(frame), 1, in) == 1;
+        if (in)
+            fclose(in);
+        char what[256];
+        snprintf(what, sizeof(what), "%s: both paths agree, full size and downscaled", argv[i]);
+        check(read && sameBothWays(frame, FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH), what);
+        if (!read)
+            continue;
+
+        double oldTime = timeFrame(oldConvert, frame, out), newTime = timeFrame(rgb565_to_gray, frame, out),
+               simdTime = timeFrame(rgb565_to_gray_simd32, frame, out);
+        printf("     old loop %.0f us, rgb565_to_gray %.0f us, emulated SIMD %.0f us per frame\n", oldTime * 1e6,
+            newTime * 1e6, simdTime * 1e6);
+    }
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
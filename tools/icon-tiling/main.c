@@ -0,0 +1,146 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/* Checks smdh_icon_to_texture from source/utils/iconTiling.c against the per-row copy Title.cpp used before
+ * it, and against where each 8x8 tile of the icon should land in the texture, then times both. Exits
+ * non-zero if anything doesn't hold. */
+
+#include "iconTiling.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ICON_TEXELS (SMDH_ICON_SIZE * SMDH_ICON_SIZE)
+#define TEXTURE_TEXELS (ICON_TEXTURE_SIZE * ICON_TEXTURE_SIZE)
+// the icon fills the end of the texture, as in Title.cpp
+#define ICON_START ((ICON_TEXTURE_SIZE - SMDH_ICON_SIZE) * ICON_TEXTURE_SIZE)
+#define TIMED_ICONS 200000
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// the loop loadTextureIcon had before smdh_icon_to_texture
+static void oldIconToTexture(const uint16_t *icon, uint16_t *texture)
+{
+    uint16_t *dest = texture;
+    const uint16_t *src = icon;
+    for (int j = 0; j < 48; j += 8)
+    {
+        for (int i = 0; i < 48 * 8; i++)
+            dest[i] = src[i];
+        src += 48 * 8;
+        dest += 64 * 8;
+    }
+}
+
+static void randomIcon(uint16_t *icon)
+{
+    for (int i = 0; i < ICON_TEXELS; i++)
+        icon[i] = rand();
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(void)
+{
+    static uint16_t icon[ICON_TEXELS], oldTexture[TEXTURE_TEXELS], newTexture[TEXTURE_TEXELS];
+    srand(1);
+
+    bool same = true, inPlace = true, untouched = true;
+    for (int n = 0; n < 100; n++)
+    {
+        randomIcon(icon);
+        // a fresh texture holds whatever linearAlloc returned
+        for (int i = 0; i < TEXTURE_TEXELS; i++)
+            oldTexture[i] = newTexture[i] = 0xA5A5 ^ i;
+        oldIconToTexture(icon, oldTexture + ICON_START);
+        smdh_icon_to_texture(icon, newTexture + ICON_START);
+        same = same && memcmp(oldTexture, newTexture, sizeof(newTexture)) == 0;
+
+        // tile (x, y) of the icon is tile (x, y) of the texture's last six rows of tiles, texels in the same order
+        for (int y = 0; y < SMDH_ICON_SIZE / 8; y++)
+        {
+            for (int x = 0; x < SMDH_ICON_SIZE / 8; x++)
+            {
+                const uint16_t *from = icon + (y * SMDH_ICON_SIZE / 8 + x) * 64;
+                const uint16_t *to = newTexture + ICON_START + (y * ICON_TEXTURE_SIZE / 8 + x) * 64;
+                inPlace = inPlace && memcmp(from, to, 64 * sizeof(uint16_t)) == 0;
+            }
+            // the two tiles to the right of each row are left alone
+            for (int i = ICON_START + (y * 8 + 6) * 64; i < ICON_START + (y * 8 + 8) * 64; i++)
+                untouched = untouched && newTexture[i] == (uint16_t)(0xA5A5 ^ i);
+        }
+        for (int i = 0; i < ICON_START; i++)
+            untouched = untouched && newTexture[i] == (uint16_t)(0xA5A5 ^ i);
+    }
+    check(same, "the texture matches the old loop's, texel for texel");
+    check(inPlace, "every tile of the icon lands in the same tile of the texture");
+    check(untouched, "nothing outside the icon's tiles is written");
+
+    // the title cache stores ICON_TEXTURE_TEXELS from the icon's first texel and copies them straight back
+    static uint16_t cached[ICON_TEXTURE_TEXELS], restored[TEXTURE_TEXELS];
+    memcpy(cached, newTexture + ICON_START, sizeof(cached));
+    memcpy(restored + ICON_START, cached, sizeof(cached));
+    check(memcmp(restored + ICON_START, newTexture + ICON_START, sizeof(cached)) == 0 &&
+              ICON_START + ICON_TEXTURE_TEXELS == TEXTURE_TEXELS,
+        "a cached icon restores the same texels and ends with the texture");
+
+    unsigned sum = 0;
+    double start = seconds();
+    for (int n = 0; n < TIMED_ICONS; n++)
+    {
+        icon[n % ICON_TEXELS] = n;
+        oldIconToTexture(icon, oldTexture + ICON_START);
+        sum += oldTexture[TEXTURE_TEXELS - 1 - n % 64];
+    }
+    double oldTime = seconds() - start;
+    start = seconds();
+    for (int n = 0; n < TIMED_ICONS; n++)
+    {
+        icon[n % ICON_TEXELS] = n;
+        smdh_icon_to_texture(icon, newTexture + ICON_START);
+        sum += newTexture[TEXTURE_TEXELS - 1 - n % 64];
+    }
+    double newTime = seconds() - start;
+    printf("     old loop %.1f ns per icon, smdh_icon_to_texture %.1f ns per icon (%u)\n", oldTime / TIMED_ICONS * 1e9,
+        newTime / TIMED_ICONS * 1e9, sum & 1);
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
@@ -0,0 +1,316 @@
+#!/usr/bin/env python3
+# Writes the QR fixture corpus qr-bench decodes: codes carrying the payloads PKSM scans (PK4/5 and PK6
+# links, wondercard links and binary PK7 codes), drawn into 400x240 camera frames at different sizes,
+# angles and tilts under uneven light, with blur and sensor noise. Every frame is an 8-bit PGM, its
+# expected payload next to it as <name>.payload.
+#
+#     python3 corpus.py <directory>
+
+import base64
+import math
+import multiprocessing
+import os
+import random
+import sys
+
+WIDTH, HEIGHT = 400, 240
+
+# QR code tables for error correction levels L and M, indexed by version
+ECC_PER_BLOCK = {
+    "L": [-1, 7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30],
+    "M": [-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26, 26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28],
+}
+BLOCKS = {
+    "L": [-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 4, 6, 6, 6, 6, 7, 8, 8, 9, 9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25],
+    "M": [-1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5, 5, 8, 9, 9, 10, 10, 11, 13, 14, 16, 17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49],
+}
+FORMAT_ECC = {"L": 1, "M": 0}
+
+
+def gf_mul(x, y):
+    z = 0
+    for i in reversed(range(8)):
+        z = (z << 1) ^ ((z >> 7) * 0x11D)
+        z ^= ((y >> i) & 1) * x
+    return z
+
+
+def rs_remainder(data, degree):
+    divisor = [0] * (degree - 1) + [1]
+    root = 1
+    for _ in range(degree):
+        for j in range(degree):
+            divisor[j] = gf_mul(divisor[j], root)
+            if j + 1 < degree:
+                divisor[j] ^= divisor[j + 1]
+        root = gf_mul(root, 2)
+    result = [0] * degree
+    for b in data:
+        factor = b ^ result.pop(0)
+        result.append(0)
+        for i, coef in enumerate(divisor):
+            result[i] ^= gf_mul(coef, factor)
+    return result
+
+
+def raw_modules(version):
+    result = (16 * version + 128) * version + 64
+    if version >= 2:
+        align = version // 7 + 2
+        result -= (25 * align - 10) * align - 55
+        if version >= 7:
+            result -= 36
+    return result
+
+
+def data_codewords(version, ecl):
+    return raw_modules(version) // 8 - ECC_PER_BLOCK[ecl][version] * BLOCKS[ecl][version]
+
+
+def codewords(payload, version, ecl):
+    """the payload in byte mode, padded, split into blocks with their error correction and interleaved"""
+    bits = [0, 1, 0, 0]
+    count_bits = 8 if version < 10 else 16
+    bits += [(len(payload) >> i) & 1 for i in reversed(range(count_bits))]
+    for b in payload:
+        bits += [(b >> i) & 1 for i in reversed(range(8))]
+    capacity = data_codewords(version, ecl) * 8
+    assert len(bits) <= capacity, "payload too long for the version"
+    bits += [0] * min(4, capacity - len(bits))
+    bits += [0] * (-len(bits) % 8)
+    data = [int("".join(map(str, bits[i:i + 8])), 2) for i in range(0, len(bits), 8)]
+    pad = 0xEC
+    while len(data) < capacity // 8:
+        data.append(pad)
+        pad ^= 0xEC ^ 0x11
+
+    blocks_n = BLOCKS[ecl][version]
+    ecc_n = ECC_PER_BLOCK[ecl][version]
+    raw = raw_modules(version) // 8
+    short_n = blocks_n - raw % blocks_n
+    short_len = raw // blocks_n
+    blocks = []
+    k = 0
+    for i in range(blocks_n):
+        block = data[k:k + short_len - ecc_n + (0 if i < short_n else 1)]
+        k += len(block)
+        ecc = rs_remainder(block, ecc_n)
+        if i < short_n:
+            block.append(0)
+        blocks.append(block + ecc)
+    result = []
+    for i in range(len(blocks[0])):
+        for j, block in enumerate(blocks):
+            if i != short_len - ecc_n or j >= short_n:
+                result.append(block[i])
+    return result
+
+
+def alignment_positions(version, size):
+    if version == 1:
+        return []
+    align = version // 7 + 2
+    step = (version * 8 + align * 3 + 5) // (align * 4 - 4) * 2
+    return [6] + sorted(size - 7 - i * step for i in range(align - 1))
+
+
+def encode(payload, ecl="M", mask=0):
+    """the modules of the smallest code holding payload, True for dark, as rows"""
+    version = next(v for v in range(1, 41) if data_codewords(v, ecl) * 8 >= 4 + (8 if v < 10 else 16) + len(payload) * 8)
+    size = version * 4 + 17
+    modules = [[False] * size for _ in range(size)]
+    function = [[False] * size for _ in range(size)]
+
+    def put(x, y, dark):
+        modules[y][x] = dark
+        function[y][x] = True
+
+    for i in range(size):
+        put(6, i, i % 2 == 0)
+        put(i, 6, i % 2 == 0)
+    for cx, cy in ((3, 3), (size - 4, 3), (3, size - 4)):
+        for dy in range(-4, 5):
+            for dx in range(-4, 5):
+                if 0 <= cx + dx < size and 0 <= cy + dy < size:
+                    put(cx + dx, cy + dy, max(abs(dx), abs(dy)) not in (2, 4))
+    positions = alignment_positions(version, size)
+    for i, cx in enumerate(positions):
+        for j, cy in enumerate(positions):
+            if (i, j) in ((0, 0), (0, len(positions) - 1), (len(positions) - 1, 0)):
+                continue
+            for dy in range(-2, 3):
+                for dx in range(-2, 3):
+                    put(cx + dx, cy + dy, max(abs(dx), abs(dy)) != 1)
+
+    format_data = FORMAT_ECC[ecl] << 3 | mask
+    rem = format_data
+    for _ in range(10):
+        rem = (rem << 1) ^ ((rem >> 9) * 0x537)
+    format_bits = (format_data << 10 | rem) ^ 0x5412
+    bit = lambda i: (format_bits >> i) & 1 == 1
+    for i in range(6):
+        put(8, i, bit(i))
+    put(8, 7, bit(6))
+    put(8, 8, bit(7))
+    put(7, 8, bit(8))
+    for i in range(9, 15):
+        put(14 - i, 8, bit(i))
+    for i in range(8):
+        put(size - 1 - i, 8, bit(i))
+    for i in range(8, 15):
+        put(8, size - 15 + i, bit(i))
+    put(8, size - 8, True)
+
+    if version >= 7:
+        rem = version
+        for _ in range(12):
+            rem = (rem << 1) ^ ((rem >> 11) * 0x1F25)
+        version_bits = version << 12 | rem
+        for i in range(18):
+            dark = (version_bits >> i) & 1 == 1
+            a, b = size - 11 + i % 3, i // 3
+            put(a, b, dark)
+            put(b, a, dark)
+
+    masks = [
+        lambda x, y: (x + y) % 2 == 0,
+        lambda x, y: y % 2 == 0,
+        lambda x, y: x % 3 == 0,
+        lambda x, y: (x + y) % 3 == 0,
+        lambda x, y: (x // 3 + y // 2) % 2 == 0,
+        lambda x, y: x * y % 2 + x * y % 3 == 0,
+        lambda x, y: (x * y % 2 + x * y % 3) % 2 == 0,
+        lambda x, y: ((x + y) % 2 + x * y % 3) % 2 == 0,
+    ]
+    data = codewords(payload, version, ecl)
+    i = 0
+    right = size - 1
+    while right >= 1:
+        if right == 6:
+            right = 5
+        for vert in range(size):
+            for j in range(2):
+                x = right - j
+                upward = (right + 1) & 2 == 0
+                y = size - 1 - vert if upward else vert
+                if not function[y][x] and i < len(data) * 8:
+                    modules[y][x] = (data[i >> 3] >> (7 - (i & 7))) & 1 == 1
+                    i += 1
+                if not function[y][x] and masks[mask](x, y):
+                    modules[y][x] = not modules[y][x]
+        right -= 2
+    return modules
+
+
+def payloads(rng):
+    """one payload of each kind QRScanner reads, the data in them random"""
+    data = lambda n: bytes(rng.randrange(256) for _ in range(n))
+    pk7 = bytearray(data(0x1A2))
+    pk7[16:20] = (1).to_bytes(4, "little")  # one copy
+    return {
+        "pk5": b"null/#" + base64.b64encode(data(136)),
+        "pk6": b"http://lunarcookies.github.io/b1s1.html#" + base64.b64encode(data(232)),
+        "wc6": b"http://lunarcookies.github.io/wc.html#" + base64.b64encode(data(264)),
+        "pk7": bytes(pk7),
+    }
+
+
+def render(modules, rng, scene):
+    """the code drawn into a grayscale frame as a camera would see it"""
+    size = len(modules)
+    quiet = 4
+    span = size + 2 * quiet
+    px = scene["module"]
+    angle = math.radians(scene["angle"])
+    cos, sin = math.cos(angle), math.sin(angle)
+    cx, cy = WIDTH / 2 + scene["shift"][0], HEIGHT / 2 + scene["shift"][1]
+    tilt = scene["tilt"]
+    dark, light = scene["contrast"]
+
+    def level(x, y):
+        # back through the rotation, then the tilt, which narrows the code towards its top
+        dx, dy = x - cx, y - cy
+        u, v = (dx * cos + dy * sin) / px, (-dx * sin + dy * cos) / px
+        u /= 1 + tilt * v / span
+        mx, my = math.floor(u + span / 2) - quiet, math.floor(v + span / 2) - quiet
+        if 0 <= mx < size and 0 <= my < size and modules[my][mx]:
+            return dark
+        if abs(u) <= span / 2 + 3 and abs(v) <= span / 2 + 3:
+            return light
+        return scene["background"]
+
+    # each pixel averages four samples of what's in front of it, as a sensor's pixels take in their area
+    image = []
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            seen = level(x + 0.25, y + 0.25) + level(x + 0.75, y + 0.25) + level(x + 0.25, y + 0.75) + level(x + 0.75, y + 0.75)
+            image.append(seen / 4 * scene["light"](x, y))
+    for _ in range(scene["blur"]):
+        image = [(image[i - 1 if i % WIDTH else i] + 2 * image[i] + image[i + 1 if (i + 1) % WIDTH else i]) / 4 for i in range(len(image))]
+        image = [(image[i - WIDTH if i >= WIDTH else i] + 2 * image[i] + image[i + WIDTH if i + WIDTH < len(image) else i]) / 4 for i in range(len(image))]
+    return bytes(max(0, min(255, int(p + rng.gauss(0, scene["noise"])))) for p in image)
+
+
+# how much light falls on each part of the frame
+def even(x, y):
+    return 1.0
+
+
+def side(x, y):
+    return 0.45 + 0.75 * x / WIDTH
+
+
+def spot(x, y):
+    return 1.05 - 0.6 * math.hypot(x - 120, y - 60) / 400
+
+
+def scenes(rng):
+    """the conditions every payload is drawn under"""
+    base = dict(angle=0, shift=(0, 0), tilt=0.0, contrast=(40, 215), background=120, light=even, blur=0, noise=3)
+    variants = {
+        "flat": {},
+        "rotated": dict(angle=17, shift=(20, -6)),
+        "tilted": dict(angle=-8, tilt=0.25),
+        "sidelight": dict(light=side, noise=6),
+        "spotlight": dict(light=spot, angle=5),
+        "lowcontrast": dict(contrast=(90, 170), noise=5),
+        "blurred": dict(blur=2, angle=-12),
+        "noisy": dict(noise=14, angle=30),
+        "dim": dict(contrast=(15, 90), background=50, noise=8, blur=1),
+    }
+    result = []
+    for name, changes in variants.items():
+        scene = dict(base)
+        scene.update(changes)
+        result.append((name, scene))
+    return result
+
+
+def write(job):
+    stem, modules, scene, seed = job
+    with open(stem + ".pgm", "wb") as f:
+        f.write(b"P5\n%d %d\n255\n" % (WIDTH, HEIGHT))
+        f.write(render(modules, random.Random(seed), scene))
+
+
+def main():
+    out = sys.argv[1]
+    os.makedirs(out, exist_ok=True)
+    rng = random.Random(34)
+    jobs = []
+    for kind, payload in payloads(rng).items():
+        modules = encode(payload, "M", mask=rng.randrange(8))
+        for name, scene in scenes(rng):
+            # as large as fits the frame, and a little further away
+            fit = (HEIGHT - 20) / (len(modules) + 8)
+            for distance, module in (("near", fit), ("far", fit * 0.9)):
+                stem = os.path.join(out, "%s-%s-%s" % (kind, name, distance))
+                with open(stem + ".payload", "wb") as f:
+                    f.write(payload)
+                jobs.append((stem, modules, dict(scene, module=module), rng.randrange(1 << 30)))
+    with multiprocessing.Pool() as pool:
+        pool.map(write, jobs)
+
+
+if __name__ == "__main__":
+    main()
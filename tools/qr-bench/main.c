@@ -0,0 +1,238 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/* Decodes the QR fixture corpus corpus.py writes with source/quirc, the way QRScanner does with a whole
+ * frame, and checks that identify.c's threshold() binarises every frame exactly as quirc's original one.
+ * Prints whether each frame decodes and how long it takes, then the decode rate and latency over the
+ * corpus, and the time threshold() takes against the original.
+ *
+ *     qr-bench frame.pgm...
+ *
+ * Each frame is a 400x240 8-bit PGM with its expected payload in frame.payload. Exits non-zero if a
+ * binarisation differs or a code decodes to the wrong payload. */
+
+#include "quirc_internal.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_WIDTH 400
+#define FRAME_HEIGHT 240
+#define FRAME_PIXELS (FRAME_WIDTH * FRAME_HEIGHT)
+#define TIMED_RUNS 20
+
+// identify.c's threshold(), from threshold.c
+void qr_bench_threshold(struct quirc *q);
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+        failures++;
+}
+
+// quirc's threshold() as PKSM first had it, divisions and all
+#define THRESHOLD_S_DEN 8
+#define THRESHOLD_T 5
+
+static void originalThreshold(struct quirc *q)
+{
+    int x, y;
+    int avg_w = 0;
+    int avg_u = 0;
+    int threshold_s = q->w / THRESHOLD_S_DEN;
+    quirc_pixel_t *row = q->pixels;
+
+    for (y = 0; y < q->h; y++) {
+        int row_average[q->w];
+
+        memset(row_average, 0, sizeof(row_average));
+
+        for (x = 0; x < q->w; x++) {
+            int w, u;
+
+            if (y & 1) {
+                w = x;
+                u = q->w - 1 - x;
+            } else {
+                w = q->w - 1 - x;
+                u = x;
+            }
+
+            avg_w = (avg_w * (threshold_s - 1)) / threshold_s + row[w];
+            avg_u = (avg_u * (threshold_s - 1)) / threshold_s + row[u];
+
+            row_average[w] += avg_w;
+            row_average[u] += avg_u;
+        }
+
+        for (x = 0; x < q->w; x++) {
+            if (row[x] < row_average[x] * (100 - THRESHOLD_T) / (200 * threshold_s))
+                row[x] = QUIRC_PIXEL_BLACK;
+            else
+                row[x] = QUIRC_PIXEL_WHITE;
+        }
+
+        row += q->w;
+    }
+}
+
+static double seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int compareTimes(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static size_t readFile(const char *path, uint8_t *buffer, size_t size)
+{
+    FILE *in = fopen(path, "rb");
+    if (!in)
+        return 0;
+    size_t read = fread(buffer, 1, size, in);
+    fclose(in);
+    return read;
+}
+
+static bool readFrame(const char *path, uint8_t *frame)
+{
+    static uint8_t file[FRAME_PIXELS + 64];
+    size_t size = readFile(path, file, sizeof(file));
+    const char header[] = "P5\n400 240\n255\n";
+    if (size != FRAME_PIXELS + sizeof(header) - 1 || memcmp(file, header, sizeof(header) - 1) != 0)
+        return false;
+    memcpy(frame, file + sizeof(header) - 1, FRAME_PIXELS);
+    return true;
+}
+
+// what qrHandler does with a frame: 1 if a code decodes to payload, 0 if none decodes, -1 if one
+// decodes to anything else
+static int scan(struct quirc *q, const uint8_t *frame, const uint8_t *payload, size_t payloadLength)
+{
+    memcpy(quirc_begin(q, NULL, NULL), frame, FRAME_PIXELS);
+    quirc_end(q);
+    int result = 0;
+    for (int i = 0; i < quirc_count(q); i++)
+    {
+        struct quirc_code code;
+        struct quirc_data data;
+        quirc_extract(q, i, &code);
+        if (quirc_decode(&code, &data) != QUIRC_SUCCESS)
+            continue;
+        if ((size_t)data.payload_len != payloadLength || memcmp(data.payload, payload, payloadLength) != 0)
+            return -1;
+        result = 1;
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t frame[FRAME_PIXELS], payload[QUIRC_MAX_PAYLOAD];
+    static double latencies[4096];
+    struct quirc *q = quirc_new();
+    quirc_resize(q, FRAME_WIDTH, FRAME_HEIGHT);
+
+    int frames = 0, decoded = 0, identical = 0, wrong = 0, unreadable = 0;
+    double originalTime = 0, thresholdTime = 0;
+    for (int i = 1; i < argc && frames < 4096; i++)
+    {
+        char payloadPath[4096];
+        snprintf(payloadPath, sizeof(payloadPath), "%.*s.payload", (int)(strlen(argv[i]) - 4), argv[i]);
+        size_t payloadLength = readFile(payloadPath, payload, sizeof(payload));
+        if (!readFrame(argv[i], frame) || payloadLength == 0)
+        {
+            printf("     %s: can't read it or its payload\n", argv[i]);
+            unreadable++;
+            continue;
+        }
+
+        // the same frame binarised by both, each timed on its own. quirc thresholds its image in place
+        static uint8_t original[FRAME_PIXELS];
+        q->pixels = quirc_begin(q, NULL, NULL);
+        double start = seconds();
+        for (int n = 0; n < TIMED_RUNS; n++)
+        {
+            memcpy(q->pixels, frame, FRAME_PIXELS);
+            originalThreshold(q);
+        }
+        originalTime += (seconds() - start) / TIMED_RUNS;
+        memcpy(original, q->pixels, FRAME_PIXELS);
+        start = seconds();
+        for (int n = 0; n < TIMED_RUNS; n++)
+        {
+            memcpy(q->pixels, frame, FRAME_PIXELS);
+            qr_bench_threshold(q);
+        }
+        thresholdTime += (seconds() - start) / TIMED_RUNS;
+        identical += memcmp(original, q->pixels, FRAME_PIXELS) == 0;
+
+        int result = scan(q, frame, payload, payloadLength);
+        double best = 0;
+        for (int n = 0; n < TIMED_RUNS; n++)
+        {
+            start = seconds();
+            scan(q, frame, payload, payloadLength);
+            double time = seconds() - start;
+            best = n == 0 || time < best ? time : best;
+        }
+        latencies[frames++] = best;
+        decoded += result == 1;
+        wrong += result == -1;
+        printf("     %-40s %-9s %6.2f ms\n", argv[i], result == 1 ? "decoded" : result == 0 ? "missed" : "WRONG", best * 1e3);
+    }
+
+    check(frames > 0 && unreadable == 0, "every frame and payload in the corpus reads");
+    check(identical == frames, "threshold() binarises every frame exactly as quirc's original one");
+    check(wrong == 0, "no code decodes to anything but its payload");
+
+    if (frames > 0)
+    {
+        qsort(latencies, frames, sizeof(double), compareTimes);
+        double total = 0;
+        for (int i = 0; i < frames; i++)
+            total += latencies[i];
+        printf("     decoded %d of %d frames\n", decoded, frames);
+        printf("     latency per frame: mean %.2f ms, median %.2f ms, 90th percentile %.2f ms, worst %.2f ms\n",
+            total / frames * 1e3, latencies[frames / 2] * 1e3, latencies[frames * 9 / 10] * 1e3, latencies[frames - 1] * 1e3);
+        printf("     threshold() %.0f us per frame, the original %.0f us\n", thresholdTime / frames * 1e6,
+            originalTime / frames * 1e6);
+    }
+
+    quirc_destroy(q);
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
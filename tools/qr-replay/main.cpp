@@ -0,0 +1,201 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Runs source/gui/QRScanner.cpp on the recordings record.py writes, its camThread, procThread, uiThread and
+// decoder passing frames to each other through tripleBuffer.hpp as on the 3DS, with shim/ standing in for
+// the camera, the screen and the save. Checks that a code is handed back once it comes into view, that a
+// sheet of PK7 codes fills the empty box slots, and that with a slow decoder frames are skipped rather
+// than queued, so every search is of a frame taken just before it. Prints the frames each stage saw and
+// how far behind the camera the decoder ran.
+//
+//     qr-replay <recordings directory>
+//
+// Exits non-zero if anything doesn't hold.
+
+#include "QRScanner.hpp"
+#include "Replay.hpp"
+#include "Stand.hpp"
+#include <algorithm>
+#include <stdio.h>
+
+static constexpr int LEAD_IN   = 10; // frames before the codes come into view, as record.py draws them
+static constexpr int PK7_SIZE  = 232;
+static constexpr s64 MS        = 1000000;
+static constexpr s64 SLOW      = 150 * MS;
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+static std::vector<u8> readFile(const std::string& path)
+{
+    std::vector<u8> data;
+    FILE* in = fopen(path.c_str(), "rb");
+    if (in)
+    {
+        u8 buffer[0x10000];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        {
+            data.insert(data.end(), buffer, buffer + read);
+        }
+        fclose(in);
+    }
+    return data;
+}
+
+struct Scan
+{
+    u8* buff = NULL;
+    s64 done = 0; // when QRScanner::init returned
+    std::vector<u8> expect;
+};
+
+// scans the recording name in mode, with every search taking delay longer
+static Scan scan(const std::string& dir, const char* name, QRMode mode, s64 delay)
+{
+    std::vector<u8> bytes = readFile(dir + "/" + name + ".rgb565");
+    std::vector<u16> frames(bytes.size() / sizeof(u16));
+    std::copy(bytes.begin(), bytes.begin() + frames.size() * sizeof(u16), (u8*)frames.data());
+
+    Scan result;
+    result.expect = readFile(dir + "/" + name + ".expect");
+    // a save with the first slot taken, so a sheet has to look for empty ones
+    TitleLoader::save = std::make_shared<Sav>(2);
+    TitleLoader::save->slots[0][0] = 1;
+
+    Replay::start(frames, delay);
+    QRScanner::init(mode, result.buff);
+    result.done = Replay::now();
+    return result;
+}
+
+// prints what each stage saw, and checks the frames went through them in order and none of them twice
+static void report(const char* name, s64 delay)
+{
+    const Replay::Stats& stats = Replay::stats();
+    s64 worst = 0, total = 0;
+    for (s64 age : stats.ages)
+    {
+        worst = std::max(worst, age);
+        total += age;
+    }
+    printf("     %d frames captured, %d dropped, %d converted, %d searched, %d refreshes drawn\n", stats.captured,
+        stats.dropped, (int)stats.converted.size(), (int)stats.searched.size(), stats.drawn);
+    printf("     searched %.1f ms after capture on average, %.1f ms at most\n",
+        stats.ages.empty() ? 0.0 : (double)total / stats.ages.size() / MS, (double)worst / MS);
+
+    std::string what = std::string(name) + ": each stage sees every frame once at most, newest last";
+    check(std::is_sorted(stats.converted.begin(), stats.converted.end()) &&
+              std::adjacent_find(stats.converted.begin(), stats.converted.end()) == stats.converted.end() &&
+              std::is_sorted(stats.searched.begin(), stats.searched.end()) &&
+              std::adjacent_find(stats.searched.begin(), stats.searched.end()) == stats.searched.end() &&
+              std::all_of(stats.ages.begin(), stats.ages.end(), [](s64 age) { return age >= 0; }),
+        what.c_str());
+
+    // a search may wait out a search of the frame before, the conversion and a frame's capture, but if
+    // frames were queued each one would fall further behind
+    what = std::string(name) + ": no search is of a frame more than a search and two frames old";
+    check(worst < delay + 2 * Replay::FRAME_NS + 100 * MS, what.c_str());
+}
+
+static void latency(const Scan& result)
+{
+    s64 inView = Replay::capturedAt(LEAD_IN);
+    if (inView >= 0)
+    {
+        printf("     done %.1f ms after the code came into view\n", (double)(result.done - inView) / MS);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: qr-replay <recordings directory>\n");
+        return 2;
+    }
+    std::string dir = argv[1];
+
+    {
+        Scan result = scan(dir, "pk6", PKM6, 0);
+        check(result.expect.size() == PK7_SIZE && result.buff != NULL &&
+                  std::equal(result.expect.begin(), result.expect.end(), result.buff),
+            "pk6: the PK6 comes back decoded");
+        latency(result);
+        report("pk6", 0);
+        delete[] result.buff;
+    }
+
+    {
+        Scan result = scan(dir, "sheet", PKM7, 0);
+        const Replay::Stats& stats = Replay::stats();
+        std::vector<std::vector<u8>> expect, slots(TitleLoader::save->slots.begin() + 1, TitleLoader::save->slots.begin() + 3);
+        for (size_t pos = 0; pos + PK7_SIZE <= result.expect.size(); pos += PK7_SIZE)
+        {
+            expect.emplace_back(result.expect.begin() + pos, result.expect.begin() + pos + PK7_SIZE);
+        }
+        check(result.buff == NULL && expect.size() == 2 && std::is_permutation(expect.begin(), expect.end(), slots.begin()),
+            "sheet: both PK7s go into the first empty slots");
+        check(TitleLoader::save->slots[0][0] == 1 && TitleLoader::save->pkm(0, 3)->species() == 0,
+            "sheet: no other slot changes");
+        check(std::count(stats.warnings.begin(), stats.warnings.end(), "QR_BATCH_IMPORTED") == 1, "sheet: the import is reported");
+        latency(result);
+        report("sheet", 0);
+    }
+
+    {
+        Scan result = scan(dir, "empty", PKM6, 0);
+        check(result.buff == NULL && Replay::stats().warnings.empty(),
+            "empty: nothing comes back once B is pressed");
+        report("empty", 0);
+    }
+
+    {
+        Scan result = scan(dir, "pk6", PKM6, SLOW);
+        check(result.buff != NULL && std::equal(result.expect.begin(), result.expect.end(), result.buff),
+            "pk6 with a slow decoder: the PK6 comes back decoded");
+        latency(result);
+        report("pk6 with a slow decoder", SLOW);
+        delete[] result.buff;
+    }
+
+    {
+        scan(dir, "empty", PKM6, SLOW);
+        const Replay::Stats& stats = Replay::stats();
+        check(stats.searched.size() * 3 < stats.converted.size(), "empty with a slow decoder: most frames are skipped");
+        report("empty with a slow decoder", SLOW);
+    }
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}
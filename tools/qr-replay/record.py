@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# Writes the camera recordings qr-replay plays back through QRScanner: 400x240 RGB565 frames one after
+# another in <name>.rgb565, as the camera hands them to PKSM. Every recording opens on LEAD_IN frames of
+# an empty background before its codes come into view and drift across the frame as a hand-held 3DS
+# would see them. What the scanner should hand back is next to it as <name>.expect: the decoded PK6 for
+# pk6, the PK7 of each code in turn for sheet, nothing for empty. The codes are drawn with qr-bench's
+# corpus.py.
+#
+#     python3 record.py <directory>
+
+import array
+import base64
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "qr-bench"))
+import corpus  # noqa: E402
+
+WIDTH, HEIGHT = corpus.WIDTH, corpus.HEIGHT
+LEAD_IN = 10  # keep in step with main.cpp
+MOVING = 30
+BACKGROUND = 120
+SCENE = dict(corpus.scenes(random.Random(0))[0][1], noise=0)
+
+
+def draw(modules, module, shift):
+    return list(corpus.render(modules, random.Random(0), dict(SCENE, module=module, shift=shift)))
+
+
+def overlay(first, second):
+    """two codes drawn apart in one frame"""
+    return [b if a == BACKGROUND else a for a, b in zip(first, second)]
+
+
+def moved(image, dx, dy):
+    """the frame with everything in it moved by whole pixels, the background showing where it left"""
+    rows = [image[y * WIDTH:(y + 1) * WIDTH] for y in range(HEIGHT)]
+    out = []
+    for y in range(HEIGHT):
+        if 0 <= y - dy < HEIGHT:
+            row = rows[y - dy]
+            row = [BACKGROUND] * dx + row[:WIDTH - dx] if dx >= 0 else row[-dx:] + [BACKGROUND] * -dx
+        else:
+            row = [BACKGROUND] * WIDTH
+        out.extend(row)
+    return out
+
+
+def frames(image, rng, noise):
+    """the lead-in, then the image drifting about with fresh sensor noise in every frame"""
+    empty = [BACKGROUND] * (WIDTH * HEIGHT)
+    for i in range(LEAD_IN + MOVING):
+        if i < LEAD_IN:
+            shown = empty
+        else:
+            step = i - LEAD_IN
+            shown = moved(image, abs(step % 12 - 6) - 3, abs(step // 3 % 4 - 2) - 1)
+        start = rng.randrange(len(noise) - len(shown))
+        gray = [max(0, min(255, p + n)) for p, n in zip(shown, noise[start:])]
+        yield array.array("H", ((g >> 3) << 11 | (g >> 2) << 5 | g >> 3 for g in gray))
+
+
+def write(out, name, image, expect):
+    rng = random.Random(name)
+    noise = [int(rng.gauss(0, 3)) for _ in range(WIDTH * HEIGHT * 2)]
+    with open(os.path.join(out, name + ".rgb565"), "wb") as f:
+        for frame in frames(image, rng, noise):
+            if sys.byteorder != "little":
+                frame.byteswap()
+            f.write(frame.tobytes())
+    with open(os.path.join(out, name + ".expect"), "wb") as f:
+        f.write(expect)
+
+
+def main():
+    out = sys.argv[1]
+    os.makedirs(out, exist_ok=True)
+    rng = random.Random(35)
+    data = lambda n: bytes(rng.randrange(256) for _ in range(n))
+
+    pk6 = data(232)
+    link = b"http://lunarcookies.github.io/b1s1.html#" + base64.b64encode(pk6)
+    write(out, "pk6", draw(corpus.encode(link, "M"), 3.0, (0, 0)), pk6)
+
+    # binary PK7 codes of a sheet, one copy each, two in view at once
+    sheet = []
+    for _ in range(2):
+        code = bytearray(data(0x1A2))
+        code[16:20] = (1).to_bytes(4, "little")
+        sheet.append(bytes(code))
+    # small enough that drifting about never takes a finder pattern out of the frame
+    codes = [draw(corpus.encode(code, "L", mask), 2.4, (shift, 0)) for code, shift, mask in zip(sheet, (-100, 100), (3, 4))]
+    write(out, "sheet", overlay(*codes), b"".join(code[0x30:0x30 + 232] for code in sheet))
+
+    write(out, "empty", [BACKGROUND] * (WIDTH * HEIGHT), b"")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,131 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Just enough of libctru for QRScanner to build on a PC. Events and threads run on the host's, and the
+// camera plays back a recording instead of capturing, see Replay.hpp
+
+#ifndef QR_REPLAY_3DS_H
+#define QR_REPLAY_3DS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef s32 Result;
+typedef u32 Handle;
+
+#define U64_MAX UINT64_MAX
+#define R_SUCCEEDED(res) ((res) >= 0)
+#define R_FAILED(res) ((res) < 0)
+#define CUR_THREAD_HANDLE 0xFFFF8000
+#define KEY_B (1 << 1)
+
+typedef enum
+{
+    RESET_ONESHOT = 0,
+    RESET_STICKY  = 1,
+    RESET_PULSE   = 2
+} ResetType;
+
+Result svcCreateEvent(Handle* event, ResetType resetType);
+Result svcSignalEvent(Handle handle);
+Result svcCloseHandle(Handle handle);
+Result svcWaitSynchronization(Handle handle, s64 nanoseconds);
+Result svcWaitSynchronizationN(s32* out, const Handle* handles, s32 count, bool waitAll, s64 nanoseconds);
+Result svcGetThreadPriority(s32* out, Handle handle);
+void svcSleepThread(s64 nanoseconds);
+
+typedef struct Thread_tag* Thread;
+typedef void (*ThreadFunc)(void*);
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stackSize, int prio, int core, bool detached);
+Result threadJoin(Thread thread, u64 timeoutNs);
+void threadFree(Thread thread);
+
+void hidScanInput(void);
+u32 hidKeysDown(void);
+
+typedef enum
+{
+    SELECT_NONE = 0,
+    SELECT_OUT1 = 1
+} CAMU_CameraSelect;
+
+typedef enum
+{
+    PORT_NONE = 0,
+    PORT_CAM1 = 1
+} CAMU_Port;
+
+typedef enum
+{
+    CONTEXT_A = 1
+} CAMU_Context;
+
+typedef enum
+{
+    SIZE_CTR_TOP_LCD = 8
+} CAMU_Size;
+
+typedef enum
+{
+    OUTPUT_RGB_565 = 1
+} CAMU_OutputFormat;
+
+typedef enum
+{
+    FRAME_RATE_30 = 8
+} CAMU_FrameRate;
+
+Result camInit(void);
+void camExit(void);
+static inline Result CAMU_SetSize(u32 select, CAMU_Size size, CAMU_Context context) { return 0; }
+static inline Result CAMU_SetOutputFormat(u32 select, CAMU_OutputFormat format, CAMU_Context context) { return 0; }
+static inline Result CAMU_SetFrameRate(u32 select, CAMU_FrameRate frameRate) { return 0; }
+static inline Result CAMU_SetNoiseFilter(u32 select, bool noiseFilter) { return 0; }
+static inline Result CAMU_SetAutoExposure(u32 select, bool autoExposure) { return 0; }
+static inline Result CAMU_SetAutoWhiteBalance(u32 select, bool autoWhiteBalance) { return 0; }
+static inline Result CAMU_Activate(u32 select) { return 0; }
+static inline Result CAMU_SetTrimming(u32 port, bool trimming) { return 0; }
+static inline Result CAMU_GetMaxBytes(u32* maxBytes, s16 width, s16 height) { *maxBytes = width * 2 * 4; return 0; }
+static inline Result CAMU_SetTransferBytes(u32 port, u32 bytes, s16 width, s16 height) { return 0; }
+static inline Result CAMU_ClearBuffer(u32 port) { return 0; }
+Result CAMU_GetBufferErrorInterruptEvent(Handle* event, u32 port);
+Result CAMU_SetReceiving(Handle* event, void* dst, u32 port, u32 imageSize, s16 transferUnit);
+Result CAMU_StartCapture(u32 port);
+Result CAMU_StopCapture(u32 port);
+Result CAMU_IsBusy(bool* busy, u32 port);
+
+static inline Result GSPGPU_FlushDataCache(const void* adr, u32 size) { return 0; }
+
+#endif
@@ -0,0 +1,374 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "Replay.hpp"
+#include "Stand.hpp"
+#include "gui.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdarg.h>
+#include <thread>
+
+extern "C" {
+#include "quirc_internal.h"
+}
+
+static constexpr Result RESULT_TIMEOUT = 0x09401BFE;
+static constexpr int STAMP_BITS        = 16;
+static constexpr int PATIENCE          = 30; // frames after the recording before B is pressed
+
+struct Event
+{
+    ResetType type;
+    bool signalled;
+};
+
+struct Thread_tag
+{
+    std::thread thread;
+};
+
+// one lock for everything, as a wait can be for several events at once
+static std::mutex lock;
+static std::condition_variable changed;
+static std::vector<Event> events; // Handle n is events[n - 1]
+
+static std::chrono::steady_clock::time_point started;
+static std::vector<u16> recording;
+static s64 decodeDelay;
+static Replay::Stats current;
+static std::vector<s64> captures;
+static std::thread camera;
+static bool capturing;
+static Handle receiveEvent;
+static void* receiveDst;
+
+std::shared_ptr<Sav> TitleLoader::save;
+C3D_RenderTarget* g_renderTargetTop;
+C3D_RenderTarget* g_renderTargetBottom;
+
+void Replay::start(const std::vector<u16>& frames, s64 delay)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    started     = std::chrono::steady_clock::now();
+    recording   = frames;
+    decodeDelay = delay;
+    current     = Stats();
+    captures.clear();
+}
+
+const Replay::Stats& Replay::stats(void)
+{
+    return current;
+}
+
+s64 Replay::now(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+s64 Replay::capturedAt(int frame)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return frame >= 0 && frame < (int)captures.size() ? captures[frame] : -1;
+}
+
+static int frameCount(void)
+{
+    return recording.size() / (Replay::FRAME_WIDTH * Replay::FRAME_HEIGHT);
+}
+
+Result svcCreateEvent(Handle* event, ResetType resetType)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    events.push_back({resetType, false});
+    *event = events.size();
+    return 0;
+}
+
+Result svcSignalEvent(Handle handle)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    events[handle - 1].signalled = true;
+    changed.notify_all();
+    return 0;
+}
+
+Result svcCloseHandle(Handle handle)
+{
+    return 0;
+}
+
+Result svcWaitSynchronizationN(s32* out, const Handle* handles, s32 count, bool waitAll, s64 nanoseconds)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(nanoseconds);
+    while (true)
+    {
+        for (s32 i = 0; i < count; i++)
+        {
+            if (handles[i] != 0 && events[handles[i] - 1].signalled)
+            {
+                if (events[handles[i] - 1].type == RESET_ONESHOT)
+                {
+                    events[handles[i] - 1].signalled = false;
+                }
+                *out = i;
+                return 0;
+            }
+        }
+        // U64_MAX, as libctru's callers pass it, waits for good
+        if (nanoseconds < 0)
+        {
+            changed.wait(guard);
+        }
+        else if (changed.wait_until(guard, deadline) == std::cv_status::timeout)
+        {
+            return RESULT_TIMEOUT;
+        }
+    }
+}
+
+Result svcWaitSynchronization(Handle handle, s64 nanoseconds)
+{
+    s32 index;
+    return svcWaitSynchronizationN(&index, &handle, 1, false, nanoseconds);
+}
+
+Result svcGetThreadPriority(s32* out, Handle handle)
+{
+    *out = 0x30;
+    return 0;
+}
+
+void svcSleepThread(s64 nanoseconds)
+{
+    std::this_thread::sleep_for(std::chrono::nanoseconds(nanoseconds));
+}
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stackSize, int prio, int core, bool detached)
+{
+    return new Thread_tag{std::thread(entrypoint, arg)};
+}
+
+Result threadJoin(Thread thread, u64 timeoutNs)
+{
+    thread->thread.join();
+    return 0;
+}
+
+void threadFree(Thread thread)
+{
+    delete thread;
+}
+
+void hidScanInput(void) {}
+
+u32 hidKeysDown(void)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return current.captured >= frameCount() + PATIENCE ? KEY_B : 0;
+}
+
+// takes a frame every FRAME_NS into the buffer camThread last handed over, if it did
+static void capture(void)
+{
+    for (int frame = 0;; frame++)
+    {
+        std::this_thread::sleep_until(started + std::chrono::nanoseconds(frame * Replay::FRAME_NS));
+        std::lock_guard<std::mutex> guard(lock);
+        if (!capturing)
+        {
+            break;
+        }
+        current.captured++;
+        captures.push_back(Replay::now());
+        if (receiveDst == NULL)
+        {
+            current.dropped++;
+            continue;
+        }
+
+        size_t size = Replay::FRAME_WIDTH * Replay::FRAME_HEIGHT;
+        u16* dst    = (u16*)receiveDst;
+        std::copy_n(recording.data() + std::min(frame, frameCount() - 1) * size, size, dst);
+        u16* stamp = dst + size - Replay::FRAME_WIDTH;
+        for (int bit = 0; bit < STAMP_BITS; bit++)
+        {
+            stamp[2 * bit] = stamp[2 * bit + 1] = (frame >> bit) & 1 ? 0xFFFF : 0;
+        }
+        receiveDst                         = NULL;
+        events[receiveEvent - 1].signalled = true;
+        changed.notify_all();
+    }
+}
+
+template <typename T>
+static int stampOf(const T* frame)
+{
+    const T* row = frame + (Replay::FRAME_HEIGHT - 1) * Replay::FRAME_WIDTH;
+    int stamp    = 0;
+    for (int bit = 0; bit < STAMP_BITS; bit++)
+    {
+        stamp |= (row[2 * bit] > (T)~0 / 2) << bit;
+    }
+    return stamp;
+}
+
+Result camInit(void)
+{
+    return 0;
+}
+
+void camExit(void) {}
+
+Result CAMU_GetBufferErrorInterruptEvent(Handle* event, u32 port)
+{
+    // transfers never fail here
+    return svcCreateEvent(event, RESET_ONESHOT);
+}
+
+Result CAMU_SetReceiving(Handle* event, void* dst, u32 port, u32 imageSize, s16 transferUnit)
+{
+    svcCreateEvent(event, RESET_ONESHOT);
+    std::lock_guard<std::mutex> guard(lock);
+    receiveEvent = *event;
+    receiveDst   = dst;
+    return 0;
+}
+
+Result CAMU_StartCapture(u32 port)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!capturing)
+    {
+        capturing = true;
+        camera    = std::thread(capture);
+    }
+    return 0;
+}
+
+Result CAMU_StopCapture(u32 port)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        capturing  = false;
+        receiveDst = NULL;
+    }
+    camera.join();
+    return 0;
+}
+
+Result CAMU_IsBusy(bool* busy, u32 port)
+{
+    *busy = false;
+    return 0;
+}
+
+bool C3D_TexInit(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format)
+{
+    tex->data   = malloc(width * height * sizeof(u16));
+    tex->width  = width;
+    tex->height = height;
+    return tex->data != NULL;
+}
+
+void C3D_TexDelete(C3D_Tex* tex)
+{
+    free(tex->data);
+}
+
+// waits for the next refresh of a 60 Hz screen
+bool C3D_FrameBegin(u8 flags)
+{
+    s64 refresh = 1000000000 / 60;
+    std::this_thread::sleep_for(std::chrono::nanoseconds(refresh - Replay::now() % refresh));
+    std::lock_guard<std::mutex> guard(lock);
+    current.drawn++;
+    return true;
+}
+
+void Gui::staticText(const std::string& strKey, int x, int y, float scaleX, float scaleY, u32 color, TextPosX positionX, TextPosY positionY) {}
+
+void Gui::warn(const std::string& message, std::optional<std::string> message2, std::optional<std::string> bottomScreen)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    current.warnings.push_back(message);
+}
+
+std::string i18n::localize(const std::string& key)
+{
+    return key;
+}
+
+std::string StringUtils::format(const std::string fmt_str, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, fmt_str);
+    vsnprintf(buffer, sizeof(buffer), fmt_str.c_str(), args);
+    va_end(args);
+    return buffer;
+}
+
+extern "C" {
+void __real_rgb565_to_gray(const uint16_t* src, int width, int height, int srcStride, uint8_t* dst, int downscale);
+void __real_quirc_end(struct quirc* q);
+void __real_quirc_end_roi(struct quirc* q, int x, int y, int w, int h);
+
+void __wrap_rgb565_to_gray(const uint16_t* src, int width, int height, int srcStride, uint8_t* dst, int downscale)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        current.converted.push_back(stampOf(src));
+    }
+    __real_rgb565_to_gray(src, width, height, srcStride, dst, downscale);
+}
+
+static void searching(struct quirc* q)
+{
+    int frame = stampOf(q->image);
+    s64 now   = Replay::now();
+    std::lock_guard<std::mutex> guard(lock);
+    current.searched.push_back(frame);
+    current.ages.push_back(frame < (int)captures.size() ? now - captures[frame] : -1);
+}
+
+void __wrap_quirc_end(struct quirc* q)
+{
+    searching(q);
+    __real_quirc_end(q);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(decodeDelay));
+}
+
+void __wrap_quirc_end_roi(struct quirc* q, int x, int y, int w, int h)
+{
+    searching(q);
+    __real_quirc_end_roi(q, x, y, w, h);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(decodeDelay));
+}
+}
@@ -0,0 +1,67 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Plays a recording through QRScanner in place of the camera. The camera captures at 30 fps as the 3DS's
+// does, dropping a frame if camThread hasn't set up the next transfer in time, and stamps the number of
+// each frame into its bottom row. Once the recording is over its last frame stays in view, and B is
+// pressed after another second. The conversion and search stages are watched through the linker's
+// --wrap, which reads the stamp of every frame they are handed.
+
+#ifndef QR_REPLAY_REPLAY_HPP
+#define QR_REPLAY_REPLAY_HPP
+
+#include <3ds.h>
+#include <string>
+#include <vector>
+
+namespace Replay
+{
+    static constexpr int FRAME_WIDTH  = 400;
+    static constexpr int FRAME_HEIGHT = 240;
+    static constexpr s64 FRAME_NS     = 1000000000 / 30;
+
+    struct Stats
+    {
+        int captured = 0;               // frames the camera took, with the ones it dropped
+        int dropped  = 0;               // frames taken while no transfer was set up
+        int drawn    = 0;               // screen refreshes uiThread waited for
+        std::vector<int> converted;     // the frames procThread converted, in order
+        std::vector<int> searched;      // the frames the decoder searched, in order
+        std::vector<s64> ages;          // how long after its capture each searched frame was searched
+        std::vector<std::string> warnings;
+    };
+
+    // frames holds the recording as the camera hands it over. Every search takes decodeDelay nanoseconds
+    // longer, standing in for a slower decoder
+    void start(const std::vector<u16>& frames, s64 decodeDelay);
+    const Stats& stats(void);
+    // nanoseconds since start
+    s64 now(void);
+    // when the camera took frame, or -1 if it hasn't yet
+    s64 capturedAt(int frame);
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Stand-ins for the Pokemon, wondercards and save QRScanner hands codes to. Only the sizes it checks
+// codes against are real: a Pokemon keeps its bytes as they came, still encrypted, and a slot counts as
+// empty while all of its bytes are 0
+
+#ifndef QR_REPLAY_STAND_HPP
+#define QR_REPLAY_STAND_HPP
+
+#include <3ds.h>
+#include <memory>
+#include <vector>
+
+class PKX
+{
+public:
+    PKX(const u8* dt, size_t length) : bytes(dt, dt + length) {}
+    virtual ~PKX() = default;
+
+    // every code QRScanner checks this for carries 232 bytes, which only a PK6 or PK7 has
+    static u8 genFromBytes(u8* data, size_t length, bool ekx = false) { return length == 232 ? 6 : 0; }
+    u16 species(void) const
+    {
+        for (u8 byte : bytes)
+        {
+            if (byte != 0)
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    std::vector<u8> bytes;
+};
+
+class PK6 : public PKX
+{
+public:
+    PK6(u8* dt, bool ekx = false, bool party = false) : PKX(dt, 232) {}
+};
+
+class PK7 : public PKX
+{
+public:
+    PK7(u8* dt, bool ekx = false, bool party = false) : PKX(dt, 232) {}
+};
+
+struct PGT { static const u16 length = 260; };
+struct WC4 { static const int length = 856; };
+struct PGF { static const u16 length = 204; };
+struct WC6 { static const u16 length = 264; static const u16 lengthFull = 784; };
+
+class Sav
+{
+public:
+    explicit Sav(int boxes) : slots(boxes * 30, std::vector<u8>(232)) {}
+
+    int maxBoxes(void) const { return slots.size() / 30; }
+    int maxSlot(void) const { return maxBoxes() * 30; }
+    std::unique_ptr<PKX> pkm(u8 box, u8 slot, bool ekx = false) const { return std::make_unique<PKX>(slots[box * 30 + slot].data(), 232); }
+    void pkm(PKX& pk, u8 box, u8 slot) { slots[box * 30 + slot] = pk.bytes; }
+
+    std::vector<std::vector<u8>> slots;
+};
+
+namespace TitleLoader
+{
+    extern std::shared_ptr<Sav> save;
+}
+
+#endif
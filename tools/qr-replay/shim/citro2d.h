@@ -0,0 +1,85 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Just enough of citro3d and citro2d for QRScanner's preview to build on a PC. Nothing is drawn, but
+// C3D_FrameBegin waits for the next screen refresh as the real one does, see Replay.hpp
+
+#ifndef QR_REPLAY_CITRO2D_H
+#define QR_REPLAY_CITRO2D_H
+
+#include "3ds.h"
+
+#define C3D_FRAME_SYNCDRAW (1 << 0)
+
+typedef enum
+{
+    GPU_RGB565 = 3
+} GPU_TEXCOLOR;
+
+typedef enum
+{
+    GPU_LINEAR = 1
+} GPU_TEXTURE_FILTER_PARAM;
+
+typedef struct
+{
+    void* data;
+    u16 width;
+    u16 height;
+} C3D_Tex;
+
+typedef struct C3D_RenderTarget_tag C3D_RenderTarget;
+
+typedef struct
+{
+    u16 width;
+    u16 height;
+    float left;
+    float top;
+    float right;
+    float bottom;
+} Tex3DS_SubTexture;
+
+typedef struct
+{
+    C3D_Tex* tex;
+    const Tex3DS_SubTexture* subtex;
+} C2D_Image;
+
+typedef struct C2D_ImageTint C2D_ImageTint;
+
+bool C3D_TexInit(C3D_Tex* tex, u16 width, u16 height, GPU_TEXCOLOR format);
+void C3D_TexDelete(C3D_Tex* tex);
+static inline void C3D_TexSetFilter(C3D_Tex* tex, GPU_TEXTURE_FILTER_PARAM magFilter, GPU_TEXTURE_FILTER_PARAM minFilter) {}
+bool C3D_FrameBegin(u8 flags);
+static inline void C3D_FrameEnd(u8 flags) {}
+
+static inline u32 C2D_Color32(u8 r, u8 g, u8 b, u8 a) { return r | (g << 8) | (b << 16) | (a << 24); }
+static inline void C2D_SceneBegin(C3D_RenderTarget* target) {}
+static inline bool C2D_DrawImageAt(C2D_Image img, float x, float y, float depth, const C2D_ImageTint* tint, float scaleX, float scaleY) { return true; }
+static inline bool C2D_DrawRectSolid(float x, float y, float z, float w, float h, u32 clr) { return true; }
+
+#endif
@@ -0,0 +1,80 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Gui for QRScanner on a PC: the bottom screen's text goes nowhere, and warnings are kept for main.cpp
+// to check, see Replay.hpp. QRScanner.hpp finds the real gui.hpp next to it before this one, so the
+// Makefile includes this one first and it takes the real one's guard
+
+#ifndef GUI_HPP
+#define GUI_HPP
+
+#include <3ds.h>
+#include <citro2d.h>
+#include <algorithm>
+#include <optional>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define COLOR_WHITE     C2D_Color32(255, 255, 255, 255)
+#define COLOR_MASKBLACK C2D_Color32(  0,   0,   0, 190)
+#define FONT_SIZE_18 0.72f
+
+enum class TextPosX
+{
+    LEFT,
+    CENTER,
+    RIGHT
+};
+
+enum class TextPosY
+{
+    TOP,
+    CENTER,
+    BOTTOM
+};
+
+extern C3D_RenderTarget* g_renderTargetTop;
+extern C3D_RenderTarget* g_renderTargetBottom;
+
+namespace Gui
+{
+    void staticText(const std::string& strKey, int x, int y, float scaleX, float scaleY, u32 color, TextPosX positionX, TextPosY positionY);
+    void warn(const std::string& message, std::optional<std::string> message2 = std::nullopt, std::optional<std::string> bottomScreen = std::nullopt);
+}
+
+namespace i18n
+{
+    std::string localize(const std::string& key);
+}
+
+namespace StringUtils
+{
+    std::string format(const std::string fmt_str, ...);
+}
+
+#endif
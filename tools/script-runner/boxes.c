@@ -0,0 +1,103 @@
+/* A box generation script like the ones PKSM's users run: builds a Pokemon in every one of a Sun/Moon
+ * save's 960 box slots, then checks them. script-runner runs it against work/fixture.sav */
+
+#include <pksm.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PKX_LENGTH 232
+
+static void set16(char *pkx, int offset, int value)
+{
+    *(unsigned short *)(pkx + offset) = value;
+}
+
+static void set32(char *pkx, int offset, unsigned int value)
+{
+    *(unsigned int *)(pkx + offset) = value;
+}
+
+static int get16(char *pkx, int offset)
+{
+    return *(unsigned short *)(pkx + offset);
+}
+
+static int checksum(char *pkx)
+{
+    int sum = 0;
+    int i;
+    for (i = 8; i < PKX_LENGTH; i += 2)
+        sum += get16(pkx, i);
+    return sum & 0xFFFF;
+}
+
+/* the UTF-16 name, at most 12 characters */
+static void setName(char *pkx, int offset, char *name)
+{
+    int i;
+    for (i = 0; i < 12 && name[i] != '\0'; i++)
+        set16(pkx, offset + i * 2, name[i]);
+}
+
+static void build(char *pkx, int index)
+{
+    char nickname[13];
+    int species = index % 802 + 1;
+    memset(pkx, 0, PKX_LENGTH);
+    set32(pkx, 0x00, 0x10000 + index);      /* encryption constant */
+    set16(pkx, 0x08, species);
+    set16(pkx, 0x0C, cfg_default_tid());
+    set16(pkx, 0x0E, cfg_default_sid());
+    set32(pkx, 0x18, 0x20000 + index);      /* PID */
+    pkx[0x1C] = index % 25;                 /* nature */
+    sprintf(nickname, "Mon %d", index + 1);
+    setName(pkx, 0x40, nickname);
+    set16(pkx, 0x5A, 33);                   /* Tackle */
+    pkx[0x62] = 35;
+    set32(pkx, 0x74, 0x3FFFFFFF);           /* 31 in every IV */
+    setName(pkx, 0xB0, cfg_default_ot());
+    pkx[0xCA] = 70;                         /* friendship */
+    pkx[0xDC] = 4;                          /* Poke Ball */
+    pkx[0xDD] = 1;                          /* met at level 1 */
+    pkx[0xDF] = 30;                         /* from Sun */
+    pkx[0xE3] = 2;                          /* English */
+    set16(pkx, 0x06, checksum(pkx));
+}
+
+int main(int argc, char **argv)
+{
+    char pkx[PKX_LENGTH];
+    int slots[960];
+    int index;
+    int found;
+    int version = argv[2][0];
+
+    if (version != 30 && version != 31)
+    {
+        gui_warn("This script is for Sun and Moon", NULL);
+        return 1;
+    }
+
+    sav_box_decrypt();
+    for (index = 0; index < 960; index++)
+    {
+        build(pkx, index);
+        sav_inject_pkx(pkx, GEN_SEVEN, index / 30, index % 30);
+    }
+
+    found = sav_find_slots(slots, 960, 0);
+    for (index = 0; index < 960; index += 37)
+    {
+        sav_get_pkx(pkx, index / 30, index % 30);
+        if (get16(pkx, 0x08) != index % 802 + 1 || get16(pkx, 0x06) != checksum(pkx))
+            found = -1;
+    }
+    sav_box_encrypt();
+
+    if (found != 960)
+    {
+        gui_warn("Some slots weren't filled", NULL);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+/* Runs a picoc script the way ScriptScreen does, keeping the interpreter between runs, and times every
+ * run. Runs after the first go straight to main() unless the script can't be kept, see
+ * PicocPlatformPrepareFile().
+ *
+ *     script-runner [-n runs] [-s save.sav [-o out.sav]] [-i answers] [-p profile] script.c [args...]
+ *     script-runner --fixture out.sav
+ *
+ * With -s the script gets PKSM's functions and ScriptScreen's arguments for that Sun/Moon save, reloaded
+ * before every run, instead of args; -o writes the save back out after the last run. Gui prompts take
+ * the lines of the answers file in turn, see shim/Headless.hpp. -p writes the last run's profile to
+ * profile.folded and profile.profile.txt, when built with PICOC_PROFILE. --fixture writes a save to run
+ * scripts against, its first box filled.
+ *
+ * Exits non-zero if any run fails or returns anything but 0. */
+
+#include "Headless.hpp"
+#include "loader.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+
+// after the C++ headers, because picoc defines min and max
+extern "C" {
+#include "picoc.h"
+}
+
+// as PICOC_STACKSIZE in ScriptScreen.hpp
+#define STACK_SIZE (32 * 1024)
+
+static double seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n runs] [-s save.sav [-o out.sav]] [-i answers] [-p profile] script.c [args...]\n"
+                    "       %s --fixture out.sav\n", name, name);
+    return 2;
+}
+
+int main(int argc, char **argv)
+{
+    static Picoc pc;
+    const char *savePath = NULL, *outPath = NULL, *profile = NULL;
+    int runs = 1, first = 1, failed = 0;
+    if (argc == 3 && strcmp(argv[1], "--fixture") == 0) {
+        if (!Headless::writeFixture(argv[2])) {
+            fprintf(stderr, "can't write %s\n", argv[2]);
+            return 1;
+        }
+        return 0;
+    }
+    for (; first + 1 < argc && argv[first][0] == '-' && argv[first][2] == '\0'; first += 2) {
+        const char *value = argv[first + 1];
+        switch (argv[first][1]) {
+            case 'n':
+                runs = atoi(value);
+                break;
+            case 's':
+                savePath = value;
+                break;
+            case 'o':
+                outPath = value;
+                break;
+            case 'i':
+                if (!Headless::loadAnswers(value)) {
+                    fprintf(stderr, "can't read %s\n", value);
+                    return 1;
+                }
+                break;
+            case 'p':
+                profile = value;
+                break;
+            default:
+                return usage(argv[0]);
+        }
+    }
+    if (first >= argc || runs < 1 || (outPath && !savePath))
+        return usage(argv[0]);
+#ifndef PICOC_PROFILE
+    if (profile) {
+        fprintf(stderr, "%s: built without PICOC_PROFILE, use script-profiler\n", argv[0]);
+        return 2;
+    }
+#endif
+
+    double best = 0.0;
+    for (int run = 1; run <= runs; run++) {
+        // as ScriptScreen::parsePicoCScript passes them
+        std::string data, length;
+        char version[2] = {0};
+        char *saveArgs[3];
+        if (savePath) {
+            if (!Headless::loadSave(savePath)) {
+                fprintf(stderr, "can't load %s as a Sun/Moon save\n", savePath);
+                return 1;
+            }
+            data = std::to_string((int)(intptr_t)TitleLoader::save->rawData());
+            length = std::to_string(TitleLoader::save->length);
+            version[0] = TitleLoader::save->version();
+            saveArgs[0] = data.data();
+            saveArgs[1] = length.data();
+            saveArgs[2] = version;
+        }
+
+        double start = seconds();
+        bool kept = PicocPlatformPrepareFile(&pc, argv[first], STACK_SIZE);
+        if (!PicocPlatformSetExitPoint(&pc)) {
+            if (savePath)
+                PicocPlatformRunFile(&pc, argv[first], 3, saveArgs);
+            else
+                PicocPlatformRunFile(&pc, argv[first], argc - first - 1, argv + first + 1);
+        }
+        double time = seconds() - start;
+        int exitValue = pc.PicocExitValue;
+#ifdef PICOC_PROFILE
+        if (profile && run == runs)
+            PicocProfileWrite(&pc, (std::string(profile) + ".folded").c_str(), (std::string(profile) + ".profile.txt").c_str());
+#endif
+        fflush(stdout);
+        fprintf(stderr, "%s run %d: %.1f ms%s%s\n", argv[first], run, time * 1e3, kept ? ", kept" : "", exitValue ? ", failed" : "");
+        failed |= exitValue != 0;
+        best = run == 1 || time < best ? time : best;
+    }
+    PicocPlatformReleaseFile(&pc);
+    if (runs > 1)
+        fprintf(stderr, "%s best of %d: %.1f ms\n", argv[first], runs, best * 1e3);
+    if (outPath && !Headless::writeSave(outPath)) {
+        fprintf(stderr, "can't write %s\n", outPath);
+        return 1;
+    }
+    return failed;
+}
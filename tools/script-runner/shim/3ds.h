@@ -0,0 +1,90 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Just enough of libctru for PKSM's script functions to build on a PC. The software keyboard reads the
+// answers given to script-runner instead
+
+#ifndef SCRIPT_RUNNER_3DS_H
+#define SCRIPT_RUNNER_3DS_H
+
+#include "3ds/types.h"
+#include <stdbool.h>
+
+#define R_SUCCEEDED(res) ((res) >= 0)
+#define R_FAILED(res) ((res) < 0)
+
+typedef struct
+{
+    u16 px;
+    u16 py;
+} touchPosition;
+
+typedef enum
+{
+    SWKBD_TYPE_NORMAL = 0,
+    SWKBD_TYPE_QWERTY,
+    SWKBD_TYPE_NUMPAD,
+    SWKBD_TYPE_WESTERN
+} SwkbdType;
+
+typedef enum
+{
+    SWKBD_ANYTHING = 0,
+    SWKBD_NOTEMPTY,
+    SWKBD_NOTEMPTY_NOTBLANK,
+    SWKBD_NOTBLANK_NOTEMPTY = SWKBD_NOTEMPTY_NOTBLANK,
+    SWKBD_NOTBLANK,
+    SWKBD_FIXEDLEN
+} SwkbdValidInput;
+
+typedef enum
+{
+    SWKBD_BUTTON_LEFT = 0,
+    SWKBD_BUTTON_MIDDLE,
+    SWKBD_BUTTON_RIGHT,
+    SWKBD_BUTTON_CONFIRM = SWKBD_BUTTON_RIGHT,
+    SWKBD_BUTTON_NONE
+} SwkbdButton;
+
+typedef struct
+{
+    SwkbdType type;
+    int maxLength;
+} SwkbdState;
+
+static inline void swkbdInit(SwkbdState* state, SwkbdType type, int numButtons, int maxTextLength)
+{
+    state->type = type;
+    state->maxLength = maxTextLength;
+}
+static inline void swkbdSetHintText(SwkbdState* state, const char* text) {}
+static inline void swkbdSetValidation(SwkbdState* state, SwkbdValidInput validInput, u32 filterFlags, int maxDigits) {}
+static inline void swkbdSetButton(SwkbdState* state, SwkbdButton button, const char* text, bool submit) {}
+SwkbdButton swkbdInputText(SwkbdState* state, char* buf, size_t bufsize);
+
+static inline void C3D_FrameEnd(u8 flags) {}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// The settings PKSM's script functions read, fixed to PKSM's defaults
+
+#ifndef SCRIPT_RUNNER_CONFIGURATION_HPP
+#define SCRIPT_RUNNER_CONFIGURATION_HPP
+
+#include "i18n.hpp"
+#include <string>
+
+class Configuration
+{
+public:
+    static Configuration& getInstance(void)
+    {
+        static Configuration config;
+        return config;
+    }
+
+    Language language(void) const { return Language::EN; }
+    u32 defaultTID(void) const { return 12345; }
+    u32 defaultSID(void) const { return 54321; }
+    std::string defaultOT(void) const { return ot; }
+    int day(void) { return 1; }
+    int month(void) { return 1; }
+    int year(void) { return 2019; }
+
+private:
+    std::string ot = "PKSM";
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "Headless.hpp"
+#include "BoxChoice.hpp"
+#include "citro2d.h"
+#include "loader.hpp"
+#include "random.hpp"
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unordered_map>
+
+namespace
+{
+    std::deque<std::string> answers;
+
+    // Scripts get the save's address as an int, so it has to be somewhere an int can hold it
+    u8* saveBuffer(void)
+    {
+        static u8* buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            void* mapped = mmap(nullptr, Sav::SM_LENGTH, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+            buffer = mapped == MAP_FAILED ? nullptr : (u8*)mapped;
+        }
+        return buffer;
+    }
+}
+
+std::shared_ptr<Sav> TitleLoader::save;
+// as app.cpp has it, but seeded the same every time so runs can be compared
+std::mt19937 randomNumbers;
+
+bool Headless::loadAnswers(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        answers.push_back(line);
+    }
+    return !in.bad() && (in.eof() || in.good());
+}
+
+std::string Headless::answer(const std::string& what, const std::string& fallback)
+{
+    std::string ret = fallback;
+    if (!answers.empty())
+    {
+        ret = answers.front();
+        answers.pop_front();
+    }
+    fprintf(stderr, "%s: %s\n", what.c_str(), ret.c_str());
+    return ret;
+}
+
+void Headless::show(const std::string& what)
+{
+    fprintf(stderr, "%s\n", what.c_str());
+}
+
+bool Headless::loadSave(const std::string& path)
+{
+    u8* data = saveBuffer();
+    FILE* in = fopen(path.c_str(), "rb");
+    if (data == nullptr || in == nullptr)
+    {
+        if (in)
+        {
+            fclose(in);
+        }
+        return false;
+    }
+    size_t read = fread(data, 1, Sav::SM_LENGTH, in);
+    fclose(in);
+    if (read != Sav::SM_LENGTH)
+    {
+        return false;
+    }
+    TitleLoader::save = std::make_shared<Sav>(data);
+    return true;
+}
+
+bool Headless::writeFixture(const std::string& path)
+{
+    u8* data = saveBuffer();
+    if (data == nullptr)
+    {
+        return false;
+    }
+    std::fill_n(data, Sav::SM_LENGTH, 0);
+    TitleLoader::save = std::make_shared<Sav>(data);
+    // box 1 holds Bulbasaur to Nidoran, stored encrypted as a real save stores them; the rest are empty
+    for (u8 slot = 0; slot < 30; slot++)
+    {
+        PK7 pk7;
+        pk7.encryptionConstant(0x1000 + slot);
+        pk7.PID(0x2000 + slot);
+        pk7.species(slot + 1);
+        pk7.TID(12345);
+        pk7.SID(54321);
+        pk7.otName("PKSM");
+        pk7.language(Language::EN);
+        pk7.nickname(i18n::species(Language::EN, slot + 1).c_str());
+        pk7.level(5);
+        pk7.move(0, 33);
+        pk7.ball(4);
+        pk7.refreshChecksum();
+        pk7.encrypt();
+        TitleLoader::save->pkm(pk7, 0, slot);
+    }
+    for (u8 box = 0; box < TitleLoader::save->maxBoxes(); box++)
+    {
+        for (u8 slot = box == 0 ? 30 : 0; slot < 30; slot++)
+        {
+            PK7 empty;
+            empty.encrypt();
+            TitleLoader::save->pkm(empty, box, slot);
+        }
+    }
+    return writeSave(path);
+}
+
+bool Headless::writeSave(const std::string& path)
+{
+    FILE* out = fopen(path.c_str(), "wb");
+    if (out == nullptr)
+    {
+        return false;
+    }
+    bool written = fwrite(TitleLoader::save->rawData(), 1, TitleLoader::save->length, out) == TitleLoader::save->length;
+    return fclose(out) == 0 && written;
+}
+
+bool Gui::showChoiceMessage(const std::string& message, std::optional<std::string> message2, int timer)
+{
+    return Headless::answer("choice: " + message + (message2 ? " " + *message2 : ""), "1") != "0";
+}
+
+void Gui::warn(const std::string& message, std::optional<std::string> message2, std::optional<std::string> bottomScreen)
+{
+    Headless::show("warning: " + message + (message2 ? " " + *message2 : "") + (bottomScreen ? " " + *bottomScreen : ""));
+}
+
+int ScriptChoice::run(void)
+{
+    int choice = std::atoi(Headless::answer("menu: " + question, "0").c_str());
+    return choice < items ? choice : -1;
+}
+
+std::tuple<int, int, int> BoxChoice::run(void)
+{
+    std::istringstream in(Headless::answer("boxes", "0 0 1"));
+    int storage = 0, box = -1, slot = -1;
+    in >> storage >> box >> slot;
+    return {storage, box, slot};
+}
+
+SwkbdButton swkbdInputText(SwkbdState* state, char* buf, size_t bufsize)
+{
+    std::string text = Headless::answer(state->type == SWKBD_TYPE_NUMPAD ? "numpad" : "keyboard", state->type == SWKBD_TYPE_NUMPAD ? "1" : "PKSM");
+    size_t length = std::min(text.size(), std::min(bufsize - 1, (size_t)state->maxLength));
+    std::copy_n(text.begin(), length, buf);
+    buf[length] = '\0';
+    return SWKBD_BUTTON_CONFIRM;
+}
+
+void Bank::pkm(PKX& pkm, int box, int slot)
+{
+    Headless::show("bank: species " + std::to_string(pkm.species()) + " to box " + std::to_string(box + 1) + " slot " + std::to_string(slot + 1));
+}
+
+const std::string& i18n::species(u8 lang, u16 value)
+{
+    static std::unordered_map<u16, std::string> names;
+    return names.emplace(value, "Species " + std::to_string(value)).first->second;
+}
+
+const std::string& i18n::localize(const std::string& index)
+{
+    static std::unordered_map<std::string, std::string> strings;
+    return strings.emplace(index, index).first->second;
+}
+
+// every glyph is as wide as every other
+int fontGlyphIndexFromCodePoint(u32 codePoint)
+{
+    return codePoint;
+}
+
+charWidthInfo_s* fontGetCharWidthInfo(int glyphIndex)
+{
+    static charWidthInfo_s info = {0, 8, 8};
+    return &info;
+}
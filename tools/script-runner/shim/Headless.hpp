@@ -0,0 +1,50 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// What stands in for the 3DS while a script runs headless: every prompt takes the next answer given to
+// script-runner, or a default once they run out, and everything that would be shown is printed instead
+
+#ifndef SCRIPT_RUNNER_HEADLESS_HPP
+#define SCRIPT_RUNNER_HEADLESS_HPP
+
+#include <string>
+
+namespace Headless
+{
+    // adds the answers in a file, one per line
+    bool loadAnswers(const std::string& path);
+    // the next answer for a prompt, or fallback if there are none left. what is printed along with it
+    std::string answer(const std::string& what, const std::string& fallback);
+    void show(const std::string& what);
+
+    // loads an SM save as TitleLoader::save, or writes a fixture one to path with the first box filled
+    bool loadSave(const std::string& path);
+    bool writeFixture(const std::string& path);
+    // writes TitleLoader::save back out
+    bool writeSave(const std::string& path);
+}
+
+#endif
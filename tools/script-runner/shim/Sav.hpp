@@ -0,0 +1,114 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// A Sun/Moon save for PKSM's script functions on a PC: the boxes and party laid out as SavSUMO lays them
+// out, and the limits SavSUMO reports. Nothing else in the save is read or written
+
+#ifndef SCRIPT_RUNNER_SAV_HPP
+#define SCRIPT_RUNNER_SAV_HPP
+
+#include "PK7.hpp"
+#include "generation.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+class Sav
+{
+protected:
+    u8* data;
+
+public:
+    static constexpr u32 SM_LENGTH = 0x6BE00;
+
+    u8 boxes = 32;
+    u32 length = SM_LENGTH;
+
+    // data must be length bytes and outlive the save
+    Sav(u8* data) : data(data) {}
+    virtual ~Sav() {}
+
+    u8 version(void) const { return 30; }
+    Generation generation(void) const { return Generation::SEVEN; }
+    u8 gender(void) const { return 0; }
+    u8 subRegion(void) const { return 0; }
+    u8 country(void) const { return 0; }
+    u8 consoleRegion(void) const { return 0; }
+    std::string otName(void) const { return "PKSM"; }
+
+    u32 boxOffset(u8 box, u8 slot) const { return 0x4E00 + 232*30*box + 232*slot; }
+    u32 partyOffset(u8 slot) const { return 0x1400 + 260*slot; }
+
+    std::unique_ptr<PKX> pkm(u8 slot) const
+    {
+        u8 buf[260];
+        std::copy(data + partyOffset(slot), data + partyOffset(slot) + 260, buf);
+        return std::make_unique<PK7>(buf, true, true);
+    }
+    std::unique_ptr<PKX> pkm(u8 box, u8 slot, bool ekx = false) const
+    {
+        u8 buf[232];
+        std::copy(data + boxOffset(box, slot), data + boxOffset(box, slot) + 232, buf);
+        return std::make_unique<PK7>(buf, ekx);
+    }
+    void pkm(PKX& pk, u8 box, u8 slot) { std::copy(pk.rawData(), pk.rawData() + 232, data + boxOffset(box, slot)); }
+    void cryptBoxData(bool crypted)
+    {
+        for (u8 box = 0; box < boxes; box++)
+        {
+            for (u8 slot = 0; slot < 30; slot++)
+            {
+                std::unique_ptr<PKX> pk7 = pkm(box, slot, crypted);
+                if (!crypted)
+                {
+                    pk7->encrypt();
+                }
+                pkm(*pk7, box, slot);
+            }
+        }
+    }
+    u8* rawData(void) const { return data; }
+
+    int maxSlot(void) const { return maxBoxes() * 30; }
+    int maxBoxes(void) const { return boxes; }
+    int maxSpecies(void) const { return 802; }
+    int maxMove(void) const { return 720; }
+    int maxItem(void) const { return 920; }
+    int maxAbility(void) const { return 232; }
+    int maxBall(void) const { return 0x1A; }
+};
+
+// only ever cast to for a version that isn't SM's
+class SavHGSS : public Sav
+{
+public:
+    int getSBO(void) const { return 0; }
+    int getGBO(void) const { return 0; }
+};
+class SavDP : public SavHGSS {};
+class SavPT : public SavHGSS {};
+
+#endif
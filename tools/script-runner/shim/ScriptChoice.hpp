@@ -0,0 +1,73 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// The script menus on a PC: each one takes its choice from Headless::answer
+
+#ifndef SCRIPT_RUNNER_SCRIPTCHOICE_HPP
+#define SCRIPT_RUNNER_SCRIPTCHOICE_HPP
+
+#include "3ds.h"
+#include "generation.hpp"
+#include <string>
+#include <tuple>
+
+struct pkm {
+    int species;
+    int form;
+};
+
+class ScriptChoice
+{
+public:
+    ScriptChoice(char* question, int items) : question(question), items(items) {}
+    // the chosen index, or -1 if the menu was cancelled
+    int run(void);
+
+private:
+    std::string question;
+    int items;
+};
+
+class ThirtyChoice : public ScriptChoice
+{
+public:
+    ThirtyChoice(char* question, char** text, pkm* pokemon, int items, Generation gen = Generation::SEVEN) : ScriptChoice(question, items) {}
+};
+
+class FortyChoice : public ScriptChoice
+{
+public:
+    FortyChoice(char* question, char** text, int items) : ScriptChoice(question, items) {}
+};
+
+class BoxChoice
+{
+public:
+    // from storage, box and slot as "storage box slot", slot counting from 1
+    std::tuple<int, int, int> run(void);
+};
+
+#endif
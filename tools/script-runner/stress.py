@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Writes the stress scripts "make run" times into the given folder. Each one checks its own result and
+# returns 1 if it's wrong:
+#   globals.c - 5000 globals, read over and over, which is what used to turn the global table into chains
+#   buffers.c - 3000 globals, a 1 MiB global array, a 4 MiB malloc()ed buffer and 200 KB local arrays four
+#               calls deep, far more than the 32 KiB script stack holds
+
+import os
+import sys
+
+folder = sys.argv[1]
+os.makedirs(folder, exist_ok=True)
+
+def globals_decl(count):
+    return ''.join('int g%d = %d;\n' % (i, i) for i in range(count))
+
+with open(os.path.join(folder, 'globals.c'), 'w') as out:
+    count, rounds = 5000, 200
+    read = range(0, count, 10)
+    out.write('#include <stdio.h>\n')
+    out.write(globals_decl(count))
+    out.write('int main()\n{\n    int total = 0;\n    int k;\n')
+    out.write('    for (k = 0; k < %d; k++)\n        total += %s;\n' % (rounds, ' + '.join('g%d' % i for i in read)))
+    out.write('    printf("%%d\\n", total);\n    return total != %d;\n}\n' % (rounds * sum(read)))
+
+with open(os.path.join(folder, 'buffers.c'), 'w') as out:
+    count, local, depth, calls = 3000, 200000, 3, 5
+    read = range(0, count, 7)
+    image = 1 << 20
+    heap = 4 << 20
+    # fill(n) sets a local array to n and sums every 1000th byte, then recurses down to fill(0). The big
+    # buffers are written every 64th byte so the interpreter's loop doesn't swamp the time
+    fill = sum(n * len(range(0, local, 1000)) for n in range(depth + 1))
+    expected = sum(read) + calls * fill + sum(i * 7 & 0xFF for i in range(0, image, 4096)) + sum(i >> 12 & 0xFF for i in range(0, heap, 65536))
+    out.write('#include <stdio.h>\n#include <stdlib.h>\n#include <string.h>\n')
+    out.write(globals_decl(count))
+    out.write('unsigned char image[%d];\n\n' % image)
+    out.write('''int fill(int n)
+{
+    unsigned char big[%d];
+    int i;
+    int sum = 0;
+    memset(big, n, %d);
+    for (i = 0; i < %d; i += 1000) sum += big[i];
+    if (n > 0) sum += fill(n - 1);
+    return sum;
+}
+
+''' % (local, local, local))
+    out.write('int main()\n{\n    int total = 0;\n    int i;\n    unsigned char *buffer = malloc(%d);\n' % heap)
+    out.write('    total = %s;\n' % ' + '.join('g%d' % i for i in read))
+    out.write('    for (i = 0; i < %d; i++) total += fill(%d);\n' % (calls, depth))
+    out.write('    for (i = 0; i < %d; i += 64) image[i] = i * 7;\n' % image)
+    out.write('    for (i = 0; i < %d; i += 4096) total += image[i];\n' % image)
+    out.write('    for (i = 0; i < %d; i += 64) buffer[i] = i >> 12;\n' % heap)
+    out.write('    for (i = 0; i < %d; i += 65536) total += buffer[i];\n' % heap)
+    out.write('    free(buffer);\n    printf("%%d\\n", total);\n    return total != %d;\n}\n' % expected)
@@ -0,0 +1,106 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Just enough of libctru for source/io/spi.cpp to build on a PC against flash.cpp
+
+#ifndef SPI_EMULATOR_3DS_H
+#define SPI_EMULATOR_3DS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef s32 Result;
+
+#define R_SUCCEEDED(res) ((res) >= 0)
+#define R_FAILED(res) ((res) < 0)
+
+typedef enum
+{
+    BAUDRATE_512KHZ = 0,
+    BAUDRATE_1MHZ,
+    BAUDRATE_2MHZ,
+    BAUDRATE_4MHZ,
+    BAUDRATE_8MHZ,
+    BAUDRATE_16MHZ
+} FS_CardSpiBaudRate;
+
+typedef enum
+{
+    BUSMODE_1BIT = 0,
+    BUSMODE_4BIT
+} FS_CardSpiBusMode;
+
+typedef enum
+{
+    DEASSERT_NONE = 0,
+    DEASSERT_BEFORE_WAIT,
+    DEASSERT_AFTER_WAIT
+} PXIDEV_DeassertType;
+
+typedef enum
+{
+    WAIT_NONE = 0,
+    WAIT_SLEEP,
+    WAIT_IREQ_RETURN,
+    WAIT_IREQ_CONTINUE
+} PXIDEV_WaitType;
+
+typedef struct
+{
+    void* ptr;
+    u32 size;
+    u8 transferOption;
+    u64 waitOperation;
+} PXIDEV_SPIBuffer;
+
+static inline u8 pxiDevMakeTransferOption(FS_CardSpiBaudRate baudRate, FS_CardSpiBusMode busMode)
+{
+    return (baudRate & 0x3F) | ((busMode & 0x3) << 6);
+}
+
+static inline u64 pxiDevMakeWaitOperation(PXIDEV_WaitType waitType, PXIDEV_DeassertType deassertType, u64 timeout)
+{
+    return (waitType & 0xF) | ((deassertType & 0xF) << 4) | ((timeout & 0x3FFFFFFFFFFFFFULL) << 8);
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+Result PXIDEV_SPIMultiWriteRead(PXIDEV_SPIBuffer* header, PXIDEV_SPIBuffer* writeBuffer1, PXIDEV_SPIBuffer* readBuffer1,
+    PXIDEV_SPIBuffer* writeBuffer2, PXIDEV_SPIBuffer* readBuffer2, PXIDEV_SPIBuffer* footer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#include "flash.hpp"
+#include "spi.hpp"
+#include <stdio.h>
+#include <string.h>
+
+static std::vector<u8> chip;
+static Flash::Stats counters;
+static int writesUntilFailure = -1;
+static u8 status = 0;
+
+std::vector<u8>& Flash::memory(void)
+{
+    return chip;
+}
+
+Flash::Stats& Flash::stats(void)
+{
+    return counters;
+}
+
+void Flash::resetStats(void)
+{
+    counters = {};
+}
+
+void Flash::failAfter(int count)
+{
+    writesUntilFailure = count;
+}
+
+static u32 address(const u8* cmd)
+{
+    return (cmd[1] << 16) | (cmd[2] << 8) | cmd[3];
+}
+
+extern "C" Result PXIDEV_SPIMultiWriteRead(PXIDEV_SPIBuffer*, PXIDEV_SPIBuffer* cmdBuffer, PXIDEV_SPIBuffer* answerBuffer,
+    PXIDEV_SPIBuffer* dataBuffer, PXIDEV_SPIBuffer*, PXIDEV_SPIBuffer*)
+{
+    counters.transactions++;
+    const u8* cmd = (const u8*)cmdBuffer->ptr;
+    switch (cmd[0])
+    {
+        case SPI_CMD_RDSR:
+            *(u8*)answerBuffer->ptr = status;
+            return 0;
+        case SPI_CMD_WREN:
+            status |= SPI_FLG_WEL;
+            return 0;
+        case SPI_FLASH_CMD_RDID:
+            memset(answerBuffer->ptr, 0, answerBuffer->size);
+            return 0;
+        case SPI_CMD_READ:
+        {
+            u32 pos = address(cmd);
+            if (pos + answerBuffer->size > chip.size())
+            {
+                return -1;
+            }
+            memcpy(answerBuffer->ptr, &chip[pos], answerBuffer->size);
+            return 0;
+        }
+        case SPI_FLASH_CMD_PW:
+        {
+            u32 pos = address(cmd);
+            if (!(status & SPI_FLG_WEL))
+            {
+                fprintf(stderr, "page write at 0x%06X without WREN\n", (unsigned)pos);
+                return -1;
+            }
+            status &= ~SPI_FLG_WEL;
+            // a real chip wraps within the page, which would corrupt the save
+            if ((pos % 256) + dataBuffer->size > 256 || pos + dataBuffer->size > chip.size())
+            {
+                fprintf(stderr, "page write at 0x%06X of %u bytes crosses a page\n", (unsigned)pos, (unsigned)dataBuffer->size);
+                return -1;
+            }
+            if (writesUntilFailure == 0)
+            {
+                return 0xC8E13404;
+            }
+            if (writesUntilFailure > 0)
+            {
+                writesUntilFailure--;
+            }
+            memcpy(&chip[pos], dataBuffer->ptr, dataBuffer->size);
+            counters.pageWrites++;
+            counters.bytesWritten += dataBuffer->size;
+            return 0;
+        }
+        default:
+            fprintf(stderr, "unknown SPI command 0x%02X\n", cmd[0]);
+            return -1;
+    }
+}
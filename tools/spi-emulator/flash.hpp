@@ -0,0 +1,52 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+#ifndef SPI_EMULATOR_FLASH_HPP
+#define SPI_EMULATOR_FLASH_HPP
+
+#include "3ds.h"
+#include <vector>
+
+// An in-memory save flash chip behind PXIDEV_SPIMultiWriteRead. It understands the commands spi.cpp sends
+// to flash chips and keeps count of them, so a test can see how much a write really touched
+namespace Flash
+{
+    struct Stats
+    {
+        u32 transactions;
+        u32 pageWrites;
+        u32 bytesWritten;
+    };
+
+    // the chip's contents. Its size is the chip's capacity
+    std::vector<u8>& memory(void);
+    Stats& stats(void);
+    void resetStats(void);
+    // makes the page write after the next count succeed fail, or never when count is negative
+    void failAfter(int count);
+}
+
+#endif
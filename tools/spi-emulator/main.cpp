@@ -0,0 +1,126 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Checks SPIWriteChangedSaveData against the emulated flash chip: only changed pages are written, the shadow
+// ends up matching the chip, and a failed write is reported. Exits non-zero if anything doesn't hold.
+
+#include "flash.hpp"
+#include "spi.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr CardType TYPE = FLASH_512KB_1;
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+static u32 progressDone, progressTotal;
+static void progress(u32 done, u32 total)
+{
+    progressDone = done;
+    progressTotal = total;
+}
+
+int main(void)
+{
+    std::vector<u8>& chip = Flash::memory();
+    chip.resize(SPIGetCapacity(TYPE));
+    srand(1);
+    for (auto& byte : chip)
+    {
+        byte = rand();
+    }
+
+    // a save edited in a few places, including the first and last bytes of pages
+    std::vector<u8> shadow(chip), save(chip);
+    for (int i = 0; i < 40; i++)
+    {
+        save[rand() % save.size()] ^= 0x5A;
+    }
+    save[0] ^= 1;
+    save[255] ^= 1;
+    save[256] ^= 1;
+    save[save.size() - 1] ^= 1;
+    u32 changedPages = 0;
+    for (u32 pos = 0; pos < save.size(); pos += 256)
+    {
+        changedPages += !std::equal(save.begin() + pos, save.begin() + pos + 256, chip.begin() + pos);
+    }
+
+    Flash::resetStats();
+    auto start = std::chrono::steady_clock::now();
+    Result res = SPIWriteChangedSaveData(TYPE, save.data(), shadow.data(), save.size(), progress);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    check(res == 0, "changed pages are written");
+    check(chip == save, "chip holds the save");
+    check(shadow == save, "shadow matches the chip");
+    check(Flash::stats().pageWrites == changedPages, "only changed pages are written");
+    check(progressTotal == changedPages * 256 && progressDone == progressTotal, "progress covers the changed bytes");
+    printf("     %u of %u pages, %u SPI transactions, %.2f ms\n", (unsigned)Flash::stats().pageWrites, (unsigned)(save.size() / 256),
+        (unsigned)Flash::stats().transactions, ms);
+
+    Flash::resetStats();
+    res = SPIWriteChangedSaveData(TYPE, save.data(), shadow.data(), save.size(), progress);
+    check(res == 0 && Flash::stats().pageWrites == 0, "an unchanged save writes nothing");
+
+    for (auto& byte : save)
+    {
+        byte = ~byte;
+    }
+    Flash::resetStats();
+    res = SPIWriteChangedSaveData(TYPE, save.data(), shadow.data(), save.size(), progress);
+    check(res == 0 && chip == save && Flash::stats().pageWrites == save.size() / 256, "a fully changed save writes every page");
+
+    // the write stops at the failure. Runs written before it are in the shadow, the rest are still different
+    for (auto& byte : save)
+    {
+        byte = ~byte;
+    }
+    Flash::failAfter(20);
+    res = SPIWriteChangedSaveData(TYPE, save.data(), shadow.data(), save.size(), progress);
+    Flash::failAfter(-1);
+    check(R_FAILED(res), "a failed page write is reported");
+    check(chip != save, "the chip is left partly written");
+    bool shadowHonest = true;
+    for (u32 pos = 0; pos < save.size(); pos += 256)
+    {
+        bool shadowSaysWritten = std::equal(save.begin() + pos, save.begin() + pos + 256, shadow.begin() + pos);
+        bool chipWritten = std::equal(save.begin() + pos, save.begin() + pos + 256, chip.begin() + pos);
+        shadowHonest &= !shadowSaysWritten || chipWritten;
+    }
+    check(shadowHonest, "the shadow never claims a page the chip doesn't hold");
+
+    return failures == 0 ? 0 : 1;
+}
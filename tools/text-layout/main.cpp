@@ -0,0 +1,208 @@
+/*
+*   This file is part of PKSM
+*   Copyright (C) 2016-2019 Bernardo Giordano, Admiral Fish, piepie62
+*
+*   This program is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*   Additional Terms 7.b and 7.c of GPLv3 apply to this file:
+*       * Requiring preservation of specified reasonable legal notices or
+*         author attributions in that material or in the Appropriate Legal
+*         Notices displayed by works containing it.
+*       * Prohibiting misrepresentation of the origin of that material,
+*         or requiring that modified versions of such material be marked in
+*         reasonable ways as different from the original version.
+*/
+
+// Checks that StringUtils and TextLayout measure text the same way against a made up glyph width table,
+// and that splitWord and wrap break lines where they should. Exits non-zero if anything doesn't hold.
+
+#include "textLayout.hpp"
+#include "utils.hpp"
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok)
+    {
+        failures++;
+    }
+}
+
+// every codepoint gets its own glyph, with a width that depends on what sort of character it is
+static std::unordered_map<u32, charWidthInfo_s> glyphs;
+static int lookups = 0;
+
+int fontGlyphIndexFromCodePoint(u32 codePoint)
+{
+    return codePoint;
+}
+
+charWidthInfo_s* fontGetCharWidthInfo(int glyphIndex)
+{
+    lookups++;
+    u8 width = glyphIndex == 0xFFFF ? 9 : glyphIndex < 0x80 ? 4 + glyphIndex % 7 : glyphIndex >= 0x3000 ? 12 : 6 + glyphIndex % 5;
+    charWidthInfo_s& info = glyphs[glyphIndex];
+    info = {0, width, width};
+    return &info;
+}
+
+static float glyphWidth(uint16_t codepoint)
+{
+    return fontGetCharWidthInfo(fontGlyphIndexFromCodePoint(codepoint))->charWidth;
+}
+
+static bool decodes(const std::string& text, uint16_t codepoint, size_t last)
+{
+    size_t i = 0;
+    return TextLayout::nextCodepoint(text, i) == codepoint && i == last;
+}
+
+static std::vector<std::string> lines(const std::string& text)
+{
+    std::vector<std::string> split(1);
+    for (char c : text)
+    {
+        if (c == '\n')
+        {
+            split.emplace_back();
+        }
+        else
+        {
+            split.back() += c;
+        }
+    }
+    return split;
+}
+
+static const std::vector<std::string> corpus = {
+    "",
+    "Pikachu",
+    "Flabébé\nÉvoli",
+    "ピカチュウ と イーブイ",
+    "피카츄\n\n이브이",
+    "皮卡丘 Pikachu ピカチュウ",
+    "Nidoran♀ Nidoran♂",
+    "emoji 😀 takes four bytes",
+    "cut short \xE3\x81",
+    "stray \x81\xBF continuation bytes",
+    "ends in a lead byte \xC3",
+};
+
+int main(void)
+{
+    check(decodes("A", 'A', 0) && decodes("\xC3\xA9", 0xE9, 1) && decodes("\xE3\x81\x82", 0x3042, 2),
+        "one, two and three byte sequences decode");
+    check(decodes("\xF0\x9F\x98\x80", 0xFFFF, 0) && decodes("\xE3\x81", 0xFFFF, 0) && decodes("\xC3", 0xFFFF, 0) &&
+              decodes("\x81", 0xFFFF, 0),
+        "four byte, cut short and stray bytes are 0xFFFF and take one byte");
+
+    bool same = true, sameWide = true;
+    std::vector<TextLayout::Line> layout;
+    for (auto& text : corpus)
+    {
+        for (float scale : {0.5f, 1.0f, 0.7f})
+        {
+            TextLayout::layout(layout, text, scale, TextPosX::LEFT, glyphWidth);
+            float widest = 0.0f;
+            for (auto& line : layout)
+            {
+                widest = std::max(widest, line.width);
+            }
+            same = same && StringUtils::textWidth(text, scale) == widest;
+        }
+        if (text.find_first_of("\xF0\x81\xC3") == std::string::npos && text.find("\xE3\x81") + 2 != text.size())
+        {
+            sameWide = sameWide && StringUtils::textWidth(StringUtils::UTF8toUTF16(text), 1.0f) == StringUtils::textWidth(text, 1.0f);
+        }
+    }
+    check(same, "textWidth is the widest line TextLayout::layout finds");
+    check(sameWide, "textWidth agrees for UTF-8 and UTF-16");
+
+    lookups = 0;
+    for (auto& text : corpus)
+    {
+        StringUtils::textWidth(text, 1.0f);
+    }
+    check(lookups == 0, "widths which have been looked up once are remembered");
+
+    bool whole = true, fits = true, full = true, onBoundary = true;
+    for (auto& text : corpus)
+    {
+        // where each character nextCodepoint reads starts
+        std::vector<bool> starts(text.size() + 1, false);
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            starts[i] = true;
+            TextLayout::nextCodepoint(text, i);
+        }
+        for (float maxWidth : {30.0f, 45.0f, 100.0f})
+        {
+            std::string split = StringUtils::splitWord(text, 1.0f, maxWidth);
+            std::string joined;
+            size_t offset = 0, lineStart = 0;
+            for (size_t i = 0; i < split.size(); i++)
+            {
+                bool inserted = split[i] == '\n' && (offset == text.size() || text[offset] != '\n');
+                if (!inserted)
+                {
+                    joined += split[i];
+                    offset++;
+                    lineStart = split[i] == '\n' ? i + 1 : lineStart;
+                    continue;
+                }
+                onBoundary = onBoundary && starts[offset];
+                // the line before didn't have room for the character after
+                size_t next = i + 1;
+                float width = StringUtils::textWidth(split.substr(lineStart, i - lineStart), 1.0f);
+                full = full && width + glyphWidth(TextLayout::nextCodepoint(split, next)) > maxWidth;
+                lineStart = i + 1;
+            }
+            whole = whole && joined == text;
+            for (auto& line : lines(split))
+            {
+                fits = fits && StringUtils::textWidth(line, 1.0f) <= maxWidth;
+            }
+        }
+    }
+    check(whole, "splitWord only inserts line breaks");
+    check(fits, "every line splitWord makes fits");
+    check(full, "splitWord only breaks a line when the next character doesn't fit");
+    check(onBoundary, "splitWord only breaks where a character starts");
+
+    bool wrapped = true, truncated = true;
+    std::string sentence = "The quick brown Flabébé jumps over the lazy ピカチュウ and keeps on running for a while";
+    for (float maxWidth : {60.0f, 90.0f, 150.0f})
+    {
+        for (auto& line : lines(StringUtils::wrap(sentence, 1.0f, maxWidth)))
+        {
+            wrapped = wrapped && StringUtils::textWidth(line, 1.0f) <= maxWidth;
+        }
+        auto cut = lines(StringUtils::wrap(sentence, 1.0f, maxWidth, 2));
+        truncated = truncated && cut.size() <= 2 && cut.back().size() >= 3 && cut.back().compare(cut.back().size() - 3, 3, "...") == 0;
+        for (auto& line : cut)
+        {
+            truncated = truncated && StringUtils::textWidth(line, 1.0f) <= maxWidth;
+        }
+    }
+    check(wrapped, "wrap keeps every line within the width");
+    check(truncated, "wrap to two lines fits them and ends in an ellipsis");
+
+    printf("%d failures\n", failures);
+    return failures != 0;
+}